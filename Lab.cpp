@@ -1,14 +1,75 @@
+// Build: g++ -std=c++20 -O2 -pthread Lab.cpp -o airline
+// Benchmarks need room for the generated data, e.g.
+//   g++ -std=c++20 -O2 -pthread -DAIRLINE_MAX_BOOKINGS=10000000
+//       -DAIRLINE_MAX_FLIGHTS=100000 -DAIRLINE_MAX_PASSENGERS=1000000 Lab.cpp -o airline-bench
+//   ./airline-bench --bench --scale 1000000
+// Load testing: ./airline --loadgen --profile booking --threads 4 --trace run.trace
+// Sessions recorded with ./airline --record FILE replay with ./airline --replay FILE --speed 10
+// Sharded: ./airline --shard-router 4 /var/lib/airline (commands on stdin, see SHARDED DEPLOYMENT)
+// Replicas: ./airline --journal primary.journal, then ./airline --replica primary.journal replica.sock
+// Booking sessions: ./airline --sessions --journal airline.journal (protocol on stdin, see BOOKING SESSIONS),
+//   load test with ./airline-bench --session-load --sessions 50000 --threads 4
+// Audit log: ./airline --audit-verify airline_audit.log, ./airline --audit-query airline_audit.log --flight 101
+// Booking archive: ./airline --archive-dump bookings_archive.dat
 #include<iostream>
 #include<string>
 #include <cstring>
 #include <cstdlib>
 #include <iomanip>
 #include <ctime>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <climits>
+#include <limits>
+#include <cstddef>
+#include <cmath>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <charconv>
+#include <string_view>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <coroutine>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 using namespace std;
 
-const int MAX_PASSENGERS = 100;
-const int MAX_FLIGHTS = 100;
-const int MAX_BOOKINGS = 100;
+// Store capacities can be raised at build time
+#ifndef AIRLINE_MAX_PASSENGERS
+#define AIRLINE_MAX_PASSENGERS 100
+#endif
+#ifndef AIRLINE_MAX_FLIGHTS
+#define AIRLINE_MAX_FLIGHTS 100
+#endif
+#ifndef AIRLINE_MAX_BOOKINGS
+#define AIRLINE_MAX_BOOKINGS 100
+#endif
+
+const int MAX_PASSENGERS = AIRLINE_MAX_PASSENGERS;
+const int MAX_FLIGHTS = AIRLINE_MAX_FLIGHTS;
+const int MAX_BOOKINGS = AIRLINE_MAX_BOOKINGS;
 
 struct Date {
     int day;
@@ -20,6 +81,94 @@ struct Time {
     int minute;
 };
 
+// Flight lifecycle. Whether a flight still has seats is derived from
+// availableSeats rather than stored as a status.
+enum FlightStatus : unsigned char {
+    FLIGHT_SCHEDULED,
+    FLIGHT_BOARDING,
+    FLIGHT_DEPARTED,
+    FLIGHT_ARRIVED,
+    FLIGHT_DELAYED,
+    FLIGHT_CANCELLED,
+    FLIGHT_STATUS_COUNT
+};
+
+enum BookingStatus : unsigned char {
+    BOOKING_CONFIRMED,
+    BOOKING_IN_FLIGHT,
+    BOOKING_COMPLETED,
+    BOOKING_CANCELLED,
+    BOOKING_STATUS_COUNT
+};
+
+const char* const FLIGHT_STATUS_NAMES[FLIGHT_STATUS_COUNT] = {
+    "Scheduled", "Boarding", "Departed", "Arrived", "Delayed", "Cancelled"
+};
+const char* const BOOKING_STATUS_NAMES[BOOKING_STATUS_COUNT] = {
+    "Confirmed", "In Flight", "Completed", "Cancelled"
+};
+
+// Cabin classes. Everything that differs between cabins is in this table:
+// flights keep seats and fares per entry and bookings store the entry's
+// index, so a new cabin such as Premium Economy is one more line here.
+struct CabinClass {
+    const char* name;          // as stored in traces and typed in protocols
+    const char* shortName;     // column heading
+    const char* label;         // as shown to passengers
+    float fareMultiplier;      // times the distance fare
+    float milesMultiplier;     // loyalty miles per km flown
+};
+
+constexpr CabinClass CABIN_CLASSES[] = {
+    {"Economy",  "Eco",   "Economy",     1.0f, 1.0f},
+    {"Business", "Bus",   "Business",    2.0f, 1.5f},
+    {"First",    "First", "First Class", 3.5f, 2.0f},
+};
+constexpr int CABIN_COUNT = sizeof(CABIN_CLASSES) / sizeof(CABIN_CLASSES[0]);
+constexpr unsigned char CABIN_NONE = 0xff;
+
+constexpr bool sameName(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+// The table index of a cabin name, or CABIN_NONE
+constexpr unsigned char cabinCode(const char* name) {
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        if (sameName(CABIN_CLASSES[c].name, name)) return (unsigned char)c;
+    }
+    return CABIN_NONE;
+}
+
+// Cabins the code refers to directly, resolved when compiling
+constexpr unsigned char CABIN_ECONOMY = cabinCode("Economy");
+static_assert(CABIN_ECONOMY != CABIN_NONE, "the cabin table needs an Economy entry");
+
+inline const char* cabinName(unsigned char cabin) {
+    return cabin < CABIN_COUNT ? CABIN_CLASSES[cabin].name : "?";
+}
+
+// Allowed transitions, indexed [from][to]
+constexpr bool FLIGHT_TRANSITIONS[FLIGHT_STATUS_COUNT][FLIGHT_STATUS_COUNT] = {
+    //            Sched  Board  Dep    Arr    Delay  Cancel
+    /* Sched  */ {false, true,  false, false, true,  true },
+    /* Board  */ {false, false, true,  false, true,  true },
+    /* Dep    */ {false, false, false, true,  false, false},
+    /* Arr    */ {false, false, false, false, false, false},
+    /* Delay  */ {true,  true,  false, false, false, true },
+    /* Cancel */ {false, false, false, false, false, false},
+};
+constexpr bool BOOKING_TRANSITIONS[BOOKING_STATUS_COUNT][BOOKING_STATUS_COUNT] = {
+    //               Conf   InFl   Compl  Cancel
+    /* Confirmed */ {false, true,  true,  true },
+    /* In Flight */ {false, false, true,  false},
+    /* Completed */ {false, false, false, false},
+    /* Cancelled */ {false, false, false, false},
+};
+
 struct Passenger {
     int id;
     char name[50];
@@ -28,55 +177,221 @@ struct Passenger {
     char phone[15];
     int totalBookings;
     float totalSpent;
+    int lifetimeMiles;
+    int rollingMiles;          // miles in the 12 months up to loyaltyWindowMonth
+    int monthlyMiles[12];      // ring buffer indexed by month key % 12
+    int loyaltyWindowMonth;    // month key (year * 12 + month - 1) of the newest ring slot
+    int firstBooking;          // oldest booking of this passenger in bookings[], -1 if none
+    int lastBooking;           // newest, where the next booking is linked on
 };
 
+// Cities are interned in cityNames (see CITY NAMES) and flights carry the
+// two-byte index, so route text stays out of the records the scans walk.
+// ID 0 is the empty name, which is what a zeroed record shows.
+typedef unsigned short CityId;
+const CityId CITY_NONE = 0xffff;
+
+// Dates in booking records are packed to days since 1 January 2000
+typedef unsigned short PackedDate;
+
+// Fields are ordered by use: lookups, availability checks and bookings touch
+// only the first cache line, reports and edits reach into the rest.
 struct Flight {
     int flightNo;
-    char destination[50];
-    char origin[50];
+    FlightStatus status;
+    bool deleted;
+    CityId origin;
+    CityId destination;
+    int availableSeats;
+    int classSeats[CABIN_COUNT];     // seats left per cabin
+    float classFares[CABIN_COUNT];   // fare per km per cabin
+    double baseFare;
+    float distance;
+    int firstBooking;   // head of this flight's booking list in bookings[], -1 if none
     Date departureDate;
     Time departureTime;
-    Date arrivalDate;
-    Time arrivalTime;
-    int economySeats;
-    int businessSeats;
-    int firstClassSeats;
-    float economyFare;
-    float businessFare;
-    float firstClassFare;
+    
     int totalSeats;
-    int availableSeats;
-    float distance;
-    char status[20];
     int timesBooked;
     float totalRevenue;
-    double baseFare;
+    Date arrivalDate;
+    Time arrivalTime;
 };
+static_assert(offsetof(Flight, firstBooking) + sizeof(int) <= 64,
+              "the fields every booking touches must share the first cache line");
 
+// Only what booking, cancellation and the listing scans read, so two
+// bookings share a cache line. Fields the scans never touch live beside
+// bookings[] in arrays indexed by the same slot (bookingPartitionLinks,
+// bookingMiles).
 struct Booking {
     int bookingId;
     int passengerId;
     int flightNo;
-    Date bookingDate;
-    Date travelDate;
-    int seatsBooked;
-    char classType[20];
-    float farePaid;
-    char status[20]; 
+    int fareCents;          // amount paid, in cents
+    int nextOnFlight;       // next booking of the same flight, -1 at the end
+    PackedDate travelDate;
+    PackedDate bookingDate;
+    unsigned short seatsBooked;
+    unsigned char cabin;    // index into CABIN_CLASSES
+    BookingStatus status;
+    bool archived;          // moved to the cold archive, the slot is free for reuse
 };
+static_assert(sizeof(Booking) <= 32, "a booking must stay within half a cache line");
+const int MAX_SEATS_PER_BOOKING = USHRT_MAX;
 
 // Global arrays
 Passenger passengers[MAX_PASSENGERS];
 Flight flights[MAX_FLIGHTS];
 Booking bookings[MAX_BOOKINGS];
+int bookingPartitionLinks[MAX_BOOKINGS];   // next booking of the same travel day, -1 at the end
+int bookingMiles[MAX_BOOKINGS];            // loyalty miles credited for the booking in the slot
+int bookingPassengerLinks[MAX_BOOKINGS];   // next booking of the same passenger, -1 at the end
+int flightHeldSeats[MAX_FLIGHTS][CABIN_COUNT];   // seats held by booking sessions, by flight slot and cabin
 
 
 // Global counters
 int passengerCount = 0;
-int flightCount = 0;
-int bookingCount = 0;
+int flightCount = 0;        // slots ever used in flights[] (deleted slots included)
+int liveFlightCount = 0;    // flights that are not deleted
+int bookingCount = 0;        // slots ever used in bookings[] (archived slots included)
+int liveBookingCount = 0;    // bookings still in the hot store
 int currentPassengerId = -1;
 
+// Flight store: deleted slots are tombstoned and recycled through a free list,
+// and flight numbers are hashed to slots so lookups never scan the array.
+constexpr int indexSizeFor(int capacity) {
+    int size = 1;
+    while (size < 2 * capacity) size *= 2;
+    return size;
+}
+
+const int FLIGHT_INDEX_SIZE = indexSizeFor(MAX_FLIGHTS);  // power of two, at least 2 * MAX_FLIGHTS
+const int INDEX_EMPTY = 0;
+const int INDEX_TOMBSTONE = -1;
+
+int freeFlightSlots[MAX_FLIGHTS];
+int freeFlightSlotCount = 0;
+int flightIndexKeys[FLIGHT_INDEX_SIZE];   // flight numbers, or INDEX_EMPTY / INDEX_TOMBSTONE
+int flightIndexSlots[FLIGHT_INDEX_SIZE];
+
+// Writers to the stores serialize on storeMutex. Flight readers never take it:
+// they copy a flight and retry if flightStoreEpoch moved (it is odd while a
+// writer is publishing), so they never see a half-applied change.
+mutex storeMutex;
+atomic<unsigned> flightStoreEpoch(0);
+
+// Hot bookings are partitioned by travel day (packedDayNumber), kept in date
+// order so a range of travel dates is a lower_bound plus a walk over the days
+// in it. A background sweep completes the bookings of days that have passed
+// since it last ran and moves whole past months to the cold archive file,
+// recycling their slots.
+struct BookingPartition {
+    int firstBooking;   // head of the partition's list in bookings[]
+    int size;
+};
+
+// The archive outlives any one build, so it never holds raw structs: a header
+// (ARCHIVE_MAGIC, format version, record size) followed by fixed-width
+// little-endian records, field by field. Dates are civil day numbers, not
+// PackedDate, so a change to the packed epoch cannot reinterpret old records.
+// Readers skip trailing bytes they do not know, so fields may only be appended.
+// Each shard worker archives to its own file; replicas do not archive at all.
+string bookingArchivePath = "bookings_archive.dat";   // empty to keep past months hot
+const char ARCHIVE_MAGIC[8] = {'A', 'I', 'R', 'A', 'R', 'C', 'H', '\0'};
+const int ARCHIVE_FORMAT_VERSION = 1;
+const int ARCHIVE_HEADER_BYTES = 16;
+const int ARCHIVE_RECORD_BYTES = 32;
+const int SWEEP_INTERVAL_SECONDS = 60;
+
+map<int, BookingPartition> bookingPartitions;
+int completedThroughDay = INT_MIN;   // bookings travelling before this day have been completed
+
+// Live flights ordered by departure (minutes since the civil epoch, then slot),
+// so "departing in the next six hours" is a range scan. Guarded by storeMutex.
+set<pair<long long, int>> departureIndex;
+
+// A group booking holds one seat per traveller on every leg of the journey.
+// Each seat is an ordinary booking row paid for by the lead passenger, so
+// travellers can be cancelled one at a time while the rest keep their seats.
+struct GroupLeg {
+    int flightNo;
+    unsigned char cabin;
+};
+
+struct GroupBooking {
+    int groupId;
+    int leadPassengerId;
+    vector<GroupLeg> legs;
+    vector<string> travellers;
+    vector<int> memberBookingIds;   // traveller * legs.size() + leg
+    vector<int> memberSlots;        // slot of each member booking in bookings[]
+};
+
+const int MAX_GROUP_TRAVELLERS = 500;
+map<int, GroupBooking> groupBookings;   // guarded by storeMutex
+bool bookingPartitionsNeedRefile = false;   // set when travel dates move between days
+int freeBookingSlots[MAX_BOOKINGS];
+int freeBookingSlotCount = 0;
+
+// Refund tiers per fare class, plus one for flights the airline cancels
+struct RefundTier {
+    int minDaysBefore;      // tier applies when travel is at least this many days away
+    float refundFraction;
+};
+
+const int MAX_REFUND_TIERS = 8;
+const int REFUND_TABLE_DAYS = 366;     // tiers further out than this are clamped
+// One policy per cabin, in table order, then the involuntary one
+const int INVOLUNTARY_REFUND_POLICY = CABIN_COUNT;
+const int REFUND_POLICY_COUNT = CABIN_COUNT + 1;
+
+inline const char* refundPolicyName(int policy) {
+    return policy < CABIN_COUNT ? CABIN_CLASSES[policy].label : "Cancelled by airline";
+}
+
+struct RefundPolicy {
+    int tierCount;
+    RefundTier tiers[MAX_REFUND_TIERS];     // sorted by minDaysBefore, descending
+};
+
+RefundPolicy refundPolicies[REFUND_POLICY_COUNT];
+float refundFractionTable[REFUND_POLICY_COUNT][REFUND_TABLE_DAYS + 2];
+
+// Bulk schedule changes. Each update carries the fields named in its mask.
+enum FlightUpdateField {
+    UPDATE_DEPARTURE = 1,
+    UPDATE_ARRIVAL = 2,
+    UPDATE_SEATS = 4,       // new seat capacity per class
+    UPDATE_FARES = 8,
+    UPDATE_DISTANCE = 16,
+    UPDATE_STATUS = 32,
+    UPDATE_ROUTE = 64
+};
+
+struct FlightUpdate {
+    int flightNo;
+    int fields;
+    Date departureDate;
+    Time departureTime;
+    Date arrivalDate;
+    Time arrivalTime;
+    int classSeats[CABIN_COUNT];
+    float classFares[CABIN_COUNT];
+    float distance;
+    FlightStatus status;
+    char origin[50];
+    char destination[50];
+};
+
+// What removing or cancelling flights did to their bookings. The cascade runs
+// under storeMutex, so callers report it once the store is unlocked.
+struct RemovalOutcome {
+    int moved = 0;
+    int cancelled = 0;
+    float totalRefund = 0.0;
+};
+
 // Function prototypes
 void viewAvailableFlights();
 void bookFlight();
@@ -87,13 +402,30 @@ void PassengerRegistration();
 void mainMenu();
 bool isValidDate(const Date& date);
 bool isFutureDate(const Date& date);
-float calculateFare(const Flight& flight, int seats, const string& classType);
+float calculateFare(const Flight& flight, int seats, unsigned char cabin);
 int generateBookingId();
 
 
-Booking* findBookingById(int bookingId, int& index);
+bool findBookingById(int bookingId, Booking& out, int& index);
 Flight* findFlightByNumber(int flightNo, int& index);
+Passenger* findPassengerById(int passengerId);
 float calculateRefundAmount(const Booking& booking);
+void initRefundPolicies();
+void calculateRefundsBatch(const int daysBefore[], const unsigned char policies[],
+                           const float fares[], float refunds[], int count);
+void configureRefundPolicy();
+int travelMonthKey(const Date& date);
+int loyaltyTier(const Passenger& passenger);
+int currentRollingMiles(const Passenger& passenger);
+int tierForMiles(int miles);
+float applyTierDiscount(float fare, int tier);
+float applyLoyaltyDiscount(float fare, int passengerId);
+void accrueBookingMiles(int slot, const Flight& flight);
+void reverseBookingMiles(int slot);
+string renderMetrics();
+void viewMetrics();
+bool startMetricsServer(int port);
+void stopMetricsServer();
 void displayPassengerBookings();
 void cancelBooking();
 void generatePersonalReport();
@@ -101,17 +433,688 @@ void generatePersonalReport();
 // Admin functions
 void adminMenu();
 void adminLoginPanel();
-void addFlight(Flight flights[], int &flightCount);
-void viewFlights(Flight flights[], int flightCount);
-void updateFlight(Flight flights[], int flightCount);
-void deleteFlight(Flight flights[], int &flightCount);
+void addFlight();
+void viewFlights();
+void updateFlight();
+void deleteFlight();
 void viewAllBookings();
+void printBookingListingHeader(ostream& out);
+void printBookingListingRow(ostream& out, const Booking& booking);
+void viewPassengerDetails();
+void queryFlightListing();
+void queryBookingListing();
+void viewDeparturesBoard();
+
+// Flight store
+int allocateFlightSlot();
+void indexFlight(int flightNo, int slot);
+void removeFlight(int slot);
+long long departureMinute(const Flight& flight);
+int findDepartingFlights(long long fromMinute, long long toMinute, int flightNos[], int maxResults);
+void cascadeFlightRemoval(Flight& removed, RemovalOutcome& outcome);
+void printRemovalOutcome(const RemovalOutcome& outcome);
+bool snapshotFlight(int flightNo, Flight& out);
+int insertBooking(const Booking& booking);
+int findPassengerBookingSlot(int passengerId, int bookingId);
+int commitBooking(Booking& booking, string& error, bool seatsHeld = false);
+bool holdSeats(int flightNo, unsigned char cabin, int seats, string& error);
+void releaseSeatHold(int flightNo, unsigned char cabin, int seats);
+bool commitCancellation(int index, int bookingId, float refundAmount, string& error);
+int commitGroupBooking(int passengerId, const vector<GroupLeg>& legs, const vector<string>& travellers, string& error);
+bool commitGroupCancellation(int groupId, int passengerId, const vector<int>& travellers, float& totalRefund, string& error);
+void groupBookFlight();
+void manageGroupBooking();
+bool isOpenForBooking(const Flight& flight);
+bool occupiesSeats(const Booking& booking);
+bool deleteFlightRecord(int flightNo, RemovalOutcome* outcome = nullptr);
+int addFlightRecord(const Flight& record);
+int addPassengerRecord(const char* name, const char* password, const char* email, const char* phone);
+int findBookableFlights(const char* origin, const char* destination, int flightNos[], int maxResults);
+bool parseFlightStatus(const string& name, FlightStatus& status);
+bool setFlightStatus(int flightNo, FlightStatus next, string& error, RemovalOutcome* outcome = nullptr);
+void fanOutFlightStatus(Flight& flight, FlightStatus previous, RemovalOutcome& outcome);
+void updateFlightStatus();
+void sweepBookingPartitions();
+void startCompletionSweep();
+void stopCompletionSweep();
+bool applyFlightUpdates(const FlightUpdate updates[], int count, string& error, RemovalOutcome* outcome = nullptr);
+void bulkScheduleUpdate();
 
+// Record encoding
+CityId internCity(const char* name);
+CityId findCity(const char* name);
+const char* cityName(CityId city);
+PackedDate packDate(const Date& date);
+Date unpackDate(PackedDate date);
+int packedDayNumber(PackedDate date);
+int toCents(double amount);
+float fromCents(int cents);
 
 // Add these prototypes
 void generateBookingReceipt(int bookingId);
+void renderReceipt(ostream& out, const Booking& booking, const Flight& flight, const Passenger& passenger);
 void viewFlightDetailsWithSeats();
-void displayFareBreakdown(const Flight& flight, int seats, const string& classType);
+void displayFareBreakdown(ostream& out, const Flight& flight, int seats, unsigned char cabin);
+
+// ========== METRICS ==========
+
+// Operations with a latency histogram, plus plain event counters
+enum Metric {
+    METRIC_BOOK,
+    METRIC_CANCEL,
+    METRIC_SEARCH,
+    METRIC_QUOTE,
+    METRIC_RECEIPT,
+    TIMED_METRIC_COUNT
+};
+enum Counter {
+    COUNTER_FLIGHT_LOOKUPS,
+    COUNTER_FLIGHT_LOOKUP_PROBES,
+    COUNTER_BOOKING_FAILURES,
+    COUNTER_COUNT
+};
+
+const char* const METRIC_NAMES[TIMED_METRIC_COUNT] = {"book", "cancel", "search", "quote", "receipt"};
+const char* const COUNTER_NAMES[COUNTER_COUNT] = {"flight_lookups", "flight_lookup_probes", "booking_failures"};
+
+// Log-linear buckets as in HDR histograms: values below 16 ns get a bucket
+// each, above that every power of two is split into 16 sub-buckets, so a
+// bucket's width is at most 1/16 of its value.
+const int HISTOGRAM_SUB_BITS = 4;
+const int HISTOGRAM_SUB_BUCKETS = 1 << HISTOGRAM_SUB_BITS;
+const int HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+// One per thread. Only the owning thread writes, so updates are plain relaxed
+// load/store pairs with no locked instructions; readers sum all threads.
+struct ThreadMetrics {
+    atomic<unsigned long long> counters[COUNTER_COUNT];
+    atomic<unsigned long long> totalNs[TIMED_METRIC_COUNT];
+    atomic<unsigned long long> buckets[TIMED_METRIC_COUNT][HISTOGRAM_BUCKETS];
+};
+
+mutex metricsRegistryMutex;
+vector<unique_ptr<ThreadMetrics>> metricsRegistry;
+ThreadMetrics retiredMetrics;   // totals of threads that have exited, guarded by metricsRegistryMutex
+
+// Folds an exiting thread's block into retiredMetrics, so the totals stay
+// monotonic, and drops it from the registry.
+void retireThreadMetrics(ThreadMetrics* block) {
+    lock_guard<mutex> lock(metricsRegistryMutex);
+    auto add = [](atomic<unsigned long long>& into, const atomic<unsigned long long>& from) {
+        into.store(into.load(memory_order_relaxed) + from.load(memory_order_relaxed), memory_order_relaxed);
+    };
+    for (int c = 0; c < COUNTER_COUNT; c++) add(retiredMetrics.counters[c], block->counters[c]);
+    for (int m = 0; m < TIMED_METRIC_COUNT; m++) {
+        add(retiredMetrics.totalNs[m], block->totalNs[m]);
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) add(retiredMetrics.buckets[m][b], block->buckets[m][b]);
+    }
+    for (size_t i = 0; i < metricsRegistry.size(); i++) {
+        if (metricsRegistry[i].get() == block) {
+            swap(metricsRegistry[i], metricsRegistry.back());
+            metricsRegistry.pop_back();
+            break;
+        }
+    }
+}
+
+struct ThreadMetricsRegistration {
+    ThreadMetrics* block = nullptr;
+    ~ThreadMetricsRegistration() {
+        if (block) retireThreadMetrics(block);
+    }
+};
+
+ThreadMetrics& threadMetrics() {
+    thread_local ThreadMetrics* local = nullptr;
+    if (!local) {
+        // Constructed on first use only, so the fast path stays a pointer test
+        thread_local ThreadMetricsRegistration registration;
+        lock_guard<mutex> lock(metricsRegistryMutex);
+        metricsRegistry.emplace_back(new ThreadMetrics());
+        local = metricsRegistry.back().get();
+        registration.block = local;
+    }
+    return *local;
+}
+
+inline void bumpRelaxed(atomic<unsigned long long>& cell, unsigned long long amount) {
+    cell.store(cell.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+inline int histogramBucket(unsigned long long ns) {
+    if (ns < HISTOGRAM_SUB_BUCKETS) return (int)ns;
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (exponent - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+    return (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+// Smallest value that falls in a bucket
+unsigned long long histogramBucketFloor(int bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) return bucket;
+    int exponent = bucket / HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BITS - 1;
+    unsigned long long sub = bucket % HISTOGRAM_SUB_BUCKETS;
+    return (1ULL << exponent) | (sub << (exponent - HISTOGRAM_SUB_BITS));
+}
+
+inline void countEvent(Counter counter, unsigned long long amount = 1) {
+    bumpRelaxed(threadMetrics().counters[counter], amount);
+}
+
+inline void recordLatency(Metric metric, unsigned long long ns) {
+    ThreadMetrics& local = threadMetrics();
+    bumpRelaxed(local.buckets[metric][histogramBucket(ns)], 1);
+    bumpRelaxed(local.totalNs[metric], ns);
+}
+
+// Records the lifetime of the enclosing scope under a metric
+class MetricTimer {
+public:
+    explicit MetricTimer(Metric metric) : metric(metric), start(chrono::steady_clock::now()) {}
+    ~MetricTimer() {
+        recordLatency(metric, chrono::duration_cast<chrono::nanoseconds>(
+                                  chrono::steady_clock::now() - start).count());
+    }
+private:
+    Metric metric;
+    chrono::steady_clock::time_point start;
+};
+
+// ========== REQUEST ARENAS ==========
+
+// A booking request (search, quote, book, receipt) keeps its temporaries in
+// the calling thread's arena: a fixed buffer handed out front to back by a
+// monotonic resource and rewound in one step when the request ends. Strings
+// and streams on the path allocate from it, so once a thread has served a
+// request the path makes no global heap allocation. A request that outgrows
+// the buffer carries on with heap blocks, which the rewind also returns.
+const size_t REQUEST_ARENA_BYTES = 64 * 1024;
+
+struct RequestArena {
+    alignas(max_align_t) char buffer[REQUEST_ARENA_BYTES];
+    pmr::monotonic_buffer_resource resource{buffer, sizeof(buffer)};
+    int openScopes = 0;
+};
+
+RequestArena& requestArena() {
+    thread_local RequestArena arena;
+    return arena;
+}
+
+pmr::memory_resource* requestMemory() {
+    return &requestArena().resource;
+}
+
+typedef pmr::string ArenaString;
+
+// Marks one request on this thread. Scopes nest; the arena is rewound when
+// the outermost closes, so nothing allocated from it may outlive that.
+class RequestScope {
+public:
+    RequestScope() { requestArena().openScopes++; }
+    ~RequestScope() {
+        RequestArena& arena = requestArena();
+        if (--arena.openScopes == 0) arena.resource.release();
+    }
+};
+
+// An output stream that writes into an arena string, for text rendered
+// during a request such as a receipt
+struct ArenaStreamBuffer : streambuf {
+    ArenaString text{requestMemory()};
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) text.push_back((char)c);
+        return c;
+    }
+    streamsize xsputn(const char* s, streamsize n) override {
+        text.append(s, n);
+        return n;
+    }
+};
+
+// The buffer is a base so it is built before the stream that writes to it
+class ArenaStream : private ArenaStreamBuffer, public ostream {
+public:
+    explicit ArenaStream(size_t expectedSize = 0) : ostream(static_cast<ArenaStreamBuffer*>(this)) {
+        text.reserve(expectedSize);
+    }
+    const ArenaString& str() const { return text; }
+};
+
+// Global heap allocations made by each thread, read by the allocation
+// benchmark. Counting replaces the global allocation functions, so it is only
+// built into benchmark builds with -DAIRLINE_COUNT_ALLOCATIONS. The array and
+// nothrow forms of the standard library call these.
+#ifdef AIRLINE_COUNT_ALLOCATIONS
+thread_local unsigned long long heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    void* block = malloc(size ? size : 1);
+    if (!block) throw bad_alloc();
+    return block;
+}
+
+void* operator new(size_t size, align_val_t alignment) {
+    heapAllocations++;
+    size_t align = (size_t)alignment;
+    void* block = aligned_alloc(align, (max(size, (size_t)1) + align - 1) / align * align);
+    if (!block) throw bad_alloc();
+    return block;
+}
+
+// Kept out of line so the compiler does not pair an inlined free() with new
+__attribute__((noinline)) void operator delete(void* block) noexcept {
+    free(block);
+}
+
+__attribute__((noinline)) void operator delete(void* block, size_t) noexcept {
+    free(block);
+}
+
+__attribute__((noinline)) void operator delete(void* block, align_val_t) noexcept {
+    free(block);
+}
+
+__attribute__((noinline)) void operator delete(void* block, size_t, align_val_t) noexcept {
+    free(block);
+}
+#endif
+
+// ========== WORK-STEALING SCHEDULER ==========
+
+// Batch work over the stores (listing scans, report totals, refund batches,
+// the list pruning after a sweep and the seat recount of a bulk update) is
+// handed to a pool of workers as index ranges. A worker splits the range it
+// holds, keeps the lower half and pushes the upper half on the back of its
+// own deque, and works from the back; an idle worker steals from the front of
+// another deque, where the biggest ranges are. Uneven work (one flight with
+// thousands of bookings next to many with a few) so spreads out by itself.
+// The thread that starts a batch works on it too until every range is done,
+// so a batch started from inside another one cannot starve the pool.
+const int MAX_SCHEDULER_WORKERS = 64;
+
+struct TaskGroup {
+    const function<void(int, int)>* body;
+    int grain;                    // ranges up to this size are not split further
+    atomic<int> pending{0};       // ranges pushed and not finished yet
+    mutex doneMutex;
+    condition_variable done;
+};
+
+struct RangeTask {
+    TaskGroup* group;
+    int begin;
+    int end;
+};
+
+struct WorkerDeque {
+    mutex lock;
+    deque<RangeTask> tasks;
+};
+
+// One deque per pool worker, plus one shared by threads outside the pool
+WorkerDeque workerDeques[MAX_SCHEDULER_WORKERS + 1];
+int schedulerWorkerCount = 0;
+vector<thread> schedulerThreads;
+once_flag schedulerStarted;
+mutex schedulerSleepMutex;
+condition_variable schedulerWork;
+atomic<int> queuedTasks(0);
+bool stoppingScheduler = false;
+thread_local int schedulerSlot = -1;
+
+int ownDequeSlot() {
+    return schedulerSlot < 0 ? schedulerWorkerCount : schedulerSlot;
+}
+
+void pushRangeTask(const RangeTask& task) {
+    task.group->pending++;
+    WorkerDeque& own = workerDeques[ownDequeSlot()];
+    {
+        lock_guard<mutex> lock(own.lock);
+        own.tasks.push_back(task);
+    }
+    {
+        lock_guard<mutex> lock(schedulerSleepMutex);
+        queuedTasks++;
+    }
+    schedulerWork.notify_one();
+}
+
+// Takes the newest range of this thread's deque, or steals the oldest of
+// another. Given a group, takes only that group's ranges from any deque.
+bool takeRangeTask(RangeTask& task, const TaskGroup* only = nullptr) {
+    int own = ownDequeSlot();
+    for (int k = 0; k <= schedulerWorkerCount; k++) {
+        WorkerDeque& source = workerDeques[(own + k) % (schedulerWorkerCount + 1)];
+        lock_guard<mutex> lock(source.lock);
+        if (source.tasks.empty()) continue;
+        if (only) {
+            auto found = find_if(source.tasks.begin(), source.tasks.end(),
+                                 [only](const RangeTask& queued) { return queued.group == only; });
+            if (found == source.tasks.end()) continue;
+            task = *found;
+            source.tasks.erase(found);
+        } else if (k == 0) {
+            task = source.tasks.back();
+            source.tasks.pop_back();
+        } else {
+            task = source.tasks.front();
+            source.tasks.pop_front();
+        }
+        queuedTasks--;
+        return true;
+    }
+    return false;
+}
+
+void runRangeTask(RangeTask task) {
+    TaskGroup& group = *task.group;
+    while (task.end - task.begin > group.grain) {
+        int middle = task.begin + (task.end - task.begin) / 2;
+        pushRangeTask({task.group, middle, task.end});
+        task.end = middle;
+    }
+    (*group.body)(task.begin, task.end);
+    // The starter may return as soon as it sees zero, so the group is not touched after the unlock
+    lock_guard<mutex> lock(group.doneMutex);
+    if (--group.pending == 0) group.done.notify_all();
+}
+
+void runSchedulerWorker(int slot) {
+    schedulerSlot = slot;
+    RangeTask task;
+    while (true) {
+        if (takeRangeTask(task)) {
+            runRangeTask(task);
+            continue;
+        }
+        unique_lock<mutex> lock(schedulerSleepMutex);
+        schedulerWork.wait(lock, [] { return queuedTasks > 0 || stoppingScheduler; });
+        if (stoppingScheduler) return;
+    }
+}
+
+// The pool starts on first use with one worker per core besides the caller's;
+// AIRLINE_SCHEDULER_WORKERS fixes the count at build time
+void startTaskScheduler() {
+    call_once(schedulerStarted, [] {
+#ifdef AIRLINE_SCHEDULER_WORKERS
+        int workers = AIRLINE_SCHEDULER_WORKERS;
+#else
+        int workers = (int)thread::hardware_concurrency() - 1;
+#endif
+        schedulerWorkerCount = min(max(workers, 0), MAX_SCHEDULER_WORKERS);
+        for (int w = 0; w < schedulerWorkerCount; w++) schedulerThreads.emplace_back(runSchedulerWorker, w);
+    });
+}
+
+void stopTaskScheduler() {
+    {
+        lock_guard<mutex> lock(schedulerSleepMutex);
+        stoppingScheduler = true;
+    }
+    schedulerWork.notify_all();
+    for (thread& worker : schedulerThreads) worker.join();
+    schedulerThreads.clear();
+}
+
+// Calls body(b, e) on pieces [b, e) that together cover [begin, end), at
+// most grain indexes each, spread across the pool. A grain of 0 picks one
+// that gives every thread several pieces. Returns when every piece is done.
+void parallelFor(int begin, int end, int grain, const function<void(int, int)>& body) {
+    if (end <= begin) return;
+    startTaskScheduler();
+    if (grain < 1) grain = max(1, (end - begin) / ((schedulerWorkerCount + 1) * 8));
+    if (schedulerWorkerCount == 0 || end - begin <= grain) {
+        body(begin, end);
+        return;
+    }
+    
+    TaskGroup group;
+    group.body = &body;
+    group.grain = grain;
+    group.pending = 1;
+    runRangeTask({&group, begin, end});
+    
+    // Help with this batch's own pieces until the last one is done. Pieces of
+    // other batches are left to the pool: the caller may hold storeMutex, and
+    // a stranger's piece could take it again or keep every writer waiting.
+    RangeTask task;
+    while (true) {
+        {
+            lock_guard<mutex> lock(group.doneMutex);
+            if (group.pending == 0) return;
+        }
+        if (takeRangeTask(task, &group)) {
+            runRangeTask(task);
+        } else {
+            unique_lock<mutex> lock(group.doneMutex);
+            group.done.wait_for(lock, chrono::milliseconds(1), [&] { return group.pending == 0; });
+        }
+    }
+}
+
+// Folds [begin, end) into one Result. body(b, e, part) accumulates a piece
+// into part, which starts as a copy of identity; combine(into, part) merges
+// the pieces back in index order, so the result does not depend on which
+// thread ran which piece.
+template <typename Result, typename Body, typename Combine>
+Result parallelReduce(int begin, int end, int grain, const Result& identity, Body body, Combine combine) {
+    mutex partsMutex;
+    vector<pair<int, Result>> parts;
+    parallelFor(begin, end, grain, [&](int b, int e) {
+        Result part = identity;
+        body(b, e, part);
+        lock_guard<mutex> lock(partsMutex);
+        parts.emplace_back(b, move(part));
+    });
+    sort(parts.begin(), parts.end(),
+         [](const pair<int, Result>& a, const pair<int, Result>& b) { return a.first < b.first; });
+    Result result = identity;
+    for (pair<int, Result>& part : parts) combine(result, part.second);
+    return result;
+}
+
+// ========== TRACE RECORDING ==========
+
+// When a session is recorded (--record FILE), every store mutation and search
+// is appended as a tab-separated line prefixed with microseconds since the
+// start of the session, so the session can be replayed later with --replay.
+atomic<bool> tracing(false);
+mutex traceMutex;
+ofstream traceFile;
+chrono::steady_clock::time_point traceStart;
+bool traceSearches = true;          // journals leave out read-only searches
+bool traceFlushEachRecord = false;  // journals must survive a crash of the process
+
+bool startTrace(const char* path, bool append) {
+    traceFile.open(path, append ? ios::app : ios::trunc);
+    if (!traceFile) return false;
+    traceStart = chrono::steady_clock::now();
+    tracing = true;
+    return true;
+}
+
+void traceRecord(const string& fields) {
+    long long micros = chrono::duration_cast<chrono::microseconds>(
+                           chrono::steady_clock::now() - traceStart).count();
+    lock_guard<mutex> lock(traceMutex);
+    traceFile << micros << '\t' << fields << '\n';
+    if (traceFlushEachRecord) traceFile.flush();
+}
+
+string traceFlightFields(const Flight& flight) {
+    ostringstream out;
+    out << fixed << setprecision(2) << "F\t" << flight.flightNo << '\t' << cityName(flight.origin) << '\t' << cityName(flight.destination)
+        << '\t' << flight.departureDate.day << '\t' << flight.departureDate.month << '\t' << flight.departureDate.year
+        << '\t' << flight.departureTime.hour << '\t' << flight.departureTime.minute
+        << '\t' << flight.arrivalDate.day << '\t' << flight.arrivalDate.month << '\t' << flight.arrivalDate.year
+        << '\t' << flight.arrivalTime.hour << '\t' << flight.arrivalTime.minute;
+    for (int c = 0; c < CABIN_COUNT; c++) out << '\t' << flight.classSeats[c];
+    for (int c = 0; c < CABIN_COUNT; c++) out << '\t' << flight.classFares[c];
+    out << '\t' << flight.distance;
+    return out.str();
+}
+
+string traceBookingFields(const Booking& booking) {
+    Date travelDate = unpackDate(booking.travelDate);
+    Date bookingDate = unpackDate(booking.bookingDate);
+    ostringstream out;
+    out << fixed << setprecision(2) << "B\t" << booking.bookingId << '\t' << booking.passengerId << '\t' << booking.flightNo
+        << '\t' << booking.seatsBooked << '\t' << cabinName(booking.cabin)
+        << '\t' << travelDate.day << '\t' << travelDate.month << '\t' << travelDate.year
+        << '\t' << fromCents(booking.fareCents)
+        << '\t' << bookingDate.day << '\t' << bookingDate.month << '\t' << bookingDate.year;
+    return out.str();
+}
+
+// A schedule change exactly as it was applied, so a replay reapplies it the same way
+string traceUpdateFields(const FlightUpdate& update) {
+    ostringstream out;
+    out << fixed << setprecision(2) << "U\t" << update.flightNo << '\t' << update.fields
+        << '\t' << update.departureDate.day << '\t' << update.departureDate.month << '\t' << update.departureDate.year
+        << '\t' << update.departureTime.hour << '\t' << update.departureTime.minute
+        << '\t' << update.arrivalDate.day << '\t' << update.arrivalDate.month << '\t' << update.arrivalDate.year
+        << '\t' << update.arrivalTime.hour << '\t' << update.arrivalTime.minute;
+    for (int c = 0; c < CABIN_COUNT; c++) out << '\t' << update.classSeats[c];
+    for (int c = 0; c < CABIN_COUNT; c++) out << '\t' << update.classFares[c];
+    out << '\t' << update.distance << '\t' << FLIGHT_STATUS_NAMES[update.status]
+        << '\t' << update.origin << '\t' << update.destination;
+    return out.str();
+}
+
+string tracePassengerFields(const Passenger& passenger) {
+    return string("P\t") + to_string(passenger.id) + '\t' + passenger.name + '\t' +
+           passenger.email + '\t' + passenger.phone;
+}
+
+// ========== CONSOLE INPUT ==========
+
+// The menus read standard input through one fixed buffer a line at a time and
+// take whitespace-separated tokens from it, parsing numbers with from_chars.
+// Nothing is allocated per read, so an operator script piped in runs at
+// file-read speed. A token that is not a number drops the rest of its line and
+// reads as 0, so the next prompt starts clean. Once input has ended every read
+// fails, and menus and re-prompt loops check inputEnded() to unwind.
+struct ConsoleInput {
+    char buffer[1 << 16];
+    size_t filled = 0;     // bytes read into buffer
+    size_t next = 0;       // first byte after the current line
+    size_t cursor = 0;     // next unread byte of the current line
+    size_t lineEnd = 0;    // end of the current line, without its newline
+    bool eof = false;      // read() has reported the end of input
+    bool ended = false;    // a read found nothing left
+};
+
+ConsoleInput consoleInput;
+
+bool inputEnded() {
+    return consoleInput.ended;
+}
+
+// Makes the next line current. Lines longer than the buffer are split.
+bool nextConsoleLine() {
+    ConsoleInput& in = consoleInput;
+    while (true) {
+        const char* newline = (const char*)memchr(in.buffer + in.next, '\n', in.filled - in.next);
+        if (newline || in.filled - in.next == sizeof(in.buffer) || (in.eof && in.filled > in.next)) {
+            in.cursor = in.next;
+            in.lineEnd = newline ? newline - in.buffer : in.filled;
+            in.next = newline ? in.lineEnd + 1 : in.filled;
+            if (in.lineEnd > in.cursor && in.buffer[in.lineEnd - 1] == '\r') in.lineEnd--;
+            return true;
+        }
+        if (in.eof) {
+            in.ended = true;
+            return false;
+        }
+        
+        // Keep the partial line and read more behind it. The prompt has to be
+        // on the screen before read() blocks.
+        memmove(in.buffer, in.buffer + in.next, in.filled - in.next);
+        in.filled -= in.next;
+        in.next = in.cursor = in.lineEnd = 0;
+        cout.flush();
+        ssize_t got = read(STDIN_FILENO, in.buffer + in.filled, sizeof(in.buffer) - in.filled);
+        if (got > 0) in.filled += got;
+        else if (got == 0 || errno != EINTR) in.eof = true;
+    }
+}
+
+// Next whitespace-separated token, continuing on later lines if the current
+// one is used up. The token points into the buffer until the next read.
+bool nextConsoleToken(string_view& token) {
+    ConsoleInput& in = consoleInput;
+    while (true) {
+        while (in.cursor < in.lineEnd && isspace((unsigned char)in.buffer[in.cursor])) in.cursor++;
+        if (in.cursor < in.lineEnd) break;
+        if (!nextConsoleLine()) return false;
+    }
+    size_t start = in.cursor;
+    while (in.cursor < in.lineEnd && !isspace((unsigned char)in.buffer[in.cursor])) in.cursor++;
+    token = string_view(in.buffer + start, in.cursor - start);
+    return true;
+}
+
+// Reads an integer or floating-point token into value, or 0 if there is none
+template <typename Number>
+bool readNumber(Number& value) {
+    value = 0;
+    string_view token;
+    if (!nextConsoleToken(token)) return false;
+    const char* end = token.data() + token.size();
+    from_chars_result parsed = from_chars(token.data(), end, value);
+    if (parsed.ec == errc() && parsed.ptr == end) return true;
+    value = 0;
+    consoleInput.cursor = consoleInput.lineEnd;
+    return false;
+}
+
+// Reads the first character of the next token, as for Y/N answers
+bool readChar(char& value) {
+    string_view token;
+    value = 0;
+    if (!nextConsoleToken(token)) return false;
+    value = token[0];
+    return true;
+}
+
+bool readWord(string& word) {
+    string_view token;
+    if (!nextConsoleToken(token)) {
+        word.clear();
+        return false;
+    }
+    word.assign(token.data(), token.size());
+    return true;
+}
+
+// Reads free text such as a name or city: whatever follows the last token on
+// the current line, or the next line if nothing does. Text that does not fit
+// in size - 1 characters is cut off.
+bool readLine(char* out, size_t size) {
+    ConsoleInput& in = consoleInput;
+    out[0] = '\0';
+    while (in.cursor < in.lineEnd && isspace((unsigned char)in.buffer[in.cursor])) in.cursor++;
+    if (in.cursor == in.lineEnd && !nextConsoleLine()) return false;
+    size_t length = min(in.lineEnd - in.cursor, size - 1);
+    memcpy(out, in.buffer + in.cursor, length);
+    out[length] = '\0';
+    in.cursor = in.lineEnd;
+    return true;
+}
+
+bool readLine(string& line) {
+    ConsoleInput& in = consoleInput;
+    line.clear();
+    while (in.cursor < in.lineEnd && isspace((unsigned char)in.buffer[in.cursor])) in.cursor++;
+    if (in.cursor == in.lineEnd && !nextConsoleLine()) return false;
+    line.assign(in.buffer + in.cursor, in.lineEnd - in.cursor);
+    in.cursor = in.lineEnd;
+    return true;
+}
 
 // ========== VALIDATION FUNCTIONS ==========
 
@@ -124,11 +1127,12 @@ bool isValidDate(const Date& date) {
 
 bool isFutureDate(const Date& date) {
     time_t now = time(0);
-    tm* currentTime = localtime(&now);
+    tm currentTime;
+    localtime_r(&now, &currentTime);
     
-    int currentYear = currentTime->tm_year + 1900;
-    int currentMonth = currentTime->tm_mon + 1;
-    int currentDay = currentTime->tm_mday;
+    int currentYear = currentTime.tm_year + 1900;
+    int currentMonth = currentTime.tm_mon + 1;
+    int currentDay = currentTime.tm_mday;
     
     if (date.year < currentYear) return false;
     if (date.year == currentYear && date.month < currentMonth) return false;
@@ -183,71 +1187,334 @@ string formatTime(const Time& time) {
     return hour + ":" + minute;
 }
 
-// ========== CALCULATION FUNCTIONS ==========
+// ========== DATE ARITHMETIC ==========
 
-void displayFareBreakdown(const Flight& flight, int seats, const string& classType) {
-    float distanceFarePerKm = flight.baseFare / 100.0;
-    float farePerKm = flight.distance * distanceFarePerKm;
-    float multiplier;
-    
-    if (classType == "Economy") multiplier = 1.0;
-    else if (classType == "Business") multiplier = 2.0;
-    else if (classType == "First") multiplier = 3.5;
-    else multiplier = 1.0;
-    
-    float farePerSeat = farePerKm * multiplier;
-    float totalFare = farePerSeat * seats;
-    
-    cout << "\n=== FARE BREAKDOWN ===\n";
-    cout << "Distance: " << flight.distance << " km\n";
-    cout << "Base Rate: $" << flight.baseFare << " per 100 km\n";
-    cout << "Rate per km: $" << fixed << setprecision(2) << distanceFarePerKm << "\n";
-    cout << "Fare per km for journey: $" << farePerKm << "\n";
-    cout << "Class: " << classType << " (Multiplier: " << multiplier << "x)\n";
-    cout << "Fare per seat: $" << farePerSeat << "\n";
-    cout << "Number of seats: " << seats << "\n";
-    cout << "TOTAL FARE (for all seats): $" << totalFare << "\n";
-    cout << "=======================\n";
+// Days since 1970-01-01 in the proleptic Gregorian calendar
+int daysFromCivil(const Date& date) {
+    int y = date.year - (date.month <= 2 ? 1 : 0);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int mp = (date.month + 9) % 12;
+    int doy = (153 * mp + 2) / 5 + date.day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
 }
 
-float calculateFare(const Flight& flight, int seats, const string& classType) {
+Date civilFromDays(int days) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int doe = days - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    Date date;
+    date.day = doy - (153 * mp + 2) / 5 + 1;
+    date.month = mp < 10 ? mp + 3 : mp - 9;
+    date.year = yoe + era * 400 + (date.month <= 2 ? 1 : 0);
+    return date;
+}
 
-    // This returns TOTAL fare for all seats
-    float distanceFare = flight.distance * (flight.baseFare / 100);
-    float multiplier;
-    
-    if (classType == "Economy") multiplier = 1.0;
-    else if (classType == "Business") multiplier = 2.0;
-    else if (classType == "First") multiplier = 3.5;
-    else multiplier = 1.0;
+// 16 bits of days from 2000 reach into 2179
+const int PACKED_DATE_EPOCH = 10957;   // daysFromCivil of 1/1/2000
+
+PackedDate packDate(const Date& date) {
+    return (PackedDate)(daysFromCivil(date) - PACKED_DATE_EPOCH);
+}
+
+Date unpackDate(PackedDate date) {
+    return civilFromDays(date + PACKED_DATE_EPOCH);
+}
+
+int packedDayNumber(PackedDate date) {
+    return date + PACKED_DATE_EPOCH;
+}
+
+// ========== CALCULATION FUNCTIONS ==========
+
+// Amounts paid are kept as whole cents; fares are quoted in dollars
+int toCents(double amount) {
+    return (int)llround(amount * 100);
+}
+
+float fromCents(int cents) {
+    return cents / 100.0f;
+}
+
+void displayFareBreakdown(ostream& out, const Flight& flight, int seats, unsigned char cabin) {
+    float distanceFarePerKm = flight.baseFare / 100.0;
+    float farePerKm = flight.distance * distanceFarePerKm;
+    float multiplier = CABIN_CLASSES[cabin].fareMultiplier;
+    
+    float farePerSeat = farePerKm * multiplier;
+    float totalFare = farePerSeat * seats;
     
-    // Return TOTAL fare (fare per seat * number of seats)
-    return distanceFare * multiplier * seats;
+    out << "\n=== FARE BREAKDOWN ===\n";
+    out << "Distance: " << flight.distance << " km\n";
+    out << "Base Rate: $" << flight.baseFare << " per 100 km\n";
+    out << "Rate per km: $" << fixed << setprecision(2) << distanceFarePerKm << "\n";
+    out << "Fare per km for journey: $" << farePerKm << "\n";
+    out << "Class: " << CABIN_CLASSES[cabin].name << " (Multiplier: " << multiplier << "x)\n";
+    out << "Fare per seat: $" << farePerSeat << "\n";
+    out << "Number of seats: " << seats << "\n";
+    out << "TOTAL FARE (for all seats): $" << totalFare << "\n";
+    out << "=======================\n";
+}
+
+// Per-cabin accessors for code that names its cabin when compiling
+template <unsigned char Cabin>
+int& seatsIn(Flight& flight) {
+    static_assert(Cabin < CABIN_COUNT, "no such cabin");
+    return flight.classSeats[Cabin];
+}
+
+template <unsigned char Cabin>
+float& fareIn(Flight& flight) {
+    static_assert(Cabin < CABIN_COUNT, "no such cabin");
+    return flight.classFares[Cabin];
+}
+
+// Seats left across every cabin; always equals availableSeats
+int cabinSeatTotal(const Flight& flight) {
+    int total = 0;
+    for (int c = 0; c < CABIN_COUNT; c++) total += flight.classSeats[c];
+    return total;
+}
+
+template <unsigned char Cabin>
+float quoteFare(const Flight& flight, int seats) {
+    static_assert(Cabin < CABIN_COUNT, "no such cabin");
+    constexpr float multiplier = CABIN_CLASSES[Cabin].fareMultiplier;
+    return flight.distance * (flight.baseFare / 100) * multiplier * seats;
+}
+
+// Total fare for all seats in the given cabin
+float calculateFare(const Flight& flight, int seats, unsigned char cabin) {
+    MetricTimer timer(METRIC_QUOTE);
+    float distanceFare = flight.distance * (flight.baseFare / 100);
+    return distanceFare * CABIN_CLASSES[cabin].fareMultiplier * seats;
 }
 
+// Booking IDs advance by bookingIdStride; a shard worker starts at its own
+// offset so the shard that owns a booking can be told from its ID
+int bookingIdStride = 1;
+atomic<int> lastBookingId(1000);
+
 int generateBookingId() {
-    static int lastId = 1000;
-    return ++lastId;
+    return lastBookingId += bookingIdStride;
 }
 
-float calculateRefundAmount(const Booking& booking) {
+// Keeps generated IDs above one restored from a journal
+void reserveBookingId(int bookingId) {
+    int seen = lastBookingId.load();
+    while (seen < bookingId && !lastBookingId.compare_exchange_weak(seen, bookingId)) {}
+}
+
+// ========== REFUND POLICY FUNCTIONS ==========
+
+// Today's day number, recomputed only when the date changes
+int todayDayNumber() {
+    static atomic<long long> nextRefresh(0);
+    static atomic<int> cachedDay(0);
+    
     time_t now = time(0);
-    tm* currentTime = localtime(&now);
-    Date currentDate = {currentTime->tm_mday, currentTime->tm_mon + 1, currentTime->tm_year + 1900};
+    if (now >= nextRefresh.load(memory_order_relaxed)) {
+        tm local;
+        localtime_r(&now, &local);
+        cachedDay.store(daysFromCivil({local.tm_mday, local.tm_mon + 1, local.tm_year + 1900}),
+                        memory_order_relaxed);
+        int secondsToday = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+        nextRefresh.store(now + 86400 - secondsToday, memory_order_relaxed);
+    }
+    return cachedDay.load(memory_order_relaxed);
+}
+
+void setRefundPolicy(int policy, const RefundTier tiers[], int tierCount) {
+    RefundPolicy& target = refundPolicies[policy];
+    target.tierCount = min(tierCount, MAX_REFUND_TIERS);
+    copy(tiers, tiers + target.tierCount, target.tiers);
+    sort(target.tiers, target.tiers + target.tierCount,
+         [](const RefundTier& a, const RefundTier& b) { return a.minDaysBefore > b.minDaysBefore; });
+    
+    // Expand the tiers into a flat lookup by days before travel. Entry 0 is for
+    // travel dates already passed, entry d + 1 for d days before travel.
+    for (int d = -1; d <= REFUND_TABLE_DAYS; d++) {
+        float fraction = 0.0;
+        for (int t = 0; t < target.tierCount; t++) {
+            if (d >= target.tiers[t].minDaysBefore) {
+                fraction = target.tiers[t].refundFraction;
+                break;
+            }
+        }
+        refundFractionTable[policy][d + 1] = fraction;
+    }
+}
+
+void initRefundPolicies() {
+    const RefundTier standard[] = {{7, 0.9}, {3, 0.5}, {1, 0.2}};
+    const RefundTier involuntary[] = {{-1, 1.0}};
+    for (int policy = 0; policy < INVOLUNTARY_REFUND_POLICY; policy++) {
+        setRefundPolicy(policy, standard, 3);
+    }
+    setRefundPolicy(INVOLUNTARY_REFUND_POLICY, involuntary, 1);
+}
+
+// Refund batches larger than this are spread over the task scheduler
+const int REFUND_BATCH_GRAIN = 8192;
+
+// Refunds for a batch laid out as parallel arrays. The loop body is a clamp
+// and a table gather with no branches, so the compiler can vectorize it.
+void calculateRefundsBatch(const int daysBefore[], const unsigned char policies[],
+                           const float fares[], float refunds[], int count) {
+    if (count > REFUND_BATCH_GRAIN) {
+        parallelFor(0, count, REFUND_BATCH_GRAIN, [&](int begin, int end) {
+            calculateRefundsBatch(daysBefore + begin, policies + begin, fares + begin, refunds + begin, end - begin);
+        });
+        return;
+    }
+    const int rowLength = REFUND_TABLE_DAYS + 2;
+    const float* table = &refundFractionTable[0][0];
+    for (int i = 0; i < count; i++) {
+        int d = min(max(daysBefore[i], -1), REFUND_TABLE_DAYS) + 1;
+        int row = policies[i];
+        refunds[i] = fares[i] * table[row * rowLength + d];
+    }
+}
+
+float calculateRefundAmount(const Booking& booking) {
+    int daysBefore = packedDayNumber(booking.travelDate) - todayDayNumber();
+    unsigned char policy = booking.cabin;
+    float fare = fromCents(booking.fareCents);
+    float refund;
+    calculateRefundsBatch(&daysBefore, &policy, &fare, &refund, 1);
+    return refund;
+}
+
+void configureRefundPolicy() {
+    cout << "\n=== CONFIGURE REFUND POLICY ===\n";
+    for (int policy = 0; policy < REFUND_POLICY_COUNT; policy++) {
+        cout << policy + 1 << ". " << refundPolicyName(policy) << ":";
+        for (int t = 0; t < refundPolicies[policy].tierCount; t++) {
+            const RefundTier& tier = refundPolicies[policy].tiers[t];
+            cout << "  " << tier.minDaysBefore << "+ days " << tier.refundFraction * 100 << "%";
+        }
+        cout << "\n";
+    }
+    
+    int choice;
+    cout << "Select policy to change (0 to go back): ";
+    readNumber(choice);
+    if (choice < 1 || choice > REFUND_POLICY_COUNT) return;
+    
+    int tierCount;
+    cout << "Number of tiers (1-" << MAX_REFUND_TIERS << "): ";
+    readNumber(tierCount);
+    if (tierCount < 1 || tierCount > MAX_REFUND_TIERS) {
+        cout << "Invalid number of tiers!\n";
+        return;
+    }
     
-    int daysBefore = (booking.travelDate.year - currentDate.year) * 365 +
-                     (booking.travelDate.month - currentDate.month) * 30 +
-                     (booking.travelDate.day - currentDate.day);
+    RefundTier tiers[MAX_REFUND_TIERS];
+    for (int t = 0; t < tierCount; t++) {
+        float percent;
+        cout << "Tier " << t + 1 << " - minimum days before travel and refund %: ";
+        readNumber(tiers[t].minDaysBefore) && readNumber(percent);
+        if (percent < 0 || percent > 100) {
+            cout << "Refund must be between 0 and 100%!\n";
+            return;
+        }
+        tiers[t].refundFraction = percent / 100;
+    }
     
-    if (daysBefore >= 7) return booking.farePaid * 0.9;
-    else if (daysBefore >= 3) return booking.farePaid * 0.5;
-    else if (daysBefore >= 1) return booking.farePaid * 0.2;
-    else return 0.0;
+    setRefundPolicy(choice - 1, tiers, tierCount);
+    cout << "Refund policy updated.\n";
+}
+
+// ========== LOYALTY FUNCTIONS ==========
+
+// Miles are credited when a booking is made and taken back when it is
+// cancelled. Each passenger keeps the last 12 months of miles in a ring
+// buffer, so the tier comes from a running sum instead of booking history.
+enum LoyaltyTier { TIER_BLUE, TIER_SILVER, TIER_GOLD, TIER_PLATINUM, LOYALTY_TIER_COUNT };
+const char* const LOYALTY_TIER_NAMES[LOYALTY_TIER_COUNT] = {"Blue", "Silver", "Gold", "Platinum"};
+const int LOYALTY_TIER_MILES[LOYALTY_TIER_COUNT] = {0, 10000, 25000, 50000};   // rolling miles needed
+const float LOYALTY_DISCOUNT[LOYALTY_TIER_COUNT] = {0.0, 0.05, 0.10, 0.15};
+
+int currentMonthKey() {
+    return travelMonthKey(civilFromDays(todayDayNumber()));
+}
+
+// Adds miles to the given month, rolling the window forward if the month is
+// newer than anything seen. Months that already left the window only change
+// the lifetime total. The caller holds storeMutex.
+void accrueMiles(Passenger& passenger, int monthKey, int miles) {
+    passenger.lifetimeMiles += miles;
+    if (monthKey > passenger.loyaltyWindowMonth) {
+        int steps = min(monthKey - passenger.loyaltyWindowMonth, 12);
+        for (int m = monthKey - steps + 1; m <= monthKey; m++) {
+            passenger.rollingMiles -= passenger.monthlyMiles[m % 12];
+            passenger.monthlyMiles[m % 12] = 0;
+        }
+        passenger.loyaltyWindowMonth = monthKey;
+    }
+    if (monthKey > passenger.loyaltyWindowMonth - 12) {
+        passenger.monthlyMiles[monthKey % 12] += miles;
+        passenger.rollingMiles += miles;
+    }
+}
+
+// Rolling 12-month miles as of today. Months that aged out since the last
+// accrual are discounted on the fly, so this never writes and never scans
+// more than the ring.
+int currentRollingMiles(const Passenger& passenger) {
+    int now = currentMonthKey();
+    int miles = passenger.rollingMiles;
+    int expired = min(now - passenger.loyaltyWindowMonth, 12);
+    for (int m = passenger.loyaltyWindowMonth - 11; m < passenger.loyaltyWindowMonth - 11 + expired; m++) {
+        miles -= passenger.monthlyMiles[((m % 12) + 12) % 12];
+    }
+    return miles;
+}
+
+int tierForMiles(int miles) {
+    int tier = TIER_BLUE;
+    while (tier + 1 < LOYALTY_TIER_COUNT && miles >= LOYALTY_TIER_MILES[tier + 1]) tier++;
+    return tier;
+}
+
+int loyaltyTier(const Passenger& passenger) {
+    return tierForMiles(currentRollingMiles(passenger));
+}
+
+float applyTierDiscount(float fare, int tier) {
+    return fare * (1.0 - LOYALTY_DISCOUNT[tier]);
+}
+
+float applyLoyaltyDiscount(float fare, int passengerId) {
+    Passenger* passenger = findPassengerById(passengerId);
+    if (!passenger) return fare;
+    return applyTierDiscount(fare, loyaltyTier(*passenger));
+}
+
+// Credits the passenger of the booking in a slot and records the miles beside
+// it so a later cancellation takes back exactly what was given. The caller
+// holds storeMutex.
+void accrueBookingMiles(int slot, const Flight& flight) {
+    const Booking& booking = bookings[slot];
+    bookingMiles[slot] = (int)(flight.distance * CABIN_CLASSES[booking.cabin].milesMultiplier * booking.seatsBooked);
+    Passenger* passenger = findPassengerById(booking.passengerId);
+    if (passenger) accrueMiles(*passenger, travelMonthKey(unpackDate(booking.bookingDate)), bookingMiles[slot]);
+}
+
+void reverseBookingMiles(int slot) {
+    const Booking& booking = bookings[slot];
+    Passenger* passenger = findPassengerById(booking.passengerId);
+    if (passenger) accrueMiles(*passenger, travelMonthKey(unpackDate(booking.bookingDate)), -bookingMiles[slot]);
 }
 
 // ========== RECEIPT GENERATION FUNCTION ==========
 
 void generateBookingReceipt(int bookingId) {
+    MetricTimer timer(METRIC_RECEIPT);
     if (currentPassengerId == -1) {
         cout << "You must login first!\n";
         return;
@@ -255,1497 +1522,7146 @@ void generateBookingReceipt(int bookingId) {
     
     // Find the booking
     int bookingIndex = -1;
-    Booking* booking = nullptr;
-    
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].bookingId == bookingId && 
-            bookings[i].passengerId == currentPassengerId) {
-            booking = &bookings[i];
-            bookingIndex = i;
-            break;
-        }
-    }
+    Booking booking;
     
-    if (!booking) {
+    if (!findBookingById(bookingId, booking, bookingIndex)) {
         cout << "Booking not found!\n";
         return;
     }
     
     // Find the flight
-    Flight* flight = nullptr;
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].flightNo == booking->flightNo) {
-            flight = &flights[i];
-            break;
-        }
-    }
+    Flight flightCopy;
+    Flight* flight = snapshotFlight(booking.flightNo, flightCopy) ? &flightCopy : nullptr;
     
     if (!flight) {
         cout << "Flight information not found!\n";
         return;
     }
     
-    // Find passenger
-    Passenger* passenger = nullptr;
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            passenger = &passengers[i];
-            break;
-        }
-    }
-    
+    Passenger* passenger = findPassengerById(currentPassengerId);
     if (!passenger) {
         cout << "Passenger information not found!\n";
         return;
     }
     
-    // Generate receipt
-    cout << "\n========================================\n";
-    cout << "         FLIGHT BOOKING RECEIPT\n";
-    cout << "========================================\n\n";
-    
-    cout << "RECEIPT #: " << booking->bookingId << "\n";
-    cout << "ISSUE DATE: " << formatDate(booking->bookingDate) << "\n";
-    cout << "TIME: " << formatTime({12, 0}) << " (System Time)\n\n"; // You can add actual time
-    
-    cout << "------------------------------------------------\n";
-    cout << "PASSENGER INFORMATION:\n";
-    cout << "------------------------------------------------\n";
-    cout << "Passenger ID: " << passenger->id << "\n";
-    cout << "Name: " << passenger->name << "\n";
-    cout << "Email: " << passenger->email << "\n";
-    cout << "Phone: " << passenger->phone << "\n\n";
-    
-    cout << "------------------------------------------------\n";
-    cout << "FLIGHT INFORMATION:\n";
-    cout << "------------------------------------------------\n";
-    cout << "Flight Number: " << flight->flightNo << "\n";
-    cout << "Route: " << flight->origin << " to " << flight->destination << "\n";
-    cout << "Departure: " << formatDate(flight->departureDate) << " at " 
-         << formatTime(flight->departureTime) << "\n";
-    cout << "Arrival: " << formatDate(flight->arrivalDate) << " at " 
-         << formatTime(flight->arrivalTime) << "\n";
-    cout << "Distance: " << flight->distance << " km\n\n";
-    
-    cout << "------------------------------------------------\n";
-    cout << "BOOKING DETAILS:\n";
-    cout << "------------------------------------------------\n";
-    cout << "Travel Date: " << formatDate(booking->travelDate) << "\n";
-    cout << "Class: " << booking->classType << "\n";
-    cout << "Seats Booked: " << booking->seatsBooked << "\n";
-    cout << "Base Fare per seat: $" << flight->baseFare << "\n";
-    cout << "Distance Rate: $" << (flight->baseFare / 100) << " per km\n";
-    
-    cout << "------------------------------------------------\n";
-    cout << "FARE BREAKDOWN:\n";
-    cout << "------------------------------------------------\n";
-    
-    float distanceFare = flight->distance * (flight->baseFare / 100);
-    float classMultiplier;
+    renderReceipt(cout, booking, *flight, *passenger);
+}
+
+// Renders the receipt for a booking as issued for the given flight and passenger
+void renderReceipt(ostream& out, const Booking& booking, const Flight& flight, const Passenger& passenger) {
+    out << "\n========================================\n";
+    out << "         FLIGHT BOOKING RECEIPT\n";
+    out << "========================================\n\n";
+    
+    out << "RECEIPT #: " << booking.bookingId << "\n";
+    out << "ISSUE DATE: " << formatDate(unpackDate(booking.bookingDate)) << "\n";
+    out << "TIME: " << formatTime({12, 0}) << " (System Time)\n\n"; // You can add actual time
+    
+    out << "------------------------------------------------\n";
+    out << "PASSENGER INFORMATION:\n";
+    out << "------------------------------------------------\n";
+    out << "Passenger ID: " << passenger.id << "\n";
+    out << "Name: " << passenger.name << "\n";
+    out << "Email: " << passenger.email << "\n";
+    out << "Phone: " << passenger.phone << "\n\n";
+    
+    out << "------------------------------------------------\n";
+    out << "FLIGHT INFORMATION:\n";
+    out << "------------------------------------------------\n";
+    out << "Flight Number: " << flight.flightNo << "\n";
+    out << "Route: " << cityName(flight.origin) << " to " << cityName(flight.destination) << "\n";
+    out << "Departure: " << formatDate(flight.departureDate) << " at " 
+         << formatTime(flight.departureTime) << "\n";
+    out << "Arrival: " << formatDate(flight.arrivalDate) << " at " 
+         << formatTime(flight.arrivalTime) << "\n";
+    out << "Distance: " << flight.distance << " km\n\n";
+    
+    out << "------------------------------------------------\n";
+    out << "BOOKING DETAILS:\n";
+    out << "------------------------------------------------\n";
+    out << "Travel Date: " << formatDate(unpackDate(booking.travelDate)) << "\n";
+    out << "Class: " << cabinName(booking.cabin) << "\n";
+    out << "Seats Booked: " << booking.seatsBooked << "\n";
+    out << "Base Fare per seat: $" << flight.baseFare << "\n";
+    out << "Distance Rate: $" << (flight.baseFare / 100) << " per km\n";
+    
+    out << "------------------------------------------------\n";
+    out << "FARE BREAKDOWN:\n";
+    out << "------------------------------------------------\n";
     
-    if (strcmp(booking->classType, "Economy") == 0) classMultiplier = 1.0;
-    else if (strcmp(booking->classType, "Business") == 0) classMultiplier = 2.0;
-    else if (strcmp(booking->classType, "First") == 0) classMultiplier = 3.5;
-    else classMultiplier = 1.0;
+    float distanceFare = flight.distance * (flight.baseFare / 100);
+    float classMultiplier = CABIN_CLASSES[booking.cabin].fareMultiplier;
     
     float farePerSeat = distanceFare * classMultiplier;
-    float totalFare = farePerSeat * booking->seatsBooked;
-    
-    cout << "Distance (" << flight->distance << " km): $" << distanceFare << "\n";
-    cout << "Class Multiplier (" << booking->classType << "): " << classMultiplier << "x\n";
-    cout << "Fare per seat: $" << fixed << setprecision(2) << farePerSeat << "\n";
-    cout << "Number of seats: " << booking->seatsBooked << "\n";
-    cout << "------------------------------------------------\n";
-    cout << "TOTAL FARE: $" << fixed << setprecision(2) << totalFare << "\n\n";
-    
-    cout << "------------------------------------------------\n";
-    cout << "BOOKING STATUS: " << booking->status << "\n";
-    cout << "------------------------------------------------\n\n";
-    
-    cout << "Terms & Conditions:\n";
-    cout << "1. This receipt is proof of booking.\n";
-    cout << "2. Cancellation charges apply as per policy.\n";
-    cout << "3. Please arrive 2 hours before departure.\n";
-    cout << "4. Carry valid ID proof for verification.\n\n";
-    
-    cout << "========================================\n";
-    cout << "     Thank you for choosing our airline!\n";
-    cout << "========================================\n";
+    float totalFare = farePerSeat * booking.seatsBooked;
+    
+    out << "Distance (" << flight.distance << " km): $" << distanceFare << "\n";
+    out << "Class Multiplier (" << cabinName(booking.cabin) << "): " << classMultiplier << "x\n";
+    out << "Fare per seat: $" << fixed << setprecision(2) << farePerSeat << "\n";
+    out << "Number of seats: " << booking.seatsBooked << "\n";
+    out << "------------------------------------------------\n";
+    out << "TOTAL FARE: $" << fixed << setprecision(2) << totalFare << "\n\n";
+    
+    out << "------------------------------------------------\n";
+    out << "BOOKING STATUS: " << BOOKING_STATUS_NAMES[booking.status] << "\n";
+    out << "------------------------------------------------\n\n";
+    
+    out << "Terms & Conditions:\n";
+    out << "1. This receipt is proof of booking.\n";
+    out << "2. Cancellation charges apply as per policy.\n";
+    out << "3. Please arrive 2 hours before departure.\n";
+    out << "4. Carry valid ID proof for verification.\n\n";
+    
+    out << "========================================\n";
+    out << "     Thank you for choosing our airline!\n";
+    out << "========================================\n";
 }
 
 
-// ========== SEARCH FUNCTIONS ==========
 
-Booking* findBookingById(int bookingId, int& index) {
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].bookingId == bookingId && 
-            bookings[i].passengerId == currentPassengerId) {
-            index = i;
-            return &bookings[i];
+// ========== AVAILABILITY CACHE ==========
+
+// Bookable flights pre-rendered as rows of the availability table and grouped
+// by route and departure date. Writers mark the flights they touched, and the
+// transaction re-renders the buckets those flights left or joined before it
+// ends and publishes a new view, so searches neither scan nor format the
+// flight table and never wait for storeMutex. Buckets are kept in sorted
+// chunks; a new view copies the chunk list and the chunks it changes and
+// shares every other chunk and bucket with the view before it.
+struct AvailabilityBucket {
+    string key;               // origin|destination|yyyymmdd
+    string rows;              // rendered table rows, one per flight
+    vector<size_t> rowEnds;   // end of each row in rows, so pages can start mid-bucket
+    vector<int> flightNos;
+};
+
+const size_t AVAILABILITY_CHUNK_BUCKETS = 64;   // a chunk is split at twice this
+
+struct AvailabilityChunk {
+    vector<shared_ptr<const AvailabilityBucket>> buckets;   // sorted by key
+};
+
+struct AvailabilityView {
+    vector<shared_ptr<const AvailabilityChunk>> chunks;   // in key order, none empty
+    size_t bucketCount = 0;
+    
+    // Calls visit(bucket) on the buckets from the first key not below from
+    // on, in key order, until visit returns false
+    template <typename Visit>
+    void forEachFrom(string_view from, Visit visit) const {
+        auto chunk = upper_bound(chunks.begin(), chunks.end(), from,
+            [](string_view key, const shared_ptr<const AvailabilityChunk>& c) { return key < c->buckets.front()->key; });
+        if (chunk != chunks.begin()) --chunk;
+        for (; chunk != chunks.end(); ++chunk) {
+            const auto& buckets = (*chunk)->buckets;
+            auto it = lower_bound(buckets.begin(), buckets.end(), from,
+                [](const shared_ptr<const AvailabilityBucket>& b, string_view key) { return b->key < key; });
+            for (; it != buckets.end(); ++it) {
+                if (!visit(**it)) return;
+            }
         }
     }
-    return nullptr;
-}
+};
 
-Flight* findFlightByNumber(int flightNo, int& index) {
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].flightNo == flightNo) {
-            index = i;
-            return &flights[i];
-        }
+shared_ptr<const AvailabilityView> availabilityView = make_shared<const AvailabilityView>();
+
+// Writer-side state, guarded by storeMutex
+vector<int> staleAvailabilitySlots;
+bool availabilitySlotStale[MAX_FLIGHTS];
+string availabilitySlotKeys[MAX_FLIGHTS];      // bucket each slot is listed in, empty if not bookable
+map<string, vector<int>> availabilityMembers;   // slots listed in each bucket
+
+// Records that a flight's row may have changed; the transaction publishes it.
+// The caller holds storeMutex.
+void markAvailabilityStale(int slot) {
+    if (!availabilitySlotStale[slot]) {
+        availabilitySlotStale[slot] = true;
+        staleAvailabilitySlots.push_back(slot);
     }
-    return nullptr;
 }
 
-// ========== VIEW FUNCTIONS ==========
+string availabilityKey(const Flight& flight) {
+    char date[16];
+    snprintf(date, sizeof(date), "%04d%02d%02d", flight.departureDate.year,
+             flight.departureDate.month, flight.departureDate.day);
+    return string(cityName(flight.origin)) + '|' + cityName(flight.destination) + '|' + date;
+}
 
+void renderAvailabilityRow(const Flight& flight, ostringstream& out) {
+    string dateStr = to_string(flight.departureDate.day) + "/" +
+                     to_string(flight.departureDate.month);
+    string timeStr = to_string(flight.departureTime.hour) + ":" +
+                     (flight.departureTime.minute < 10 ? "0" : "") +
+                     to_string(flight.departureTime.minute);
+    
+    out << left 
+        << setw(8) << flight.flightNo
+        << setw(12) << cityName(flight.origin)
+        << setw(12) << cityName(flight.destination)
+        << setw(10) << dateStr
+        << setw(8) << timeStr;
+    for (int c = 0; c < CABIN_COUNT; c++) out << setw(8) << flight.classSeats[c];
+    out << setw(10) << "$" + to_string(flight.baseFare)
+        << setw(12) << FLIGHT_STATUS_NAMES[flight.status] << "\n";
+}
 
-void viewAvailableFlights() {
-    cout << "\n=== AVAILABLE FLIGHTS ===\n";
-    
-    if (flightCount == 0) {
-        cout << "Sorry! No flights available at the moment.\n";
-        return;
+// Re-renders the buckets touched by stale flights and publishes a new view.
+// Only the chunks holding those buckets are copied. The caller holds storeMutex.
+void refreshAvailability() {
+    if (staleAvailabilitySlots.empty()) return;
+    
+    vector<string> touched;
+    for (int slot : staleAvailabilitySlots) {
+        availabilitySlotStale[slot] = false;
+        const Flight& flight = flights[slot];
+        string key = (isOpenForBooking(flight) && flight.availableSeats > 0) ? availabilityKey(flight) : "";
+        string& current = availabilitySlotKeys[slot];
+        if (!current.empty()) {
+            touched.push_back(current);
+            if (key != current) {
+                vector<int>& members = availabilityMembers[current];
+                members.erase(find(members.begin(), members.end(), slot));
+            }
+        }
+        if (!key.empty()) {
+            touched.push_back(key);
+            if (key != current) availabilityMembers[key].push_back(slot);
+        }
+        current = key;
     }
-    
-    cout << left 
-         << setw(8) << "Flight #" 
-         << setw(12) << "From" 
-         << setw(12) << "To"
-         << setw(10) << "Date"
-         << setw(8) << "Time"
-         << setw(8) << "Eco" 
-         << setw(8) << "Bus" 
-         << setw(8) << "First"
-         << setw(10) << "Fare/km"
-         << setw(12) << "Status" << "\n";
-    cout << string(100, '-') << "\n";
-    
-    bool hasAvailable = false;
-    for (int i = 0; i < flightCount; i++) {
-        if (strcmp(flights[i].status, "Available") == 0) {
-            hasAvailable = true;
-            
-            // Get seat counts for each class
-            int ecoSeats = flights[i].economySeats;
-            int busSeats = flights[i].businessSeats;
-            int firstSeats = flights[i].firstClassSeats;
-            
-            // Format date and time
-            string dateStr = to_string(flights[i].departureDate.day) + "/" +
-                           to_string(flights[i].departureDate.month);
-            string timeStr = to_string(flights[i].departureTime.hour) + ":" +
-                           (flights[i].departureTime.minute < 10 ? "0" : "") +
-                           to_string(flights[i].departureTime.minute);
-            
-            cout << left 
-                 << setw(8) << flights[i].flightNo
-                 << setw(12) << flights[i].origin
-                 << setw(12) << flights[i].destination
-                 << setw(10) << dateStr
-                 << setw(8) << timeStr
-                 << setw(8) << ecoSeats
-                 << setw(8) << busSeats
-                 << setw(8) << firstSeats
-                 << setw(10) << "$" + to_string(flights[i].baseFare)
-                 << setw(12) << flights[i].status << "\n";
+    staleAvailabilitySlots.clear();
+    sort(touched.begin(), touched.end());
+    touched.erase(unique(touched.begin(), touched.end()), touched.end());
+    
+    auto next = make_shared<AvailabilityView>(*atomic_load(&availabilityView));
+    vector<shared_ptr<const AvailabilityChunk>>& chunks = next->chunks;
+    vector<AvailabilityChunk*> copied(chunks.size(), nullptr);   // chunks already copied for this view
+    for (const string& key : touched) {
+        auto byKey = [](const shared_ptr<const AvailabilityBucket>& b, const string& k) { return b->key < k; };
+        size_t c = upper_bound(chunks.begin(), chunks.end(), key,
+            [](const string& k, const shared_ptr<const AvailabilityChunk>& chunk) { return k < chunk->buckets.front()->key; })
+            - chunks.begin();
+        if (c > 0) c--;
+        
+        vector<int>& members = availabilityMembers[key];
+        if (members.empty()) {
+            availabilityMembers.erase(key);
+            if (chunks.empty()) continue;
+            const auto& buckets = chunks[c]->buckets;
+            auto it = lower_bound(buckets.begin(), buckets.end(), key, byKey);
+            if (it == buckets.end() || (*it)->key != key) continue;
+            if (!copied[c]) {
+                auto copy = make_shared<AvailabilityChunk>(*chunks[c]);
+                copied[c] = copy.get();
+                chunks[c] = copy;
+            }
+            auto& own = copied[c]->buckets;
+            own.erase(own.begin() + (it - buckets.begin()));
+            next->bucketCount--;
+            if (own.empty()) {
+                chunks.erase(chunks.begin() + c);
+                copied.erase(copied.begin() + c);
+            }
+            continue;
+        }
+        
+        sort(members.begin(), members.end());
+        auto bucket = make_shared<AvailabilityBucket>();
+        bucket->key = key;
+        ostringstream rows;
+        for (int slot : members) {
+            renderAvailabilityRow(flights[slot], rows);
+            bucket->rowEnds.push_back(rows.tellp());
+            bucket->flightNos.push_back(flights[slot].flightNo);
+        }
+        bucket->rows = rows.str();
+        
+        if (chunks.empty()) {
+            auto first = make_shared<AvailabilityChunk>();
+            copied.push_back(first.get());
+            chunks.push_back(first);
+        }
+        if (!copied[c]) {
+            auto copy = make_shared<AvailabilityChunk>(*chunks[c]);
+            copied[c] = copy.get();
+            chunks[c] = copy;
+        }
+        auto& own = copied[c]->buckets;
+        auto it = lower_bound(own.begin(), own.end(), key, byKey);
+        if (it != own.end() && (*it)->key == key) {
+            *it = bucket;
+        } else {
+            own.insert(it, bucket);
+            next->bucketCount++;
         }
     }
     
-    if (!hasAvailable) {
-        cout << "No available flights at the moment.\n";
+    // Split the chunks that grew too long, keeping lookups and copies short
+    for (size_t c = 0; c < chunks.size(); c++) {
+        if (!copied[c] || copied[c]->buckets.size() <= 2 * AVAILABILITY_CHUNK_BUCKETS) continue;
+        auto& own = copied[c]->buckets;
+        auto tail = make_shared<AvailabilityChunk>();
+        tail->buckets.assign(own.begin() + own.size() / 2, own.end());
+        own.resize(own.size() / 2);
+        chunks.insert(chunks.begin() + c + 1, tail);
+        copied.insert(copied.begin() + c + 1, tail.get());
     }
-    
-    cout << "\nLegend: Eco=Economy, Bus=Business, Fare/km=Base fare per 100 km\n";
+    atomic_store(&availabilityView, shared_ptr<const AvailabilityView>(next));
 }
 
+// Returns the view published by the last transaction that touched a flight
+shared_ptr<const AvailabilityView> currentAvailability() {
+    return atomic_load(&availabilityView);
+}
 
-void viewFlights(Flight flights[], int flightCount) {
-    if (flightCount == 0) {
-        cout << "\nNo flights available.\n";
-        return;
+// ========== MULTI-VERSION READS ==========
+
+// Every write transaction on the stores gets the next store version, and each
+// flight and booking slot is stamped with the version that last wrote it. A
+// snapshot reads the stores as of one version: a slot stamped later is read
+// from the undo log, which keeps each image a writer replaced for as long as
+// an open snapshot may still need it. Writers copy into the log only while a
+// snapshot is open. List links (firstBooking, nextOnFlight, nextInPartition)
+// are not versioned, so snapshots scan slots rather than walk lists.
+template <typename Record>
+struct UndoImage {
+    unsigned validFrom;    // version that wrote the image
+    unsigned replacedAt;   // version that overwrote it
+    Record image;
+};
+
+atomic<unsigned> storeVersion(0);   // last committed write transaction
+unsigned writingVersion = 0;        // version of the transaction holding storeMutex
+atomic<unsigned> flightVersions[MAX_FLIGHTS];
+atomic<unsigned> bookingVersions[MAX_BOOKINGS];
+multiset<unsigned> openSnapshots;   // guarded by storeMutex
+
+mutex undoMutex;
+map<int, vector<UndoImage<Flight>>> flightUndo;
+map<int, vector<UndoImage<Booking>>> bookingUndo;
+
+// Holds storeMutex for one write transaction and commits its version on exit
+class StoreTransaction {
+public:
+    StoreTransaction() : lock(storeMutex) {
+        writingVersion = storeVersion.load(memory_order_relaxed) + 1;
     }
+    ~StoreTransaction() {
+        refreshAvailability();
+        storeVersion.store(writingVersion, memory_order_release);
+    }
+private:
+    lock_guard<mutex> lock;
+};
 
-    cout << "\n========== AVAILABLE FLIGHTS ==========\n";
+// Stamps a slot before its first change in the current transaction, keeping
+// the image it replaces if an open snapshot might still read it
+template <typename Record>
+void versionRecord(Record store[], atomic<unsigned> versions[],
+                   map<int, vector<UndoImage<Record>>>& undo, int slot) {
+    unsigned stamped = versions[slot].load(memory_order_relaxed);
+    if (stamped == writingVersion) return;
+    if (!openSnapshots.empty() && *openSnapshots.rbegin() >= stamped) {
+        lock_guard<mutex> lock(undoMutex);
+        undo[slot].push_back({stamped, writingVersion, store[slot]});
+    }
+    versions[slot].store(writingVersion, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
 
-    for (int i = 0; i < flightCount; i++) {
-        cout << "\n--------------------------------------\n";
-        cout << "Flight Number   : " << flights[i].flightNo << endl;
-        cout << "Origin          : " << flights[i].origin << endl;
-        cout << "Destination     : " << flights[i].destination << endl;
-        cout << "Departure Date  : " << flights[i].departureDate.day << "/"
-             << flights[i].departureDate.month << "/" << flights[i].departureDate.year << endl;
-        cout << "Departure Time  : " << flights[i].departureTime.hour << ":"
-             << flights[i].departureTime.minute << endl;
-        cout << "Arrival Date    : " << flights[i].arrivalDate.day << "/"
-             << flights[i].arrivalDate.month << "/" << flights[i].arrivalDate.year << endl;
-        cout << "Arrival Time    : " << flights[i].arrivalTime.hour << ":"
-             << flights[i].arrivalTime.minute << endl;
-        cout << "\n--- Seats & Fares ---\n";
-        cout << "Economy Seats   : " << flights[i].economySeats
-             << " | Fare: " << flights[i].economyFare << endl;
-        cout << "Business Seats  : " << flights[i].businessSeats
-             << " | Fare: " << flights[i].businessFare << endl;
-        cout << "First Class Seats: " << flights[i].firstClassSeats
-             << " | Fare: " << flights[i].firstClassFare << endl;
-        cout << "\nTotal Seats     : " << flights[i].totalSeats << endl;
-        cout << "Available Seats : " << flights[i].availableSeats << endl;
-        cout << "Distance        : " << flights[i].distance << " km" << endl;
-        cout << "Status          : " << flights[i].status << endl;
-        cout << "Times Booked    : " << flights[i].timesBooked << endl;
-        cout << "Total Revenue   : " << flights[i].totalRevenue << endl;
-    }
-    cout << "\n======================================\n";
+void versionFlight(int slot) {
+    versionRecord(flights, flightVersions, flightUndo, slot);
 }
 
-void viewAllBookings() {
-    cout << "\n=== ALL BOOKINGS ===\n";
-    
-    if (bookingCount == 0) {
-        cout << "No bookings found.\n";
-        return;
+void versionBooking(int slot) {
+    versionRecord(bookings, bookingVersions, bookingUndo, slot);
+}
+
+// Copies a slot as it was at the given version. A copy a writer overlapped is
+// retried; a slot stamped after the version is read from the undo log. If the
+// log has no image for it, the slot is copied under storeMutex, so out never
+// holds a torn record. The caller must not hold storeMutex.
+template <typename Record>
+void readRecordVersion(const Record store[], const atomic<unsigned> versions[],
+                       map<int, vector<UndoImage<Record>>>& undo, int slot, unsigned version, Record& out) {
+    unsigned before;
+    while ((before = versions[slot].load(memory_order_acquire)) <= version) {
+        out = store[slot];
+        atomic_thread_fence(memory_order_acquire);
+        if (versions[slot].load(memory_order_relaxed) == before) return;
     }
-    
-    cout << left << setw(12) << "Booking ID"
-         << setw(15) << "Passenger ID"
-         << setw(10) << "Flight #"
-         << setw(12) << "Travel Date"
-         << setw(10) << "Seats"
-         << setw(12) << "Class"
-         << setw(12) << "Fare Paid($)"
-         << setw(12) << "Status" << "\n";
-    
-    for (int i = 0; i < bookingCount; i++) {
-        string travelDateStr = to_string(bookings[i].travelDate.day) + "/" +
-                              to_string(bookings[i].travelDate.month) + "/" +
-                              to_string(bookings[i].travelDate.year);
-        
-        cout << left << setw(12) << bookings[i].bookingId
-             << setw(15) << bookings[i].passengerId
-             << setw(10) << bookings[i].flightNo
-             << setw(12) << travelDateStr
-             << setw(10) << bookings[i].seatsBooked
-             << setw(12) << bookings[i].classType
-             << setw(12) << fixed << setprecision(2) << bookings[i].farePaid
-             << setw(12) << bookings[i].status << "\n";
+    {
+        lock_guard<mutex> lock(undoMutex);
+        auto images = undo.find(slot);
+        if (images != undo.end()) {
+            for (const UndoImage<Record>& entry : images->second) {
+                if (entry.validFrom <= version && version < entry.replacedAt) {
+                    out = entry.image;
+                    return;
+                }
+            }
+        }
     }
+    lock_guard<mutex> lock(storeMutex);
+    out = store[slot];
 }
 
-// ========== BOOKING FUNCTIONS ==========
-
-void bookFlight() {
-    if (currentPassengerId == -1) {
-        cout << "You must login first!\n";
+// Drops undo images no open snapshot can read. The caller holds storeMutex.
+void pruneUndoLog() {
+    lock_guard<mutex> lock(undoMutex);
+    if (openSnapshots.empty()) {
+        flightUndo.clear();
+        bookingUndo.clear();
         return;
     }
-    
-    cout << "\n=== BOOK A FLIGHT ===\n";
-    viewAvailableFlights();
-    
-    if (flightCount == 0) {
-        cout << "No flights available to book.\n";
-        return;
+    unsigned oldest = *openSnapshots.begin();
+    auto prune = [oldest](auto& undo) {
+        for (auto it = undo.begin(); it != undo.end();) {
+            auto& images = it->second;
+            images.erase(remove_if(images.begin(), images.end(),
+                                   [oldest](const auto& entry) { return entry.replacedAt <= oldest; }),
+                         images.end());
+            it = images.empty() ? undo.erase(it) : next(it);
+        }
+    };
+    prune(flightUndo);
+    prune(bookingUndo);
+}
+
+// A consistent point-in-time view of the flight and booking stores for long
+// reads. Opening and closing one takes storeMutex briefly; reading through it
+// never does.
+class StoreSnapshot {
+public:
+    StoreSnapshot() {
+        lock_guard<mutex> lock(storeMutex);
+        version = storeVersion.load(memory_order_relaxed);
+        flightSlots = flightCount;
+        bookingSlots = bookingCount;
+        openSnapshots.insert(version);
     }
-    
-    int flightChoice;
-    cout << "\nEnter Flight Number to book (0 to cancel): ";
-    cin >> flightChoice;
-    
-    if (flightChoice == 0) return;
-    
-    Flight* selectedFlight = nullptr;
-    int flightIndex = -1;
-    
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].flightNo == flightChoice && 
-            strcmp(flights[i].status, "Available") == 0) {
-            selectedFlight = &flights[i];
-            flightIndex = i;
-            break;
+    ~StoreSnapshot() {
+        lock_guard<mutex> lock(storeMutex);
+        openSnapshots.erase(openSnapshots.find(version));
+        pruneUndoLog();
+    }
+    void readFlight(int slot, Flight& out) const {
+        readRecordVersion(flights, flightVersions, flightUndo, slot, version, out);
+    }
+    void readBooking(int slot, Booking& out) const {
+        readRecordVersion(bookings, bookingVersions, bookingUndo, slot, version, out);
+    }
+    // Finds a flight by number among the snapshot's own slots; the live
+    // flight index may already point somewhere the snapshot cannot see
+    bool findFlight(int flightNo, Flight& out) const {
+        for (int slot = 0; slot < flightSlots; slot++) {
+            readFlight(slot, out);
+            if (!out.deleted && out.flightNo == flightNo) return true;
         }
+        return false;
     }
     
-    if (!selectedFlight) {
-        cout << "Invalid flight selection or flight not available!\n";
-        return;
+    int flightSlots;    // flights[] slots in use when the snapshot was taken
+    int bookingSlots;   // bookings[] slots in use when the snapshot was taken
+private:
+    unsigned version;
+};
+
+// ========== AUDIT LOG ==========
+
+// Every booking, cancellation, flight change and profile change is appended
+// to an audit log as a fixed-size binary record. Each record carries the
+// SHA-256 of the previous record's hash followed by its own fields, so
+// editing, removing or reordering any record breaks the chain from that
+// point on. Records are written by the store event consumer in batches, off
+// the booking path. --audit-verify checks a log, --audit-query searches it.
+enum AuditActor {
+    AUDIT_ACTOR_SYSTEM = -1,   // sweeps, replays, anonymous registration
+    AUDIT_ACTOR_ADMIN = 0      // passenger actors are their passenger ID
+};
+
+// Who the current thread is acting for
+thread_local int auditActor = AUDIT_ACTOR_SYSTEM;
+
+struct AuditRecord {
+    unsigned long long sequence;   // position in the log, from 1
+    long long timeMicros;          // wall clock, microseconds since the epoch
+    int actor;
+    int subject;                   // booking ID, flight number or passenger ID
+    int flightNo;
+    int passengerId;
+    int quantity;                  // seats, or the FlightUpdateField mask
+    int amountCents;
+    unsigned char action;          // StoreEventKind
+    char detail[23];               // class, status, route or profile field
+    unsigned char hash[32];
+};
+static_assert(sizeof(AuditRecord) == 96, "audit records are 96 bytes on disk");
+const size_t AUDIT_HASHED_BYTES = offsetof(AuditRecord, hash);
+
+const char* const AUDIT_ACTION_NAMES[] = {
+    "booked", "cancelled", "rebooked", "flight_added", "flight_updated",
+    "flight_deleted", "flight_status", "passenger_registered", "profile_updated", "completed"
+};
+const int AUDIT_ACTION_COUNT = sizeof(AUDIT_ACTION_NAMES) / sizeof(AUDIT_ACTION_NAMES[0]);
+
+// SHA-256 (FIPS 180-4), enough for chaining audit records
+struct Sha256 {
+    unsigned int state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    unsigned char block[64];
+    size_t blockUsed = 0;
+    unsigned long long totalBytes = 0;
+    
+    static unsigned int rotate(unsigned int x, int n) { return (x >> n) | (x << (32 - n)); }
+    
+    void compress() {
+        static const unsigned int K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        unsigned int w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (unsigned int)block[i * 4] << 24 | (unsigned int)block[i * 4 + 1] << 16 |
+                   (unsigned int)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            unsigned int s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            unsigned int s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        unsigned int a = state[0], b = state[1], c = state[2], d = state[3];
+        unsigned int e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            unsigned int t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            unsigned int t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
     }
     
-    // Check available seats
-    if (selectedFlight->availableSeats <= 0) {
-        cout << "Sorry, this flight is fully booked!\n";
-        return;
+    void update(const void* data, size_t length) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        totalBytes += length;
+        while (length > 0) {
+            size_t take = min(length, sizeof(block) - blockUsed);
+            memcpy(block + blockUsed, bytes, take);
+            blockUsed += take;
+            bytes += take;
+            length -= take;
+            if (blockUsed == sizeof(block)) {
+                compress();
+                blockUsed = 0;
+            }
+        }
     }
     
-    int seats;
-    cout << "Number of seats to book (1-" << selectedFlight->availableSeats << "): ";
-    cin >> seats;
-    
-    while (seats < 1 || seats > selectedFlight->availableSeats) {
-        cout << "Invalid! Enter between 1 and " << selectedFlight->availableSeats << " seats: ";
-        cin >> seats;
+    void finish(unsigned char digest[32]) {
+        unsigned long long bits = totalBytes * 8;
+        unsigned char padding = 0x80;
+        update(&padding, 1);
+        padding = 0;
+        while (blockUsed != 56) update(&padding, 1);
+        for (int i = 7; i >= 0; i--) {
+            unsigned char byte = (unsigned char)(bits >> (i * 8));
+            update(&byte, 1);
+        }
+        for (int i = 0; i < 8; i++) {
+            for (int j = 0; j < 4; j++) digest[i * 4 + j] = (unsigned char)(state[i] >> (24 - j * 8));
+        }
     }
-    
-    cout << "\nSelect Class Type:\n";
-    cout << "1. Economy (1.0x)\n";
-    cout << "2. Business (2.0x)\n";
-    cout << "3. First Class (3.5x)\n";
-    
-    int classChoice;
-    cout << "Enter choice (1-3): ";
-    cin >> classChoice;
-    
-    string classType;
-    int classSeatsAvailable = 0;
-    
-    switch(classChoice) {
-        case 1: 
-            classType = "Economy";
-            classSeatsAvailable = selectedFlight->economySeats;
-            break;
-        case 2: 
-            classType = "Business";
-            classSeatsAvailable = selectedFlight->businessSeats;
-            break;
-        case 3: 
-            classType = "First";
-            classSeatsAvailable = selectedFlight->firstClassSeats;
-            break;
-        default: 
-            cout << "Invalid choice! Defaulting to Economy.\n";
-            classType = "Economy";
-            classSeatsAvailable = selectedFlight->economySeats;
+};
+
+void chainAuditRecord(const unsigned char previous[32], AuditRecord& record) {
+    Sha256 sha;
+    sha.update(previous, 32);
+    sha.update(&record, AUDIT_HASHED_BYTES);
+    sha.finish(record.hash);
+}
+
+// Writer state, touched only by the store event consumer
+string auditLogPath = "airline_audit.log";   // empty to disable
+ofstream auditLog;
+unsigned char auditChainHash[32];
+unsigned long long auditSequence = 0;
+
+// Opens the log for appending and picks the chain up from its last record.
+// A partial record left by a crash mid-write is cut off.
+bool openAuditLog() {
+    memset(auditChainHash, 0, sizeof(auditChainHash));
+    auditSequence = 0;
+    ifstream existing(auditLogPath, ios::binary | ios::ate);
+    if (existing) {
+        long long size = existing.tellg();
+        long long whole = size - size % sizeof(AuditRecord);
+        if (whole != size) {
+            cerr << "Audit log " << auditLogPath << " ends in a partial record; truncating it\n";
+            existing.close();
+            if (truncate(auditLogPath.c_str(), whole) != 0) return false;
+            existing.open(auditLogPath, ios::binary);
+        }
+        if (whole > 0) {
+            AuditRecord last;
+            existing.seekg(whole - sizeof(AuditRecord));
+            existing.read((char*)&last, sizeof(last));
+            memcpy(auditChainHash, last.hash, sizeof(auditChainHash));
+            auditSequence = last.sequence;
+        }
+    }
+    auditLog.open(auditLogPath, ios::binary | ios::app);
+    return (bool)auditLog;
+}
+
+void appendAuditRecords(vector<AuditRecord>& records) {
+    if (auditLogPath.empty() || records.empty()) return;
+    if (!auditLog.is_open() && !openAuditLog()) {
+        cerr << "Cannot write audit log " << auditLogPath << "\n";
+        auditLogPath.clear();
+        return;
+    }
+    for (AuditRecord& record : records) {
+        record.sequence = ++auditSequence;
+        chainAuditRecord(auditChainHash, record);
+        memcpy(auditChainHash, record.hash, sizeof(auditChainHash));
+    }
+    auditLog.write((const char*)records.data(), records.size() * sizeof(AuditRecord));
+    auditLog.flush();
+}
+
+string formatAuditRecord(const AuditRecord& record) {
+    time_t seconds = record.timeMicros / 1000000;
+    tm local;
+    localtime_r(&seconds, &local);
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &local);
+    ostringstream out;
+    out << record.sequence << '\t' << when << '.' << setfill('0') << setw(6) << record.timeMicros % 1000000
+        << setfill(' ') << '\t';
+    if (record.actor == AUDIT_ACTOR_ADMIN) out << "admin";
+    else if (record.actor == AUDIT_ACTOR_SYSTEM) out << "system";
+    else out << "passenger " << record.actor;
+    out << '\t' << (record.action < AUDIT_ACTION_COUNT ? AUDIT_ACTION_NAMES[record.action] : "unknown")
+        << "\tsubject=" << record.subject;
+    if (record.flightNo) out << "\tflight=" << record.flightNo;
+    if (record.passengerId) out << "\tpassenger=" << record.passengerId;
+    if (record.quantity) out << "\tquantity=" << record.quantity;
+    if (record.amountCents) {
+        out << "\tamount=" << record.amountCents / 100 << '.' << setfill('0') << setw(2) << abs(record.amountCents % 100);
+    }
+    if (record.detail[0]) out << '\t' << string(record.detail, strnlen(record.detail, sizeof(record.detail)));
+    return out.str();
+}
+
+// Usage: --audit-verify FILE
+// Walks the whole chain and reports the first record that does not match.
+int runAuditVerify(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: --audit-verify FILE\n";
+        return 1;
+    }
+    ifstream log(argv[2], ios::binary);
+    if (!log) {
+        cerr << "Cannot read audit log " << argv[2] << "\n";
+        return 1;
+    }
+    unsigned char previous[32] = {};
+    AuditRecord record;
+    unsigned long long records = 0;
+    string problem;
+    while (problem.empty() && log.read((char*)&record, sizeof(record))) {
+        records++;
+        AuditRecord expected = record;
+        chainAuditRecord(previous, expected);
+        if (record.sequence != records) problem = "sequence";
+        else if (memcmp(expected.hash, record.hash, sizeof(record.hash)) != 0) problem = "hash";
+        memcpy(previous, record.hash, sizeof(previous));
+    }
+    if (problem.empty() && log.gcount() != 0) {
+        records++;
+        problem = "partial_record";
+    }
+    cout << "{\"audit\":\"verify\",\"records\":" << (problem.empty() ? records : records - 1)
+         << ",\"valid\":" << (problem.empty() ? "true" : "false");
+    if (!problem.empty()) cout << ",\"first_bad_record\":" << records << ",\"reason\":\"" << problem << "\"";
+    cout << "}" << endl;
+    return problem.empty() ? 0 : 3;
+}
+
+// Usage: --audit-query FILE [--actor admin|system|ID] [--action NAME] [--subject N]
+//                           [--flight N] [--passenger N] [--since YYYY-MM-DD] [--until YYYY-MM-DD]
+int runAuditQuery(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: --audit-query FILE [--actor admin|system|ID] [--action NAME] [--subject N]\n"
+             << "                          [--flight N] [--passenger N] [--since YYYY-MM-DD] [--until YYYY-MM-DD]\n";
+        return 1;
+    }
+    bool byActor = false, byAction = false, bySubject = false, byFlight = false, byPassenger = false;
+    int actor = 0, action = 0, subject = 0, flightNo = 0, passengerId = 0;
+    long long since = LLONG_MIN, until = LLONG_MAX;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        string value = argv[i + 1];
+        if (option == "--actor") {
+            byActor = true;
+            actor = value == "admin" ? AUDIT_ACTOR_ADMIN : value == "system" ? AUDIT_ACTOR_SYSTEM : atoi(value.c_str());
+        }
+        else if (option == "--action") {
+            byAction = true;
+            action = find(AUDIT_ACTION_NAMES, AUDIT_ACTION_NAMES + AUDIT_ACTION_COUNT, value) - AUDIT_ACTION_NAMES;
+        }
+        else if (option == "--subject") { bySubject = true; subject = atoi(value.c_str()); }
+        else if (option == "--flight") { byFlight = true; flightNo = atoi(value.c_str()); }
+        else if (option == "--passenger") { byPassenger = true; passengerId = atoi(value.c_str()); }
+        else if (option == "--since" || option == "--until") {
+            tm day = {};
+            if (sscanf(value.c_str(), "%d-%d-%d", &day.tm_year, &day.tm_mon, &day.tm_mday) != 3) {
+                cerr << "Dates are YYYY-MM-DD\n";
+                return 1;
+            }
+            day.tm_year -= 1900;
+            day.tm_mon -= 1;
+            day.tm_isdst = -1;
+            long long micros = (long long)mktime(&day) * 1000000;
+            if (option == "--since") since = micros;
+            else until = micros + 86400LL * 1000000;   // through the end of that day
+        }
+    }
+    ifstream log(argv[2], ios::binary);
+    if (!log) {
+        cerr << "Cannot read audit log " << argv[2] << "\n";
+        return 1;
+    }
+    AuditRecord record;
+    while (log.read((char*)&record, sizeof(record))) {
+        if ((byActor && record.actor != actor) || (byAction && record.action != action) ||
+            (bySubject && record.subject != subject) || (byFlight && record.flightNo != flightNo) ||
+            (byPassenger && record.passengerId != passengerId) ||
+            record.timeMicros < since || record.timeMicros >= until) {
+            continue;
+        }
+        cout << formatAuditRecord(record) << "\n";
+    }
+    return 0;
+}
+
+// ========== STORE EVENTS ==========
+
+// Side effects of a store mutation (passenger totals, the rendered receipt,
+// the audit log) run on a consumer thread instead of inside the commit.
+// Commits push an event onto a lock-free multi-producer queue
+// (Vyukov's intrusive MPSC queue: producers swap the head, the single
+// consumer follows next pointers from the tail); the consumer drains it in
+// batches and hands each batch to every handler in turn.
+// In AUDIT_ACTION_NAMES order
+enum StoreEventKind : unsigned char {
+    EVENT_BOOKED,
+    EVENT_CANCELLED,
+    EVENT_REBOOKED,
+    EVENT_FLIGHT_ADDED,
+    EVENT_FLIGHT_UPDATED,
+    EVENT_FLIGHT_DELETED,
+    EVENT_FLIGHT_STATUS,
+    EVENT_PASSENGER_REGISTERED,
+    EVENT_PROFILE_UPDATED,
+    EVENT_COMPLETED
+};
+
+struct StoreEvent {
+    StoreEventKind kind;
+    int actor;         // auditActor of the thread that made the change
+    long long timeMicros;
+    Booking booking;   // as committed
+    Flight flight;     // as of the commit, for the receipt
+    float amount;      // fare paid, or refund
+    int quantity;      // FlightUpdateField mask for flight updates
+    char detail[23];
+};
+
+struct StoreEventNode {
+    atomic<StoreEventNode*> next;
+    StoreEvent event;
+};
+
+const int STORE_EVENT_BATCH = 256;
+const int RENDERED_RECEIPT_LIMIT = 1024;
+const size_t RECEIPT_SIZE_HINT = 2048;   // a rendered receipt is about 1.5 KB
+
+StoreEventNode storeEventStub;
+atomic<StoreEventNode*> storeEventHead(&storeEventStub);
+StoreEventNode* storeEventTail = &storeEventStub;   // consumer only
+atomic<unsigned long long> storeEventsPublished(0);
+atomic<unsigned long long> storeEventsHandled(0);
+atomic<bool> storeEventConsumerIdle(false);
+atomic<bool> storeEventsRunning(false);
+mutex storeEventMutex;
+condition_variable storeEventWakeup;
+condition_variable storeEventsDrained;
+bool storeEventsStopping = false;
+thread storeEventThread;
+
+// Nodes the consumer has finished with, reused by the next commits so that
+// publishing an event does not allocate once the pool has grown to the
+// number of events in flight
+mutex storeEventPoolMutex;
+vector<StoreEventNode*> storeEventPool;
+
+StoreEventNode* acquireStoreEventNode() {
+    {
+        lock_guard<mutex> lock(storeEventPoolMutex);
+        if (!storeEventPool.empty()) {
+            StoreEventNode* node = storeEventPool.back();
+            storeEventPool.pop_back();
+            node->event = StoreEvent();
+            return node;
+        }
+    }
+    return new StoreEventNode();
+}
+
+void releaseStoreEventNodes(const vector<StoreEventNode*>& nodes) {
+    lock_guard<mutex> lock(storeEventPoolMutex);
+    storeEventPool.insert(storeEventPool.end(), nodes.begin(), nodes.end());
+}
+
+// Receipts rendered by the consumer, waiting to be shown after booking
+mutex renderedReceiptMutex;
+map<int, string> renderedReceipts;
+
+void pushStoreEventNode(StoreEventNode* node) {
+    node->next.store(nullptr, memory_order_relaxed);
+    StoreEventNode* previous = storeEventHead.exchange(node, memory_order_acq_rel);
+    previous->next.store(node, memory_order_release);
+}
+
+// Takes the oldest event off the queue, or returns nullptr when the queue is
+// empty or a producer is half way through a push
+StoreEventNode* popStoreEventNode() {
+    StoreEventNode* tail = storeEventTail;
+    StoreEventNode* next = tail->next.load(memory_order_acquire);
+    if (tail == &storeEventStub) {
+        if (!next) return nullptr;
+        storeEventTail = next;
+        tail = next;
+        next = next->next.load(memory_order_acquire);
+    }
+    if (next) {
+        storeEventTail = next;
+        return tail;
+    }
+    if (tail != storeEventHead.load(memory_order_acquire)) return nullptr;
+    pushStoreEventNode(&storeEventStub);
+    next = tail->next.load(memory_order_acquire);
+    if (!next) return nullptr;
+    storeEventTail = next;
+    return tail;
+}
+
+void enqueueStoreEvent(StoreEventNode* node) {
+    node->event.actor = auditActor;
+    node->event.timeMicros = chrono::duration_cast<chrono::microseconds>(
+                                 chrono::system_clock::now().time_since_epoch()).count();
+    pushStoreEventNode(node);
+    storeEventsPublished.fetch_add(1, memory_order_release);
+    if (storeEventConsumerIdle.load(memory_order_acquire)) storeEventWakeup.notify_one();
+}
+
+// Called by the commit functions with the store locked; never blocks
+void publishStoreEvent(StoreEventKind kind, const Booking& booking, const Flight& flight, float amount) {
+    StoreEventNode* node = acquireStoreEventNode();
+    node->event.kind = kind;
+    node->event.booking = booking;
+    node->event.flight = flight;
+    node->event.amount = amount;
+    enqueueStoreEvent(node);
+}
+
+void publishFlightEvent(StoreEventKind kind, const Flight& flight, int quantity, const char* detail) {
+    StoreEventNode* node = acquireStoreEventNode();
+    node->event.kind = kind;
+    node->event.flight = flight;
+    node->event.quantity = quantity;
+    strncpy(node->event.detail, detail, sizeof(node->event.detail) - 1);
+    enqueueStoreEvent(node);
+}
+
+void publishPassengerEvent(StoreEventKind kind, int passengerId, const char* detail) {
+    StoreEventNode* node = acquireStoreEventNode();
+    node->event.kind = kind;
+    node->event.booking.passengerId = passengerId;
+    strncpy(node->event.detail, detail, sizeof(node->event.detail) - 1);
+    enqueueStoreEvent(node);
+}
+
+void applyPassengerTotals(const vector<StoreEvent>& batch) {
+    lock_guard<mutex> lock(storeMutex);
+    for (const StoreEvent& event : batch) {
+        Passenger* passenger = findPassengerById(event.booking.passengerId);
+        if (!passenger) continue;
+        if (event.kind == EVENT_BOOKED) {
+            passenger->totalBookings++;
+            passenger->totalSpent += event.amount;
+        }
+        else if (event.kind == EVENT_CANCELLED) {
+            passenger->totalBookings--;
+            passenger->totalSpent -= event.amount;
+        }
+    }
+}
+
+void renderBookingReceipts(const vector<StoreEvent>& batch) {
+    vector<pair<int, string>> rendered;
+    for (const StoreEvent& event : batch) {
+        Passenger* passenger = findPassengerById(event.booking.passengerId);
+        if (event.kind != EVENT_BOOKED || !passenger) continue;
+        RequestScope request;
+        ArenaStream receipt(RECEIPT_SIZE_HINT);
+        receipt << fixed << setprecision(2);   // as the booking screen leaves cout
+        renderReceipt(receipt, event.booking, event.flight, *passenger);
+        rendered.emplace_back(event.booking.bookingId, string(receipt.str()));
+    }
+    lock_guard<mutex> lock(renderedReceiptMutex);
+    for (auto& receipt : rendered) renderedReceipts[receipt.first] = move(receipt.second);
+    while ((int)renderedReceipts.size() > RENDERED_RECEIPT_LIMIT) renderedReceipts.erase(renderedReceipts.begin());
+}
+
+void writeAuditRecords(const vector<StoreEvent>& batch) {
+    if (auditLogPath.empty()) return;
+    vector<AuditRecord> records(batch.size());
+    for (size_t e = 0; e < batch.size(); e++) {
+        const StoreEvent& event = batch[e];
+        AuditRecord& record = records[e];
+        memset(&record, 0, sizeof(record));
+        record.timeMicros = event.timeMicros;
+        record.actor = event.actor;
+        record.action = event.kind;
+        record.passengerId = event.booking.passengerId;
+        record.amountCents = (int)lround(event.amount * 100);
+        record.quantity = event.quantity;
+        strncpy(record.detail, event.detail, sizeof(record.detail));
+        switch (event.kind) {
+            case EVENT_BOOKED:
+            case EVENT_CANCELLED:
+            case EVENT_REBOOKED:
+            case EVENT_COMPLETED:
+                record.subject = event.booking.bookingId;
+                record.flightNo = event.booking.flightNo;
+                record.quantity = event.booking.seatsBooked;
+                if (!event.detail[0]) strncpy(record.detail, cabinName(event.booking.cabin), sizeof(record.detail));
+                break;
+            case EVENT_PASSENGER_REGISTERED:
+            case EVENT_PROFILE_UPDATED:
+                record.subject = event.booking.passengerId;
+                break;
+            default:
+                record.subject = event.flight.flightNo;
+                record.flightNo = event.flight.flightNo;
+                break;
+        }
+    }
+    appendAuditRecords(records);
+}
+
+void consumeStoreEvents() {
+    vector<StoreEvent> batch;
+    vector<StoreEventNode*> handled;
+    batch.reserve(STORE_EVENT_BATCH);
+    handled.reserve(STORE_EVENT_BATCH);
+    while (true) {
+        StoreEventNode* node;
+        while ((int)batch.size() < STORE_EVENT_BATCH && (node = popStoreEventNode())) {
+            batch.push_back(node->event);
+            handled.push_back(node);
+        }
+        if (!handled.empty()) {
+            releaseStoreEventNodes(handled);
+            handled.clear();
+        }
+        if (!batch.empty()) {
+            applyPassengerTotals(batch);
+            renderBookingReceipts(batch);
+            writeAuditRecords(batch);
+            {
+                lock_guard<mutex> lock(storeEventMutex);
+                storeEventsHandled += batch.size();
+            }
+            storeEventsDrained.notify_all();
+            batch.clear();
+            continue;
+        }
+        
+        unique_lock<mutex> lock(storeEventMutex);
+        if (storeEventsStopping && storeEventsHandled == storeEventsPublished) break;
+        storeEventConsumerIdle = true;
+        storeEventWakeup.wait_for(lock, chrono::milliseconds(10), [] {
+            return storeEventsStopping || storeEventsPublished != storeEventsHandled;
+        });
+        storeEventConsumerIdle = false;
+    }
+}
+
+void startStoreEvents() {
+    if (storeEventThread.joinable()) return;
+    storeEventsStopping = false;
+    storeEventsRunning = true;
+    storeEventThread = thread(consumeStoreEvents);
+}
+
+// Handles everything published so far, then stops the consumer
+void stopStoreEvents() {
+    if (!storeEventThread.joinable()) return;
+    {
+        lock_guard<mutex> lock(storeEventMutex);
+        storeEventsStopping = true;
+    }
+    storeEventWakeup.notify_one();
+    storeEventThread.join();
+    storeEventsRunning = false;
+    storeEventsDrained.notify_all();
+    auditLog.close();
+}
+
+// Waits until every event published so far has been handled, so a passenger
+// reading their own totals sees their latest booking. Must not be called with
+// storeMutex held.
+void waitForStoreEvents() {
+    unsigned long long published = storeEventsPublished.load(memory_order_acquire);
+    unique_lock<mutex> lock(storeEventMutex);
+    storeEventsDrained.wait(lock, [published] {
+        return storeEventsHandled >= published || !storeEventsRunning;
+    });
+}
+
+// The receipt the consumer rendered for a new booking, removed once taken
+bool takeRenderedReceipt(int bookingId, string& receipt) {
+    lock_guard<mutex> lock(renderedReceiptMutex);
+    auto found = renderedReceipts.find(bookingId);
+    if (found == renderedReceipts.end()) return false;
+    receipt = move(found->second);
+    renderedReceipts.erase(found);
+    return true;
+}
+
+// ========== CITY NAMES ==========
+
+// Append-only: a name is written before the flight that refers to it is
+// published and is never changed, so readers index cityNames without locking.
+#ifndef AIRLINE_MAX_CITIES
+#define AIRLINE_MAX_CITIES 1024
+#endif
+const int MAX_CITIES = AIRLINE_MAX_CITIES;
+
+char cityNames[MAX_CITIES][50];
+int cityCount = 1;                    // ID 0 is the empty name
+mutex cityMutex;
+map<string, CityId> cityIds;          // guarded by cityMutex
+
+// Returns the ID of a city, adding it if it is new, or CITY_NONE when the table is full
+CityId internCity(const char* name) {
+    if (name[0] == '\0') return 0;
+    lock_guard<mutex> lock(cityMutex);
+    auto found = cityIds.find(name);
+    if (found != cityIds.end()) return found->second;
+    if (cityCount == MAX_CITIES) return CITY_NONE;
+    strncpy(cityNames[cityCount], name, sizeof(cityNames[0]) - 1);
+    cityIds[cityNames[cityCount]] = cityCount;
+    return cityCount++;
+}
+
+// Returns the ID of a known city, or CITY_NONE
+CityId findCity(const char* name) {
+    lock_guard<mutex> lock(cityMutex);
+    auto found = cityIds.find(name);
+    return found != cityIds.end() ? found->second : CITY_NONE;
+}
+
+const char* cityName(CityId city) {
+    return city < MAX_CITIES ? cityNames[city] : "";
+}
+
+// ========== FLIGHT STORE FUNCTIONS ==========
+
+int flightIndexHash(int flightNo) {
+    return (int)(((unsigned)flightNo * 2654435761u) & (FLIGHT_INDEX_SIZE - 1));
+}
+
+// Returns a slot for a new flight, reusing a deleted one when possible.
+int allocateFlightSlot() {
+    if (freeFlightSlotCount > 0) {
+        return freeFlightSlots[--freeFlightSlotCount];
+    }
+    return flightCount++;
+}
+
+void indexFlight(int flightNo, int slot) {
+    int pos = flightIndexHash(flightNo);
+    int firstTombstone = -1;
+    for (int probe = 0; probe < FLIGHT_INDEX_SIZE; probe++) {
+        if (flightIndexKeys[pos] == INDEX_EMPTY) break;
+        if (flightIndexKeys[pos] == INDEX_TOMBSTONE && firstTombstone == -1) {
+            firstTombstone = pos;
+        }
+        pos = (pos + 1) & (FLIGHT_INDEX_SIZE - 1);
+    }
+    if (firstTombstone != -1) pos = firstTombstone;
+    flightIndexKeys[pos] = flightNo;
+    flightIndexSlots[pos] = slot;
+}
+
+int lookupFlightSlot(int flightNo) {
+    int pos = flightIndexHash(flightNo);
+    int slot = -1;
+    int probe = 0;
+    for (; probe < FLIGHT_INDEX_SIZE; probe++) {
+        if (flightIndexKeys[pos] == INDEX_EMPTY) break;
+        if (flightIndexKeys[pos] == flightNo) {
+            slot = flightIndexSlots[pos];
             break;
+        }
+        pos = (pos + 1) & (FLIGHT_INDEX_SIZE - 1);
+    }
+    ThreadMetrics& local = threadMetrics();
+    bumpRelaxed(local.counters[COUNTER_FLIGHT_LOOKUPS], 1);
+    bumpRelaxed(local.counters[COUNTER_FLIGHT_LOOKUP_PROBES], probe + 1);
+    return slot;
+}
+
+void unindexFlight(int flightNo) {
+    int pos = flightIndexHash(flightNo);
+    for (int probe = 0; probe < FLIGHT_INDEX_SIZE; probe++) {
+        if (flightIndexKeys[pos] == INDEX_EMPTY) return;
+        if (flightIndexKeys[pos] == flightNo) {
+            flightIndexKeys[pos] = INDEX_TOMBSTONE;
+            return;
+        }
+        pos = (pos + 1) & (FLIGHT_INDEX_SIZE - 1);
+    }
+}
+
+// O(1) removal: the slot is tombstoned and pushed on the free list, nothing is shifted.
+void removeFlight(int slot) {
+    versionFlight(slot);
+    unindexFlight(flights[slot].flightNo);
+    departureIndex.erase(make_pair(departureMinute(flights[slot]), slot));
+    flights[slot].deleted = true;
+    markAvailabilityStale(slot);
+    freeFlightSlots[freeFlightSlotCount++] = slot;
+    liveFlightCount--;
+}
+
+long long departureMinute(const Flight& flight) {
+    return (long long)daysFromCivil(flight.departureDate) * 1440 +
+           flight.departureTime.hour * 60 + flight.departureTime.minute;
+}
+
+// Fills flightNos with the flights departing in [fromMinute, toMinute], in
+// departure order, and returns how many were found
+int findDepartingFlights(long long fromMinute, long long toMinute, int flightNos[], int maxResults) {
+    lock_guard<mutex> lock(storeMutex);
+    int found = 0;
+    for (auto it = departureIndex.lower_bound(make_pair(fromMinute, INT_MIN));
+         it != departureIndex.end() && it->first <= toMinute && found < maxResults; ++it) {
+        flightNos[found++] = flights[it->second].flightNo;
+    }
+    return found;
+}
+
+bool isOpenForBooking(const Flight& flight) {
+    return !flight.deleted &&
+           (flight.status == FLIGHT_SCHEDULED || flight.status == FLIGHT_DELAYED);
+}
+
+// Bookings in these states are counted against their flight's capacity
+bool occupiesSeats(const Booking& booking) {
+    return booking.status == BOOKING_CONFIRMED || booking.status == BOOKING_IN_FLIGHT;
+}
+
+int travelMonthKey(const Date& date) {
+    return date.year * 12 + date.month - 1;
+}
+
+void linkBookingToPartition(int index) {
+    int day = packedDayNumber(bookings[index].travelDate);
+    // A booking restored or moved into the past is completed by the next sweep
+    completedThroughDay = min(completedThroughDay, day);
+    BookingPartition& partition = bookingPartitions[day];
+    if (partition.size == 0) partition.firstBooking = -1;
+    bookingPartitionLinks[index] = partition.firstBooking;
+    partition.firstBooking = index;
+    partition.size++;
+}
+
+// Stores a booking in a free slot and links it into its flight's booking list
+// and its travel-day partition. The caller holds storeMutex.
+int insertBooking(const Booking& booking) {
+    int index;
+    if (freeBookingSlotCount > 0) {
+        index = freeBookingSlots[--freeBookingSlotCount];
+    } else if (bookingCount < MAX_BOOKINGS) {
+        index = bookingCount++;
+    } else {
+        return -1;
+    }
+    versionBooking(index);
+    bookings[index] = booking;
+    bookings[index].nextOnFlight = -1;
+    bookings[index].archived = false;
+    int slot = lookupFlightSlot(booking.flightNo);
+    if (slot != -1) {
+        bookings[index].nextOnFlight = flights[slot].firstBooking;
+        flights[slot].firstBooking = index;
+    }
+    linkBookingToPartition(index);
+    bookingPassengerLinks[index] = -1;
+    Passenger* passenger = findPassengerById(booking.passengerId);
+    if (passenger) {
+        if (passenger->lastBooking == -1) passenger->firstBooking = index;
+        else bookingPassengerLinks[passenger->lastBooking] = index;
+        passenger->lastBooking = index;
+    }
+    liveBookingCount++;
+    return index;
+}
+
+// Moves every confirmed booking of a flight that is being removed or cancelled
+// onto another flight on the same route when one has room in the same class,
+// and cancels the rest with a full refund. Only the flight's own booking list
+// is walked; moved bookings are relinked onto their new flight.
+void cascadeFlightRemoval(Flight& removed, RemovalOutcome& outcome) {
+    // Other flights on the same route leaving on a travel day, taken from the
+    // departure index once per day the batch needs
+    map<int, vector<int>> candidatesByDay;
+    auto candidatesOn = [&](int day) -> const vector<int>& {
+        auto found = candidatesByDay.find(day);
+        if (found != candidatesByDay.end()) return found->second;
+        vector<int>& candidates = candidatesByDay[day];
+        for (auto it = departureIndex.lower_bound(make_pair((long long)day * 1440, INT_MIN));
+             it != departureIndex.end() && it->first < (long long)(day + 1) * 1440; ++it) {
+            const Flight& flight = flights[it->second];
+            if (!flight.deleted && flight.flightNo != removed.flightNo &&
+                flight.origin == removed.origin && flight.destination == removed.destination) {
+                candidates.push_back(it->second);
+            }
+        }
+        return candidates;
+    };
+    
+    vector<int> cancelled;
+    
+    // Confirmed bookings compete for the free seats on other flights; higher
+    // loyalty tiers are placed first
+    int remaining = -1;   // rebuilt list of bookings that stay with the removed flight
+    vector<pair<int, int>> waiting;   // (tier, slot)
+    int next;
+    for (int i = removed.firstBooking; i != -1; i = next) {
+        next = bookings[i].nextOnFlight;
+        if (bookings[i].status != BOOKING_CONFIRMED) {
+            bookings[i].nextOnFlight = remaining;
+            remaining = i;
+            continue;
+        }
+        Passenger* passenger = findPassengerById(bookings[i].passengerId);
+        waiting.push_back(make_pair(passenger ? loyaltyTier(*passenger) : TIER_BLUE, i));
+    }
+    stable_sort(waiting.begin(), waiting.end(),
+                [](const pair<int, int>& a, const pair<int, int>& b) { return a.first > b.first; });
+    
+    for (const pair<int, int>& entry : waiting) {
+        int i = entry.second;
+        Booking& booking = bookings[i];
+        versionBooking(i);
+        
+        Flight* alternative = nullptr;
+        for (int c : candidatesOn(packedDayNumber(booking.travelDate))) {
+            Flight& candidate = flights[c];
+            if (isOpenForBooking(candidate) &&
+                candidate.classSeats[booking.cabin] >= booking.seatsBooked) {
+                alternative = &candidate;
+                break;
+            }
+        }
+        
+        if (alternative) {
+            versionFlight(alternative - flights);
+            alternative->classSeats[booking.cabin] -= booking.seatsBooked;
+            alternative->availableSeats -= booking.seatsBooked;
+            markAvailabilityStale(alternative - flights);
+            alternative->timesBooked++;
+            alternative->totalRevenue += fromCents(booking.fareCents);
+            // The travel date follows the new flight and miles are earned on its distance
+            reverseBookingMiles(i);
+            booking.flightNo = alternative->flightNo;
+            booking.travelDate = packDate(alternative->departureDate);
+            accrueBookingMiles(i, *alternative);
+            booking.nextOnFlight = alternative->firstBooking;
+            alternative->firstBooking = i;
+            outcome.moved++;
+            publishStoreEvent(EVENT_REBOOKED, booking, *alternative, 0);
+        } else {
+            booking.status = BOOKING_CANCELLED;
+            reverseBookingMiles(i);
+            booking.nextOnFlight = remaining;
+            remaining = i;
+            cancelled.push_back(i);
+        }
+    }
+    removed.firstBooking = remaining;
+    
+    // Refunds for everything cancelled are computed in one batch under the
+    // airline-cancellation policy, then credited back to the passengers
+    int count = cancelled.size();
+    vector<int> daysBefore(count);
+    vector<unsigned char> policies(count, INVOLUNTARY_REFUND_POLICY);
+    vector<float> fares(count);
+    vector<float> refunds(count);
+    int today = todayDayNumber();
+    for (int c = 0; c < count; c++) {
+        daysBefore[c] = packedDayNumber(bookings[cancelled[c]].travelDate) - today;
+        fares[c] = fromCents(bookings[cancelled[c]].fareCents);
+    }
+    calculateRefundsBatch(daysBefore.data(), policies.data(), fares.data(), refunds.data(), count);
+    
+    for (int c = 0; c < count; c++) {
+        publishStoreEvent(EVENT_CANCELLED, bookings[cancelled[c]], removed, refunds[c]);
+        outcome.totalRefund += refunds[c];
+    }
+    outcome.cancelled += count;
+}
+
+void printRemovalOutcome(const RemovalOutcome& outcome) {
+    if (outcome.moved > 0 || outcome.cancelled > 0) {
+        cout << outcome.moved << " booking(s) moved to other flights on the same route.\n";
+        cout << outcome.cancelled << " booking(s) cancelled, total refund: $"
+             << fixed << setprecision(2) << outcome.totalRefund << "\n";
+    }
+}
+
+// ========== BOOKING COMMIT FUNCTIONS ==========
+
+long long seatsOnHold = 0;   // all seats in flightHeldSeats, guarded by storeMutex
+
+// Reserves the seats and stores the booking in one step. Availability is
+// checked again under storeMutex since it may have changed while the fare
+// was being quoted. With seatsHeld the seats were already taken off sale by
+// holdSeats and are only turned into the booking. Returns the booking's
+// slot, or -1 with error set.
+int commitBooking(Booking& booking, string& error, bool seatsHeld) {
+    MetricTimer timer(METRIC_BOOK);
+    StoreTransaction transaction;
+    
+    int slot = lookupFlightSlot(booking.flightNo);
+    if (slot == -1 || !isOpenForBooking(flights[slot])) {
+        error = "Flight is no longer available";
+        countEvent(COUNTER_BOOKING_FAILURES);
+        return -1;
+    }
+    Flight& flight = flights[slot];
+    int* classSeats = &flight.classSeats[booking.cabin];
+    int* held = &flightHeldSeats[slot][booking.cabin];
+    if (seatsHeld && *held < booking.seatsBooked) {
+        error = "Seat hold is no longer valid";
+        countEvent(COUNTER_BOOKING_FAILURES);
+        return -1;
+    }
+    if (!seatsHeld && *classSeats < booking.seatsBooked) {
+        error = "Only " + to_string(*classSeats) + " seats left in " + cabinName(booking.cabin) + " class";
+        countEvent(COUNTER_BOOKING_FAILURES);
+        return -1;
+    }
+    
+    int index = insertBooking(booking);
+    if (index == -1) {
+        error = "Maximum bookings limit reached";
+        countEvent(COUNTER_BOOKING_FAILURES);
+        return -1;
+    }
+    accrueBookingMiles(index, flight);
+    
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    versionFlight(slot);
+    if (seatsHeld) {
+        *held -= booking.seatsBooked;
+        seatsOnHold -= booking.seatsBooked;
+    } else {
+        *classSeats -= booking.seatsBooked;
+        flight.availableSeats -= booking.seatsBooked;
+    }
+    flight.timesBooked++;
+    flight.totalRevenue += fromCents(booking.fareCents);
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    markAvailabilityStale(slot);
+    publishStoreEvent(EVENT_BOOKED, booking, flight, fromCents(booking.fareCents));
+    
+    if (tracing) traceRecord(traceBookingFields(booking));
+    return index;
+}
+
+// Takes seats in one class off sale for a booking that is not confirmed yet.
+// Held seats are not journaled or audited: they are either booked through
+// commitBooking with seatsHeld, or handed back by releaseSeatHold.
+bool holdSeats(int flightNo, unsigned char cabin, int seats, string& error) {
+    StoreTransaction transaction;
+    
+    int slot = lookupFlightSlot(flightNo);
+    if (slot == -1 || !isOpenForBooking(flights[slot])) {
+        error = "Flight is no longer available";
+        return false;
+    }
+    Flight& flight = flights[slot];
+    if (flight.classSeats[cabin] < seats) {
+        error = "Only " + to_string(flight.classSeats[cabin]) + " seats left in " + cabinName(cabin) + " class";
+        return false;
+    }
+    
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    versionFlight(slot);
+    flight.classSeats[cabin] -= seats;
+    flight.availableSeats -= seats;
+    flightHeldSeats[slot][cabin] += seats;
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    markAvailabilityStale(slot);
+    seatsOnHold += seats;
+    return true;
+}
+
+// Puts held seats back on sale. A hold on a flight deleted since is dropped.
+void releaseSeatHold(int flightNo, unsigned char cabin, int seats) {
+    StoreTransaction transaction;
+    
+    seatsOnHold -= seats;
+    int slot = lookupFlightSlot(flightNo);
+    if (slot == -1) return;
+    Flight& flight = flights[slot];
+    seats = min(seats, flightHeldSeats[slot][cabin]);
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    versionFlight(slot);
+    flightHeldSeats[slot][cabin] -= seats;
+    flight.classSeats[cabin] += seats;
+    flight.availableSeats += seats;
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    markAvailabilityStale(slot);
+}
+
+// Cancels the booking in the given slot and returns its seats to the flight.
+// The booking ID is checked again in case the slot was archived and reused.
+bool commitCancellation(int index, int bookingId, float refundAmount, string& error) {
+    MetricTimer timer(METRIC_CANCEL);
+    StoreTransaction transaction;
+    
+    Booking& booking = bookings[index];
+    if (booking.archived || booking.bookingId != bookingId) {
+        error = "Booking not found";
+        return false;
+    }
+    if (!BOOKING_TRANSITIONS[booking.status][BOOKING_CANCELLED]) {
+        error = string("Booking is ") + BOOKING_STATUS_NAMES[booking.status];
+        return false;
+    }
+    
+    int slot = lookupFlightSlot(booking.flightNo);
+    Flight flightAfter = Flight();
+    if (slot != -1) {
+        Flight& flight = flights[slot];
+        flightStoreEpoch.fetch_add(1, memory_order_release);
+        versionFlight(slot);
+        flight.classSeats[booking.cabin] += booking.seatsBooked;
+        flight.availableSeats += booking.seatsBooked;
+        flight.totalRevenue -= refundAmount;
+        flight.timesBooked--;
+        flightStoreEpoch.fetch_add(1, memory_order_release);
+        markAvailabilityStale(slot);
+        flightAfter = flight;
+    }
+    
+    versionBooking(index);
+    booking.status = BOOKING_CANCELLED;
+    reverseBookingMiles(index);
+    publishStoreEvent(EVENT_CANCELLED, booking, flightAfter, refundAmount);
+    
+    if (tracing) {
+        traceRecord("C\t" + to_string(bookingId) + '\t' + to_string(refundAmount));
+    }
+    return true;
+}
+
+// ========== GROUP BOOKING FUNCTIONS ==========
+
+// Books every traveller on every leg in one pass under storeMutex. Seats are
+// checked per flight and class for the whole group before anything is
+// written, so either all seats are reserved or none are. Returns the group
+// ID, or -1 with error set.
+int commitGroupBooking(int passengerId, const vector<GroupLeg>& legs, const vector<string>& travellers, string& error) {
+    static atomic<int> lastGroupId(0);
+    MetricTimer timer(METRIC_BOOK);
+    int travellerCount = travellers.size();
+    int legCount = legs.size();
+    if (travellerCount < 1 || travellerCount > MAX_GROUP_TRAVELLERS || legCount < 1) {
+        error = "A group needs 1 to " + to_string(MAX_GROUP_TRAVELLERS) + " travellers and at least one flight";
+        return -1;
+    }
+    
+    StoreTransaction transaction;
+    
+    vector<int> slots(legCount);
+    vector<float> seatFares(legCount);
+    for (int l = 0; l < legCount; l++) {
+        slots[l] = lookupFlightSlot(legs[l].flightNo);
+        if (slots[l] == -1 || !isOpenForBooking(flights[slots[l]])) {
+            error = "Flight #" + to_string(legs[l].flightNo) + " is not available";
+            countEvent(COUNTER_BOOKING_FAILURES);
+            return -1;
+        }
+        // The same flight and class may appear on more than one leg
+        int needed = 0;
+        for (int other = 0; other <= l; other++) {
+            if (slots[other] == slots[l] && legs[other].cabin == legs[l].cabin) {
+                needed += travellerCount;
+            }
+        }
+        int available = flights[slots[l]].classSeats[legs[l].cabin];
+        if (available < needed) {
+            error = "Only " + to_string(available) + " seats left in " + cabinName(legs[l].cabin) +
+                    " class on flight #" + to_string(legs[l].flightNo);
+            countEvent(COUNTER_BOOKING_FAILURES);
+            return -1;
+        }
+        seatFares[l] = applyLoyaltyDiscount(calculateFare(flights[slots[l]], 1, legs[l].cabin), passengerId);
+    }
+    
+    int rows = travellerCount * legCount;
+    if (freeBookingSlotCount + (MAX_BOOKINGS - bookingCount) < rows) {
+        error = "Maximum bookings limit reached";
+        countEvent(COUNTER_BOOKING_FAILURES);
+        return -1;
+    }
+    
+    GroupBooking group;
+    group.groupId = ++lastGroupId;
+    group.leadPassengerId = passengerId;
+    group.legs = legs;
+    group.travellers = travellers;
+    group.memberBookingIds.resize(rows);
+    group.memberSlots.resize(rows);
+    
+    Booking seat = {};
+    seat.passengerId = passengerId;
+    seat.bookingDate = packDate(civilFromDays(todayDayNumber()));
+    seat.seatsBooked = 1;
+    seat.status = BOOKING_CONFIRMED;
+    
+    float total = 0.0;
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    for (int l = 0; l < legCount; l++) {
+        Flight& flight = flights[slots[l]];
+        seat.flightNo = flight.flightNo;
+        seat.travelDate = packDate(flight.departureDate);
+        seat.cabin = legs[l].cabin;
+        seat.fareCents = toCents(seatFares[l]);
+        versionFlight(slots[l]);
+        for (int t = 0; t < travellerCount; t++) {
+            seat.bookingId = generateBookingId();
+            int member = t * legCount + l;
+            group.memberBookingIds[member] = seat.bookingId;
+            group.memberSlots[member] = insertBooking(seat);
+            accrueBookingMiles(group.memberSlots[member], flight);
+        }
+        flight.classSeats[legs[l].cabin] -= travellerCount;
+        flight.availableSeats -= travellerCount;
+        flight.timesBooked += travellerCount;
+        flight.totalRevenue += fromCents(seat.fareCents) * travellerCount;
+        total += fromCents(seat.fareCents) * travellerCount;
+        markAvailabilityStale(slots[l]);
+    }
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    
+    for (int member = 0; member < rows; member++) {
+        const Booking& seat = bookings[group.memberSlots[member]];
+        publishStoreEvent(EVENT_BOOKED, seat, flights[slots[member % legCount]], fromCents(seat.fareCents));
+    }
+    
+    if (tracing) {
+        for (int member = 0; member < rows; member++) {
+            traceRecord(traceBookingFields(bookings[group.memberSlots[member]]));
+        }
+    }
+    
+    int groupId = group.groupId;
+    groupBookings[groupId] = move(group);
+    return groupId;
+}
+
+// Cancels every leg of the chosen travellers (indexes into the group's
+// traveller list) and returns their seats. All chosen seats must still be
+// cancellable or nothing is changed. Refunds are computed in one batch.
+bool commitGroupCancellation(int groupId, int passengerId, const vector<int>& travellers, float& totalRefund, string& error) {
+    MetricTimer timer(METRIC_CANCEL);
+    StoreTransaction transaction;
+    
+    auto found = groupBookings.find(groupId);
+    if (found == groupBookings.end() || found->second.leadPassengerId != passengerId) {
+        error = "Group booking not found";
+        return false;
+    }
+    GroupBooking& group = found->second;
+    int legCount = group.legs.size();
+    
+    // A traveller listed twice is cancelled once
+    vector<int> chosen(travellers);
+    sort(chosen.begin(), chosen.end());
+    chosen.erase(unique(chosen.begin(), chosen.end()), chosen.end());
+    
+    vector<int> members;
+    for (int t : chosen) {
+        if (t < 0 || t >= (int)group.travellers.size()) {
+            error = "Invalid traveller number";
+            return false;
+        }
+        for (int l = 0; l < legCount; l++) {
+            int member = t * legCount + l;
+            int slot = group.memberSlots[member];
+            const Booking& booking = bookings[slot];
+            if (booking.archived || booking.bookingId != group.memberBookingIds[member] ||
+                !BOOKING_TRANSITIONS[booking.status][BOOKING_CANCELLED]) {
+                error = group.travellers[t] + " has no cancellable seat on flight #" +
+                        to_string(group.legs[l].flightNo);
+                return false;
+            }
+            members.push_back(slot);
+        }
+    }
+    
+    int count = members.size();
+    vector<int> daysBefore(count);
+    vector<unsigned char> policies(count);
+    vector<float> fares(count);
+    vector<float> refunds(count);
+    int today = todayDayNumber();
+    for (int m = 0; m < count; m++) {
+        const Booking& booking = bookings[members[m]];
+        daysBefore[m] = packedDayNumber(booking.travelDate) - today;
+        policies[m] = booking.cabin;
+        fares[m] = fromCents(booking.fareCents);
+    }
+    calculateRefundsBatch(daysBefore.data(), policies.data(), fares.data(), refunds.data(), count);
+    
+    totalRefund = 0.0;
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    for (int m = 0; m < count; m++) {
+        Booking& booking = bookings[members[m]];
+        versionBooking(members[m]);
+        int slot = lookupFlightSlot(booking.flightNo);
+        if (slot != -1) {
+            Flight& flight = flights[slot];
+            versionFlight(slot);
+            flight.classSeats[booking.cabin] += booking.seatsBooked;
+            flight.availableSeats += booking.seatsBooked;
+            flight.totalRevenue -= refunds[m];
+            flight.timesBooked--;
+            markAvailabilityStale(slot);
+        }
+        booking.status = BOOKING_CANCELLED;
+        reverseBookingMiles(members[m]);
+        publishStoreEvent(EVENT_CANCELLED, booking, slot != -1 ? flights[slot] : Flight(), refunds[m]);
+        totalRefund += refunds[m];
+        if (tracing) traceRecord("C\t" + to_string(booking.bookingId) + '\t' + to_string(refunds[m]));
+    }
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    return true;
+}
+
+// ========== BOOKING PARTITION FUNCTIONS ==========
+
+mutex sweepMutex;
+condition_variable sweepWakeup;
+bool sweepStopping = false;
+thread sweepThread;
+
+// Drops archived bookings from a flight's booking list
+void pruneArchivedFromFlight(int flightNo) {
+    int slot = lookupFlightSlot(flightNo);
+    if (slot == -1) return;
+    int* link = &flights[slot].firstBooking;
+    while (*link != -1) {
+        if (bookings[*link].archived) *link = bookings[*link].nextOnFlight;
+        else link = &bookings[*link].nextOnFlight;
+    }
+}
+
+// Drops archived bookings from a passenger's booking list
+void pruneArchivedFromPassenger(int passengerId) {
+    Passenger* passenger = findPassengerById(passengerId);
+    if (!passenger) return;
+    int* link = &passenger->firstBooking;
+    passenger->lastBooking = -1;
+    while (*link != -1) {
+        if (bookings[*link].archived) {
+            *link = bookingPassengerLinks[*link];
+        } else {
+            passenger->lastBooking = *link;
+            link = &bookingPassengerLinks[*link];
+        }
+    }
+}
+
+// Finds a live booking through its passenger's booking list; returns its slot
+// or -1. The caller holds storeMutex, so the sweep cannot archive the booking
+// and hand its slot to someone else while it is read.
+int findPassengerBookingSlot(int passengerId, int bookingId) {
+    Passenger* passenger = findPassengerById(passengerId);
+    if (!passenger) return -1;
+    for (int i = passenger->firstBooking; i != -1; i = bookingPassengerLinks[i]) {
+        if (!bookings[i].archived && bookings[i].bookingId == bookingId) return i;
+    }
+    return -1;
+}
+
+// Moves bookings whose travel date was changed into the right day partition
+void refileBookingPartitions() {
+    vector<int> misfiled;
+    for (auto& entry : bookingPartitions) {
+        int* link = &entry.second.firstBooking;
+        while (*link != -1) {
+            if (packedDayNumber(bookings[*link].travelDate) != entry.first) {
+                misfiled.push_back(*link);
+                *link = bookingPartitionLinks[*link];
+                entry.second.size--;
+            } else {
+                link = &bookingPartitionLinks[*link];
+            }
+        }
+    }
+    for (int i : misfiled) {
+        linkBookingToPartition(i);
+    }
+    for (auto it = bookingPartitions.begin(); it != bookingPartitions.end();) {
+        if (it->second.size == 0) it = bookingPartitions.erase(it);
+        else ++it;
+    }
+    bookingPartitionsNeedRefile = false;
+}
+
+void putArchiveField(char*& out, long long value, int bytes) {
+    for (int i = 0; i < bytes; i++) *out++ = (char)(unsigned char)(value >> (i * 8));
+}
+
+long long getArchiveField(const char*& in, int bytes, bool isSigned) {
+    unsigned long long value = 0;
+    for (int i = 0; i < bytes; i++) value |= (unsigned long long)(unsigned char)*in++ << (i * 8);
+    if (isSigned && bytes < 8 && (value >> (bytes * 8 - 1)) & 1) value |= ~0ULL << (bytes * 8);
+    return (long long)value;
+}
+
+void encodeArchiveRecord(int slot, char record[ARCHIVE_RECORD_BYTES]) {
+    const Booking& booking = bookings[slot];
+    char* out = record;
+    putArchiveField(out, booking.bookingId, 4);
+    putArchiveField(out, booking.passengerId, 4);
+    putArchiveField(out, booking.flightNo, 4);
+    putArchiveField(out, booking.fareCents, 4);
+    putArchiveField(out, bookingMiles[slot], 4);
+    putArchiveField(out, packedDayNumber(booking.travelDate), 4);
+    putArchiveField(out, packedDayNumber(booking.bookingDate), 4);
+    putArchiveField(out, booking.seatsBooked, 2);
+    putArchiveField(out, booking.cabin, 1);
+    putArchiveField(out, booking.status, 1);
+}
+
+// Reads and checks the header. recordBytes is the record size the file was
+// written with, at least ARCHIVE_RECORD_BYTES.
+bool readArchiveHeader(istream& in, int& version, int& recordBytes) {
+    char header[ARCHIVE_HEADER_BYTES];
+    if (!in.read(header, sizeof(header)) || memcmp(header, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) {
+        return false;
+    }
+    const char* field = header + sizeof(ARCHIVE_MAGIC);
+    version = (int)getArchiveField(field, 4, false);
+    recordBytes = (int)getArchiveField(field, 4, false);
+    return version >= 1 && recordBytes >= ARCHIVE_RECORD_BYTES;
+}
+
+// Opens the archive for appending, writing the header to a new file. A file
+// without the header holds raw Booking dumps from older builds and is moved
+// aside to bookingArchivePath.raw; a newer format version is left alone.
+// archivedThroughDay is the first day of the month after the last archived
+// record: months are archived whole and in order, so travel days before it
+// are already in the file when a journal replay brings them back.
+bool openBookingArchive(ofstream& archive, int& archivedThroughDay) {
+    archivedThroughDay = INT_MIN;
+    ifstream existing(bookingArchivePath, ios::binary | ios::ate);
+    if (existing && existing.tellg() > 0) {
+        long long size = existing.tellg();
+        existing.seekg(0);
+        int version = 0, recordBytes = 0;
+        bool headed = readArchiveHeader(existing, version, recordBytes);
+        if (headed && version == ARCHIVE_FORMAT_VERSION) {
+            long long whole = size - (size - ARCHIVE_HEADER_BYTES) % recordBytes;
+            if (whole > ARCHIVE_HEADER_BYTES) {
+                vector<char> last(recordBytes);
+                existing.seekg(whole - recordBytes);
+                existing.read(last.data(), recordBytes);
+                const char* field = last.data() + 20;   // the travel day, after five 4-byte fields
+                Date lastDay = civilFromDays((int)getArchiveField(field, 4, true));
+                archivedThroughDay = daysFromCivil({1, lastDay.month % 12 + 1, lastDay.year + lastDay.month / 12});
+            }
+            existing.close();
+            if (whole != size) {
+                cerr << "Archive " << bookingArchivePath << " ends in a partial record; truncating it\n";
+                if (truncate(bookingArchivePath.c_str(), whole) != 0) return false;
+            }
+            archive.open(bookingArchivePath, ios::binary | ios::app);
+            return (bool)archive;
+        }
+        existing.close();
+        if (headed) {
+            cerr << "Archive " << bookingArchivePath << " has format version " << version
+                 << "; this build writes version " << ARCHIVE_FORMAT_VERSION << "\n";
+            return false;
+        }
+        string legacy = bookingArchivePath + ".raw";
+        cerr << "Archive " << bookingArchivePath << " has no format header; moving it to " << legacy << "\n";
+        if (rename(bookingArchivePath.c_str(), legacy.c_str()) != 0) return false;
+    }
+    existing.close();
+    archive.open(bookingArchivePath, ios::binary | ios::trunc);
+    char header[ARCHIVE_HEADER_BYTES];
+    memcpy(header, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    char* field = header + sizeof(ARCHIVE_MAGIC);
+    putArchiveField(field, ARCHIVE_FORMAT_VERSION, 4);
+    putArchiveField(field, ARCHIVE_RECORD_BYTES, 4);
+    archive.write(header, sizeof(header));
+    return (bool)archive;
+}
+
+// Writes and flushes every booking of a partition. A failed write is cut
+// back off the file, so the archive never ends in a partial record.
+bool writeArchivePartition(ofstream& archive, const BookingPartition& partition, vector<char>& records) {
+    records.resize((size_t)partition.size * ARCHIVE_RECORD_BYTES);
+    size_t used = 0;
+    for (int i = partition.firstBooking; i != -1; i = bookingPartitionLinks[i]) {
+        if (used == records.size()) records.resize(used + ARCHIVE_RECORD_BYTES);
+        encodeArchiveRecord(i, &records[used]);
+        used += ARCHIVE_RECORD_BYTES;
+    }
+    long long archivedBytes = archive.tellp();
+    archive.write(records.data(), used);
+    archive.flush();
+    if (archive) return true;
+    archive.close();
+    if (archivedBytes >= 0 && truncate(bookingArchivePath.c_str(), archivedBytes) != 0) {
+        cerr << "Archive " << bookingArchivePath << " may end in a partial record\n";
+    }
+    return false;
+}
+
+// Completes bookings whose travel date has passed and archives every partition
+// of a month that has already ended. Only days that have passed since the
+// last sweep are visited for completion, and future days never are.
+void sweepBookingPartitions() {
+    time_t now = time(0);
+    tm currentTime;
+    localtime_r(&now, &currentTime);
+    Date today = {currentTime.tm_mday, currentTime.tm_mon + 1, currentTime.tm_year + 1900};
+    int todayDays = daysFromCivil(today);
+    int monthStartDays = daysFromCivil({1, today.month, today.year});
+    
+    StoreTransaction transaction;
+    
+    if (bookingPartitionsNeedRefile) {
+        refileBookingPartitions();
+    }
+    
+    for (auto it = bookingPartitions.lower_bound(completedThroughDay);
+         it != bookingPartitions.end() && it->first < todayDays; ++it) {
+        for (int i = it->second.firstBooking; i != -1; i = bookingPartitionLinks[i]) {
+            Booking& booking = bookings[i];
+            if (booking.status == BOOKING_CONFIRMED || booking.status == BOOKING_IN_FLIGHT) {
+                versionBooking(i);
+                booking.status = BOOKING_COMPLETED;
+                int slot = lookupFlightSlot(booking.flightNo);
+                publishStoreEvent(EVENT_COMPLETED, booking, slot != -1 ? flights[slot] : Flight(),
+                                  fromCents(booking.fareCents));
+            }
+        }
+    }
+    completedThroughDay = max(completedThroughDay, todayDays);
+    
+    ofstream archive;
+    vector<int> touchedFlights;
+    vector<int> touchedPassengers;
+    
+    auto it = bookingPartitions.begin();
+    if (bookingArchivePath.empty()) it = bookingPartitions.end();
+    int archivedThroughDay = INT_MIN;
+    if (it != bookingPartitions.end() && it->first < monthStartDays && !openBookingArchive(archive, archivedThroughDay)) {
+        cerr << "Cannot write archive " << bookingArchivePath << "; past months stay in the hot store\n";
+        return;
+    }
+    // A partition's slots are freed only once all of its records are on disk
+    vector<char> records;
+    while (it != bookingPartitions.end() && it->first < monthStartDays) {
+        if (it->first >= archivedThroughDay && !writeArchivePartition(archive, it->second, records)) {
+            cerr << "Cannot write archive " << bookingArchivePath << "; past months stay in the hot store\n";
+            break;
+        }
+        for (int i = it->second.firstBooking; i != -1; i = bookingPartitionLinks[i]) {
+            Booking& booking = bookings[i];
+            versionBooking(i);
+            booking.archived = true;
+            freeBookingSlots[freeBookingSlotCount++] = i;
+            liveBookingCount--;
+            touchedFlights.push_back(booking.flightNo);
+            touchedPassengers.push_back(booking.passengerId);
+        }
+        it = bookingPartitions.erase(it);
+    }
+    
+    sort(touchedFlights.begin(), touchedFlights.end());
+    touchedFlights.erase(unique(touchedFlights.begin(), touchedFlights.end()), touchedFlights.end());
+    parallelFor(0, touchedFlights.size(), 0, [&](int begin, int end) {
+        for (int f = begin; f < end; f++) pruneArchivedFromFlight(touchedFlights[f]);
+    });
+    sort(touchedPassengers.begin(), touchedPassengers.end());
+    touchedPassengers.erase(unique(touchedPassengers.begin(), touchedPassengers.end()), touchedPassengers.end());
+    parallelFor(0, touchedPassengers.size(), 0, [&](int begin, int end) {
+        for (int p = begin; p < end; p++) pruneArchivedFromPassenger(touchedPassengers[p]);
+    });
+}
+
+// Usage: --archive-dump FILE
+// Prints every archived booking, one tab-separated line each.
+int runArchiveDump(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: --archive-dump FILE\n";
+        return 1;
+    }
+    ifstream archive(argv[2], ios::binary);
+    if (!archive) {
+        cerr << "Cannot read archive " << argv[2] << "\n";
+        return 1;
+    }
+    int version = 0, recordBytes = 0;
+    if (!readArchiveHeader(archive, version, recordBytes)) {
+        cerr << "Archive " << argv[2] << " has no format header\n";
+        return 1;
+    }
+    if (version > ARCHIVE_FORMAT_VERSION) {
+        cerr << "Archive " << argv[2] << " has format version " << version
+             << "; this build reads up to version " << ARCHIVE_FORMAT_VERSION << "\n";
+        return 1;
+    }
+    vector<char> record(recordBytes);
+    while (archive.read(record.data(), recordBytes)) {
+        const char* in = record.data();
+        int bookingId = (int)getArchiveField(in, 4, true);
+        int passengerId = (int)getArchiveField(in, 4, true);
+        int flightNo = (int)getArchiveField(in, 4, true);
+        int fareCents = (int)getArchiveField(in, 4, true);
+        int miles = (int)getArchiveField(in, 4, true);
+        int travelDay = (int)getArchiveField(in, 4, true);
+        int bookingDay = (int)getArchiveField(in, 4, true);
+        int seats = (int)getArchiveField(in, 2, false);
+        int cabin = (int)getArchiveField(in, 1, false);
+        int status = (int)getArchiveField(in, 1, false);
+        cout << bookingId << '\t' << passengerId << '\t' << flightNo << '\t'
+             << formatDate(civilFromDays(travelDay)) << '\t' << formatDate(civilFromDays(bookingDay)) << '\t'
+             << seats << '\t' << (cabin < CABIN_COUNT ? CABIN_CLASSES[cabin].name : "unknown") << '\t'
+             << (status < BOOKING_STATUS_COUNT ? BOOKING_STATUS_NAMES[status] : "unknown") << '\t'
+             << fareCents / 100 << '.' << setfill('0') << setw(2) << abs(fareCents % 100) << setfill(' ')
+             << '\t' << miles << "\n";
+    }
+    if (archive.gcount() != 0) {
+        cerr << "Archive " << argv[2] << " ends in a partial record\n";
+        return 1;
+    }
+    return 0;
+}
+
+void startCompletionSweep() {
+    sweepThread = thread([] {
+        unique_lock<mutex> lock(sweepMutex);
+        while (!sweepStopping) {
+            lock.unlock();
+            sweepBookingPartitions();
+            lock.lock();
+            sweepWakeup.wait_for(lock, chrono::seconds(SWEEP_INTERVAL_SECONDS),
+                                 [] { return sweepStopping; });
+        }
+    });
+}
+
+void stopCompletionSweep() {
+    {
+        lock_guard<mutex> lock(sweepMutex);
+        sweepStopping = true;
+    }
+    sweepWakeup.notify_one();
+    if (sweepThread.joinable()) sweepThread.join();
+}
+
+// ========== SEARCH FUNCTIONS ==========
+
+// Copies the logged-in passenger's booking and its slot. Done under storeMutex
+// so the sweep cannot archive and reuse the slot while it is read; commits
+// check the booking ID in the slot again.
+bool findBookingById(int bookingId, Booking& out, int& index) {
+    lock_guard<mutex> lock(storeMutex);
+    index = findPassengerBookingSlot(currentPassengerId, bookingId);
+    if (index == -1) return false;
+    out = bookings[index];
+    return true;
+}
+
+Flight* findFlightByNumber(int flightNo, int& index) {
+    int slot = lookupFlightSlot(flightNo);
+    if (slot == -1) return nullptr;
+    index = slot;
+    return &flights[slot];
+}
+
+// Copies a flight without blocking on writers; retries while a batch is being published
+bool snapshotFlight(int flightNo, Flight& out) {
+    while (true) {
+        unsigned before = flightStoreEpoch.load(memory_order_acquire);
+        if (before & 1) continue;
+        int slot = lookupFlightSlot(flightNo);
+        if (slot != -1) out = flights[slot];
+        atomic_thread_fence(memory_order_acquire);
+        if (flightStoreEpoch.load(memory_order_relaxed) == before) return slot != -1;
+    }
+}
+
+// Fills flightNos with bookable flights on a route and returns how many were found
+int findBookableFlights(const char* origin, const char* destination, int flightNos[], int maxResults) {
+    MetricTimer timer(METRIC_SEARCH);
+    if (tracing && traceSearches) traceRecord(string("S\t") + origin + '\t' + destination);
+    
+    // Buckets of one route are adjacent in the cache, ordered by date
+    shared_ptr<const AvailabilityView> view = currentAvailability();
+    RequestScope request;
+    ArenaString route(origin, requestMemory());
+    route += '|';
+    route += destination;
+    route += '|';
+    string_view prefix = route;
+    int found = 0;
+    view->forEachFrom(prefix, [&](const AvailabilityBucket& bucket) {
+        if (bucket.key.compare(0, prefix.size(), prefix) != 0) return false;
+        for (int flightNo : bucket.flightNos) {
+            if (found == maxResults) return false;
+            flightNos[found++] = flightNo;
+        }
+        return true;
+    });
+    return found;
+}
+
+// Passenger IDs are assigned sequentially from 1001 at registration
+Passenger* findPassengerById(int passengerId) {
+    int i = passengerId - 1001;
+    if (i < 0 || i >= passengerCount || passengers[i].id != passengerId) return nullptr;
+    return &passengers[i];
+}
+
+// ========== CONSOLE PAGING ==========
+
+// Long console views are shown a page at a time. Each view renders one page
+// into a buffer, starting at a cursor into the store it lists and leaving the
+// cursor on the first row of the next page, so a page costs the same however
+// large the table is. The buffer reaches the terminal in a single write.
+const int CONSOLE_PAGE_ROWS = 20;    // table rows per page
+const int CONSOLE_PAGE_CARDS = 5;    // multi-line records per page
+
+void writePage(const ostringstream& page) {
+    string text = page.str();
+    cout.write(text.data(), text.size());
+    cout.flush();
+}
+
+// Shows pages until renderPage reports that none are left or the user quits.
+// renderPage(out) writes one page to out and returns whether another follows.
+template <typename RenderPage>
+void pageThrough(RenderPage renderPage) {
+    while (true) {
+        ostringstream page;
+        page.copyfmt(cout);   // keep the number formatting the console is in
+        page.tie(nullptr);
+        bool more = renderPage(page);
+        cout.copyfmt(page);
+        writePage(page);
+        if (!more) return;
+        cout << "[n]ext page, [q]uit: ";
+        string command;
+        if (!readWord(command) || command == "q") return;
+    }
+}
+
+// ========== VIEW FUNCTIONS ==========
+
+// Position in the availability cache: a bucket and a row within it
+struct AvailabilityCursor {
+    string key;
+    size_t row = 0;
+};
+
+// Writes one page of the availability table, taking rows pre-rendered by the
+// cache from the cursor on. The legend follows the last page.
+bool renderAvailableFlightsPage(AvailabilityCursor& cursor, ostream& out) {
+    out << left 
+        << setw(8) << "Flight #" 
+        << setw(12) << "From" 
+        << setw(12) << "To"
+        << setw(10) << "Date"
+        << setw(8) << "Time";
+    for (int c = 0; c < CABIN_COUNT; c++) out << setw(8) << CABIN_CLASSES[c].shortName;
+    out << setw(10) << "Fare/km"
+        << setw(12) << "Status" << "\n";
+    out << string(100, '-') << "\n";
+    
+    // Rows come pre-rendered from the availability cache, by route and date
+    shared_ptr<const AvailabilityView> view = currentAvailability();
+    int shown = 0;
+    bool first = true;
+    bool more = false;
+    view->forEachFrom(cursor.key, [&](const AvailabilityBucket& bucket) {
+        if (!first || bucket.key != cursor.key) cursor.row = 0;
+        first = false;
+        size_t rows = bucket.rowEnds.size();
+        if (cursor.row >= rows) return true;
+        if (shown == CONSOLE_PAGE_ROWS) {
+            cursor.key = bucket.key;
+            more = true;
+            return false;
+        }
+        size_t last = min(rows, cursor.row + (CONSOLE_PAGE_ROWS - shown));
+        size_t begin = cursor.row == 0 ? 0 : bucket.rowEnds[cursor.row - 1];
+        out.write(bucket.rows.data() + begin, bucket.rowEnds[last - 1] - begin);
+        shown += last - cursor.row;
+        if (last < rows) {
+            cursor.key = bucket.key;
+            cursor.row = last;
+            more = true;
+            return false;
+        }
+        return true;
+    });
+    if (more) return true;
+    
+    if (view->bucketCount == 0) {
+        out << "No available flights at the moment.\n";
+    }
+    
+    out << "\nLegend: ";
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        if (strcmp(CABIN_CLASSES[c].shortName, CABIN_CLASSES[c].name) != 0) {
+            out << CABIN_CLASSES[c].shortName << "=" << CABIN_CLASSES[c].name << ", ";
+        }
+    }
+    out << "Fare/km=Base fare per 100 km\n";
+    return false;
+}
+
+void viewAvailableFlights() {
+    MetricTimer timer(METRIC_SEARCH);
+    if (tracing && traceSearches) traceRecord("S\t*\t*");
+    cout << "\n=== AVAILABLE FLIGHTS ===\n";
+    
+    if (liveFlightCount == 0) {
+        cout << "Sorry! No flights available at the moment.\n";
+        return;
+    }
+    
+    AvailabilityCursor cursor;
+    pageThrough([&](ostream& out) { return renderAvailableFlightsPage(cursor, out); });
+}
+
+// Writes the flights from slot cursor on, a page of them from one snapshot
+// so seats and revenue always agree, and leaves cursor past the page.
+bool renderFlightsPage(int& cursor, ostream& out) {
+    StoreSnapshot snapshot;
+    int shown = 0;
+    for (; cursor < snapshot.flightSlots; cursor++) {
+        Flight flight;
+        snapshot.readFlight(cursor, flight);
+        if (flight.deleted) continue;
+        if (shown == CONSOLE_PAGE_CARDS) return true;
+        shown++;
+        out << "\n--------------------------------------\n";
+        out << "Flight Number   : " << flight.flightNo << "\n";
+        out << "Origin          : " << cityName(flight.origin) << "\n";
+        out << "Destination     : " << cityName(flight.destination) << "\n";
+        out << "Departure Date  : " << flight.departureDate.day << "/"
+            << flight.departureDate.month << "/" << flight.departureDate.year << "\n";
+        out << "Departure Time  : " << flight.departureTime.hour << ":"
+            << flight.departureTime.minute << "\n";
+        out << "Arrival Date    : " << flight.arrivalDate.day << "/"
+            << flight.arrivalDate.month << "/" << flight.arrivalDate.year << "\n";
+        out << "Arrival Time    : " << flight.arrivalTime.hour << ":"
+            << flight.arrivalTime.minute << "\n";
+        out << "\n--- Seats & Fares ---\n";
+        for (int c = 0; c < CABIN_COUNT; c++) {
+            out << left << setw(16) << string(CABIN_CLASSES[c].label) + " Seats" << ": " << flight.classSeats[c]
+                << " | Fare: " << flight.classFares[c] << "\n";
+        }
+        out << "\nTotal Seats     : " << flight.totalSeats << "\n";
+        out << "Available Seats : " << flight.availableSeats << "\n";
+        out << "Distance        : " << flight.distance << " km" << "\n";
+        out << "Status          : " << FLIGHT_STATUS_NAMES[flight.status]
+            << (flight.availableSeats == 0 ? " (Full)" : "") << "\n";
+        out << "Times Booked    : " << flight.timesBooked << "\n";
+        out << "Total Revenue   : " << flight.totalRevenue << "\n";
+    }
+    out << "\n======================================\n";
+    return false;
+}
+
+void viewFlights() {
+    if (liveFlightCount == 0) {
+        cout << "\nNo flights available.\n";
+        return;
+    }
+
+    cout << "\n========== AVAILABLE FLIGHTS ==========\n";
+    int cursor = 0;
+    pageThrough([&](ostream& out) { return renderFlightsPage(cursor, out); });
+}
+
+// Writes a page of bookings in slot order from slot cursor on
+bool renderAllBookingsPage(int& cursor, ostream& out) {
+    printBookingListingHeader(out);
+    StoreSnapshot snapshot;
+    int shown = 0;
+    for (; cursor < snapshot.bookingSlots; cursor++) {
+        Booking booking;
+        snapshot.readBooking(cursor, booking);
+        if (booking.archived) continue;
+        if (shown == CONSOLE_PAGE_ROWS) return true;
+        shown++;
+        printBookingListingRow(out, booking);
+    }
+    return false;
+}
+
+void viewAllBookings() {
+    cout << "\n=== ALL BOOKINGS ===\n";
+    
+    if (liveBookingCount == 0) {
+        cout << "No bookings found.\n";
+        return;
+    }
+    
+    int cursor = 0;
+    pageThrough([&](ostream& out) { return renderAllBookingsPage(cursor, out); });
+}
+
+// Writes a page of the passenger table from index cursor on
+bool renderPassengerDetailsPage(int& cursor, ostream& out) {
+    int last = min(passengerCount, cursor + CONSOLE_PAGE_ROWS);
+    for (; cursor < last; cursor++) {
+        const Passenger& passenger = passengers[cursor];
+        out << "ID: " << passenger.id 
+            << " | Name: " << passenger.name
+            << " | Email: " << passenger.email
+            << " | Bookings: " << passenger.totalBookings
+            << " | Spent: $" << passenger.totalSpent
+            << " | Tier: " << LOYALTY_TIER_NAMES[loyaltyTier(passenger)]
+            << " | Miles: " << passenger.lifetimeMiles << "\n";
+    }
+    return cursor < passengerCount;
+}
+
+void viewPassengerDetails() {
+    waitForStoreEvents();
+    cout << "\n=== PASSENGER DETAILS ===\n";
+    int cursor = 0;
+    pageThrough([&](ostream& out) { return renderPassengerDetailsPage(cursor, out); });
+}
+
+// ========== LISTING QUERIES ==========
+
+// Admin listings over the whole flight or booking table. Rows are filtered
+// by predicates on their fields, ordered by up to MAX_LISTING_SORT_KEYS keys
+// and returned a page at a time. The slots of one snapshot are scanned in
+// pieces on the task scheduler; each piece keeps only the rows that can still
+// land on the requested page, so a page costs a scan plus a sort of
+// (page + 1) * pageSize rows per piece rather than a sort of the table.
+//
+// Query syntax, one line:
+//   [where FIELD OP VALUE [and FIELD OP VALUE]...] [sort FIELD [asc|desc] [, FIELD [asc|desc]]...]
+// OP is one of = != < <= > >=. Dates are dd/mm/yyyy; statuses, classes and
+// cities are given by name.
+enum ListingValueKind { VALUE_NUMBER, VALUE_DATE, VALUE_CITY, VALUE_FLIGHT_STATUS, VALUE_BOOKING_STATUS, VALUE_CABIN };
+
+struct ListingField {
+    const char* name;
+    ListingValueKind kind;
+};
+
+enum FlightListingField {
+    FLIGHT_FIELD_NUMBER, FLIGHT_FIELD_ORIGIN, FLIGHT_FIELD_DESTINATION, FLIGHT_FIELD_DEPARTURE,
+    FLIGHT_FIELD_DEPARTS_IN_HOURS, FLIGHT_FIELD_STATUS, FLIGHT_FIELD_AVAILABLE, FLIGHT_FIELD_SEATS,
+    FLIGHT_FIELD_LOAD, FLIGHT_FIELD_REVENUE, FLIGHT_FIELD_DISTANCE, FLIGHT_FIELD_FARE, FLIGHT_FIELD_COUNT
+};
+const ListingField FLIGHT_FIELDS[FLIGHT_FIELD_COUNT] = {
+    {"flight", VALUE_NUMBER}, {"origin", VALUE_CITY}, {"destination", VALUE_CITY},
+    {"departure", VALUE_DATE}, {"departs_in_hours", VALUE_NUMBER}, {"status", VALUE_FLIGHT_STATUS},
+    {"available", VALUE_NUMBER}, {"seats", VALUE_NUMBER}, {"load", VALUE_NUMBER},
+    {"revenue", VALUE_NUMBER}, {"distance", VALUE_NUMBER}, {"fare", VALUE_NUMBER}
+};
+
+enum BookingListingField {
+    BOOKING_FIELD_ID, BOOKING_FIELD_PASSENGER, BOOKING_FIELD_FLIGHT, BOOKING_FIELD_TRAVEL,
+    BOOKING_FIELD_TRAVEL_IN_DAYS, BOOKING_FIELD_BOOKED, BOOKING_FIELD_SEATS, BOOKING_FIELD_CLASS,
+    BOOKING_FIELD_FARE, BOOKING_FIELD_STATUS, BOOKING_FIELD_COUNT
+};
+const ListingField BOOKING_FIELDS[BOOKING_FIELD_COUNT] = {
+    {"id", VALUE_NUMBER}, {"passenger", VALUE_NUMBER}, {"flight", VALUE_NUMBER},
+    {"travel", VALUE_DATE}, {"travel_in_days", VALUE_NUMBER}, {"booked", VALUE_DATE},
+    {"seats", VALUE_NUMBER}, {"class", VALUE_CABIN}, {"fare", VALUE_NUMBER}, {"status", VALUE_BOOKING_STATUS}
+};
+
+enum ListingOp { LISTING_EQ, LISTING_NE, LISTING_LT, LISTING_LE, LISTING_GT, LISTING_GE };
+const char* const LISTING_OP_NAMES[] = {"=", "!=", "<", "<=", ">", ">="};
+
+struct ListingFilter {
+    int field;
+    ListingOp op;
+    double value;
+};
+
+const int MAX_LISTING_SORT_KEYS = 4;
+const int LISTING_PAGE_SIZE = 20;
+const int MIN_LISTING_ROWS_PER_PIECE = 16384;
+
+struct ListingSortKey {
+    int field;
+    bool descending;
+};
+
+struct ListingQuery {
+    vector<ListingFilter> filters;
+    vector<ListingSortKey> order;
+    int page;
+    int pageSize;
+};
+
+// Values every row of one query is measured against. Cities compare by the
+// rank of their name so sorting by a city is alphabetical.
+struct ListingContext {
+    double now;              // days since 1970-01-01, fraction for the time of day
+    vector<int> cityRank;    // indexed by CityId
+};
+
+template <typename Record>
+struct ListingRow {
+    int slot;
+    double keys[MAX_LISTING_SORT_KEYS];
+    Record record;
+};
+
+ListingContext makeListingContext() {
+    ListingContext context;
+    time_t now = time(0);
+    tm local;
+    localtime_r(&now, &local);
+    context.now = todayDayNumber() + (local.tm_hour * 60 + local.tm_min) / 1440.0;
+    
+    lock_guard<mutex> lock(cityMutex);
+    context.cityRank.assign(MAX_CITIES, -1);
+    int rank = 0;
+    context.cityRank[0] = rank++;
+    for (const auto& city : cityIds) context.cityRank[city.second] = rank++;
+    return context;
+}
+
+double flightFieldValue(const Flight& flight, int field, const ListingContext& context) {
+    double departure = daysFromCivil(flight.departureDate) +
+                       (flight.departureTime.hour * 60 + flight.departureTime.minute) / 1440.0;
+    switch (field) {
+        case FLIGHT_FIELD_NUMBER: return flight.flightNo;
+        case FLIGHT_FIELD_ORIGIN: return context.cityRank[flight.origin];
+        case FLIGHT_FIELD_DESTINATION: return context.cityRank[flight.destination];
+        case FLIGHT_FIELD_DEPARTURE: return departure;
+        case FLIGHT_FIELD_DEPARTS_IN_HOURS: return (departure - context.now) * 24;
+        case FLIGHT_FIELD_STATUS: return flight.status;
+        case FLIGHT_FIELD_AVAILABLE: return flight.availableSeats;
+        case FLIGHT_FIELD_SEATS: return flight.totalSeats;
+        case FLIGHT_FIELD_LOAD:
+            return flight.totalSeats > 0 ? 1.0 - (double)flight.availableSeats / flight.totalSeats : 0;
+        case FLIGHT_FIELD_REVENUE: return flight.totalRevenue;
+        case FLIGHT_FIELD_DISTANCE: return flight.distance;
+        case FLIGHT_FIELD_FARE: return flight.baseFare;
+    }
+    return 0;
+}
+
+double bookingFieldValue(const Booking& booking, int field, const ListingContext& context) {
+    switch (field) {
+        case BOOKING_FIELD_ID: return booking.bookingId;
+        case BOOKING_FIELD_PASSENGER: return booking.passengerId;
+        case BOOKING_FIELD_FLIGHT: return booking.flightNo;
+        case BOOKING_FIELD_TRAVEL: return packedDayNumber(booking.travelDate);
+        case BOOKING_FIELD_TRAVEL_IN_DAYS: return packedDayNumber(booking.travelDate) - (int)context.now;
+        case BOOKING_FIELD_BOOKED: return packedDayNumber(booking.bookingDate);
+        case BOOKING_FIELD_SEATS: return booking.seatsBooked;
+        case BOOKING_FIELD_CLASS: return booking.cabin;
+        case BOOKING_FIELD_FARE: return booking.fareCents / 100.0;
+        case BOOKING_FIELD_STATUS: return booking.status;
+    }
+    return 0;
+}
+
+// Names match ignoring case, spaces and underscores, so "in_flight" is "In Flight"
+bool sameListingName(const string& typed, const char* name) {
+    size_t t = 0;
+    for (const char* n = name;; n++) {
+        while (t < typed.size() && (typed[t] == '_' || typed[t] == ' ')) t++;
+        while (*n == ' ' || *n == '_') n++;
+        if (*n == '\0' || t == typed.size()) return *n == '\0' && t == typed.size();
+        if (tolower((unsigned char)typed[t++]) != tolower((unsigned char)*n)) return false;
+    }
+}
+
+bool parseListingValue(const string& text, ListingValueKind kind, const ListingContext& context, double& value) {
+    switch (kind) {
+        case VALUE_DATE: {
+            Date date;
+            char slash1, slash2;
+            istringstream in(text);
+            if (!(in >> date.day >> slash1 >> date.month >> slash2 >> date.year) ||
+                slash1 != '/' || slash2 != '/' || !isValidDate(date)) {
+                return false;
+            }
+            value = daysFromCivil(date);
+            return true;
+        }
+        case VALUE_CITY: {
+            CityId city = findCity(text.c_str());
+            value = city == CITY_NONE ? -1 : context.cityRank[city];
+            return true;
+        }
+        case VALUE_FLIGHT_STATUS:
+            for (int i = 0; i < FLIGHT_STATUS_COUNT; i++) {
+                if (sameListingName(text, FLIGHT_STATUS_NAMES[i])) {
+                    value = i;
+                    return true;
+                }
+            }
+            return false;
+        case VALUE_BOOKING_STATUS:
+            for (int i = 0; i < BOOKING_STATUS_COUNT; i++) {
+                if (sameListingName(text, BOOKING_STATUS_NAMES[i])) {
+                    value = i;
+                    return true;
+                }
+            }
+            return false;
+        case VALUE_CABIN:
+            for (int c = 0; c < CABIN_COUNT; c++) {
+                if (sameListingName(text, CABIN_CLASSES[c].name)) {
+                    value = c;
+                    return true;
+                }
+            }
+            return false;
+        case VALUE_NUMBER: {
+            char* end;
+            value = strtod(text.c_str(), &end);
+            return !text.empty() && *end == '\0';
+        }
+    }
+    return false;
+}
+
+int findListingField(const string& name, const ListingField fields[], int fieldCount) {
+    for (int i = 0; i < fieldCount; i++) {
+        if (name == fields[i].name) return i;
+    }
+    return -1;
+}
+
+// Parses a query line into filters and sort keys; on failure error says why
+bool parseListingQuery(const string& line, const ListingField fields[], int fieldCount,
+                       const ListingContext& context, ListingQuery& query, string& error) {
+    // Commas separate sort keys but may also be written against a field name
+    string spaced;
+    for (char c : line) {
+        if (c == ',') spaced += " , ";
+        else spaced += c;
+    }
+    istringstream in(spaced);
+    vector<string> words;
+    string word;
+    while (in >> word) words.push_back(word);
+    
+    size_t w = 0;
+    if (w < words.size() && words[w] == "where") {
+        w++;
+        while (true) {
+            if (w + 3 > words.size()) {
+                error = "Incomplete condition";
+                return false;
+            }
+            ListingFilter filter;
+            filter.field = findListingField(words[w], fields, fieldCount);
+            if (filter.field == -1) {
+                error = "Unknown field " + words[w];
+                return false;
+            }
+            int op = -1;
+            for (int o = 0; o <= LISTING_GE; o++) {
+                if (words[w + 1] == LISTING_OP_NAMES[o]) op = o;
+            }
+            if (op == -1) {
+                error = "Unknown operator " + words[w + 1];
+                return false;
+            }
+            filter.op = (ListingOp)op;
+            // A value may be several words, as in "In Flight"; it runs up to the next keyword
+            size_t end = w + 3;
+            while (end < words.size() && words[end] != "and" && words[end] != "sort") end++;
+            string value = words[w + 2];
+            for (size_t v = w + 3; v < end; v++) value += " " + words[v];
+            if (!parseListingValue(value, fields[filter.field].kind, context, filter.value)) {
+                error = "Invalid value for " + words[w] + ": " + value;
+                return false;
+            }
+            query.filters.push_back(filter);
+            w = end;
+            if (w < words.size() && words[w] == "and") {
+                w++;
+                continue;
+            }
+            break;
+        }
+    }
+    if (w < words.size() && words[w] == "sort") {
+        w++;
+        while (w < words.size()) {
+            ListingSortKey key;
+            key.field = findListingField(words[w], fields, fieldCount);
+            if (key.field == -1) {
+                error = "Unknown field " + words[w];
+                return false;
+            }
+            key.descending = false;
+            w++;
+            if (w < words.size() && (words[w] == "asc" || words[w] == "desc")) {
+                key.descending = words[w] == "desc";
+                w++;
+            }
+            if ((int)query.order.size() == MAX_LISTING_SORT_KEYS) {
+                error = "At most " + to_string(MAX_LISTING_SORT_KEYS) + " sort keys";
+                return false;
+            }
+            query.order.push_back(key);
+            if (w < words.size() && words[w] == ",") w++;
+            else break;
+        }
+    }
+    if (w != words.size()) {
+        error = "Unexpected " + words[w];
+        return false;
+    }
+    return true;
+}
+
+bool matchesListingFilter(double value, const ListingFilter& filter) {
+    switch (filter.op) {
+        case LISTING_EQ: return value == filter.value;
+        case LISTING_NE: return value != filter.value;
+        case LISTING_LT: return value < filter.value;
+        case LISTING_LE: return value <= filter.value;
+        case LISTING_GT: return value > filter.value;
+        case LISTING_GE: return value >= filter.value;
+    }
+    return false;
+}
+
+// Runs a query over slots [0, slots). read copies a slot and returns false
+// for a slot that holds no row; value measures a field of a row. Fills page
+// with the rows of the requested page and returns the number of matches.
+template <typename Record, typename Read, typename Value>
+long long runListingQuery(const ListingQuery& query, int slots, Read read, Value value,
+                          vector<ListingRow<Record>>& page) {
+    size_t keep = (size_t)(query.page + 1) * query.pageSize;
+    int keyCount = query.order.size();
+    auto before = [&](const ListingRow<Record>& a, const ListingRow<Record>& b) {
+        for (int k = 0; k < keyCount; k++) {
+            if (a.keys[k] != b.keys[k]) {
+                return query.order[k].descending ? a.keys[k] > b.keys[k] : a.keys[k] < b.keys[k];
+            }
+        }
+        return a.slot < b.slot;
+    };
+    
+    // Each piece keeps its best rows sorted; pieces merge up to the page end
+    struct Matches {
+        vector<ListingRow<Record>> rows;
+        long long total = 0;
+    };
+    Matches merged = parallelReduce(0, slots, MIN_LISTING_ROWS_PER_PIECE, Matches(),
+        [&](int begin, int end, Matches& part) {
+            vector<ListingRow<Record>>& rows = part.rows;
+            ListingRow<Record> row;
+            for (int slot = begin; slot < end; slot++) {
+                if (!read(slot, row.record)) continue;
+                bool match = true;
+                for (const ListingFilter& filter : query.filters) {
+                    if (!matchesListingFilter(value(row.record, filter.field), filter)) {
+                        match = false;
+                        break;
+                    }
+                }
+                if (!match) continue;
+                part.total++;
+                row.slot = slot;
+                for (int k = 0; k < keyCount; k++) row.keys[k] = value(row.record, query.order[k].field);
+                rows.push_back(row);
+                // Rows past the page can never be shown; trim when the buffer doubles
+                if (rows.size() >= 2 * keep + 1024) {
+                    nth_element(rows.begin(), rows.begin() + keep, rows.end(), before);
+                    rows.resize(keep);
+                }
+            }
+            if (rows.size() > keep) {
+                nth_element(rows.begin(), rows.begin() + keep, rows.end(), before);
+                rows.resize(keep);
+            }
+            sort(rows.begin(), rows.end(), before);
+        },
+        [&](Matches& into, Matches& part) {
+            into.total += part.total;
+            vector<ListingRow<Record>> next;
+            next.reserve(min(keep, into.rows.size() + part.rows.size()));
+            merge(into.rows.begin(), into.rows.end(), part.rows.begin(), part.rows.end(), back_inserter(next), before);
+            if (next.size() > keep) next.resize(keep);
+            into.rows.swap(next);
+        });
+    
+    size_t first = (size_t)query.page * query.pageSize;
+    page.assign(merged.rows.begin() + min(first, merged.rows.size()), merged.rows.end());
+    return merged.total;
+}
+
+long long queryFlights(const ListingQuery& query, const ListingContext& context, vector<ListingRow<Flight>>& page) {
+    StoreSnapshot snapshot;
+    return runListingQuery<Flight>(query, snapshot.flightSlots,
+        [&](int slot, Flight& flight) {
+            snapshot.readFlight(slot, flight);
+            return !flight.deleted && flight.flightNo != 0;
+        },
+        [&](const Flight& flight, int field) { return flightFieldValue(flight, field, context); },
+        page);
+}
+
+long long queryBookings(const ListingQuery& query, const ListingContext& context, vector<ListingRow<Booking>>& page) {
+    StoreSnapshot snapshot;
+    return runListingQuery<Booking>(query, snapshot.bookingSlots,
+        [&](int slot, Booking& booking) {
+            snapshot.readBooking(slot, booking);
+            return !booking.archived && booking.bookingId != 0;
+        },
+        [&](const Booking& booking, int field) { return bookingFieldValue(booking, field, context); },
+        page);
+}
+
+void printFlightListingHeader(ostream& out) {
+    out << left << setw(10) << "Flight #" << setw(14) << "From" << setw(14) << "To"
+         << setw(18) << "Departure" << setw(12) << "Seats Left" << setw(8) << "Load"
+         << setw(12) << "Revenue" << setw(12) << "Status" << "\n";
+}
+
+void printFlightListingRow(ostream& out, const Flight& flight) {
+    double load = flight.totalSeats > 0 ? 100.0 * (flight.totalSeats - flight.availableSeats) / flight.totalSeats : 0;
+    out << left << setw(10) << flight.flightNo
+         << setw(14) << cityName(flight.origin)
+         << setw(14) << cityName(flight.destination)
+         << setw(18) << formatDate(flight.departureDate) + " " + formatTime(flight.departureTime)
+         << setw(12) << to_string(flight.availableSeats) + "/" + to_string(flight.totalSeats)
+         << setw(8) << to_string((int)(load + 0.5)) + "%"
+         << setw(12) << fixed << setprecision(2) << flight.totalRevenue
+         << setw(12) << FLIGHT_STATUS_NAMES[flight.status] << "\n";
+}
+
+// Flights departing from now to the given number of hours ahead, soonest
+// first, found through the departure index rather than a scan of the store
+void viewDeparturesBoard() {
+    cout << "\n=== DEPARTURES BOARD ===\n";
+    int hours;
+    cout << "Show departures in the next how many hours? ";
+    readNumber(hours);
+    if (hours < 1) {
+        cout << "Invalid number of hours!\n";
+        return;
+    }
+    
+    time_t now = time(0);
+    tm currentTime;
+    localtime_r(&now, &currentTime);
+    long long nowMinute = (long long)todayDayNumber() * 1440 + currentTime.tm_hour * 60 + currentTime.tm_min;
+    vector<int> flightNos(liveFlightCount);
+    int found = findDepartingFlights(nowMinute, nowMinute + (long long)hours * 60, flightNos.data(), flightNos.size());
+    if (found == 0) {
+        cout << "No flights depart in the next " << hours << " hour(s).\n";
+        return;
+    }
+    
+    int cursor = 0;
+    pageThrough([&](ostream& out) {
+        printFlightListingHeader(out);
+        for (int shown = 0; cursor < found && shown < CONSOLE_PAGE_ROWS; cursor++) {
+            Flight flight;
+            if (!snapshotFlight(flightNos[cursor], flight)) continue;
+            printFlightListingRow(out, flight);
+            shown++;
+        }
+        if (cursor < found) return true;
+        out << found << " flight(s) depart in the next " << hours << " hour(s).\n";
+        return false;
+    });
+}
+
+void printBookingListingHeader(ostream& out) {
+    out << left << setw(12) << "Booking ID"
+         << setw(15) << "Passenger ID"
+         << setw(10) << "Flight #"
+         << setw(12) << "Travel Date"
+         << setw(10) << "Seats"
+         << setw(12) << "Class"
+         << setw(12) << "Fare Paid($)"
+         << setw(12) << "Status" << "\n";
+}
+
+void printBookingListingRow(ostream& out, const Booking& booking) {
+    out << left << setw(12) << booking.bookingId
+         << setw(15) << booking.passengerId
+         << setw(10) << booking.flightNo
+         << setw(12) << formatDate(unpackDate(booking.travelDate))
+         << setw(10) << booking.seatsBooked
+         << setw(12) << cabinName(booking.cabin)
+         << setw(12) << fixed << setprecision(2) << fromCents(booking.fareCents)
+         << setw(12) << BOOKING_STATUS_NAMES[booking.status] << "\n";
+}
+
+// Reads a query, then pages through its results until the admin quits.
+// Every page is computed afresh from the current store.
+template <typename Record, typename Query, typename PrintHeader, typename PrintRow>
+void browseListing(const char* title, const ListingField fields[], int fieldCount, const char* example,
+                   Query runQuery, PrintHeader printHeader, PrintRow printRow) {
+    cout << "\n=== " << title << " ===\n";
+    cout << "Fields:";
+    for (int i = 0; i < fieldCount; i++) cout << " " << fields[i].name;
+    cout << "\nExample: " << example << "\n";
+    cout << "Query (empty lists everything): ";
+    string line;
+    readLine(line);
+    
+    ListingContext context = makeListingContext();
+    ListingQuery query;
+    query.page = 0;
+    query.pageSize = LISTING_PAGE_SIZE;
+    string error;
+    if (!parseListingQuery(line, fields, fieldCount, context, query, error)) {
+        cout << "Invalid query: " << error << "\n";
+        return;
+    }
+    
+    while (true) {
+        vector<ListingRow<Record>> rows;
+        long long total = runQuery(query, context, rows);
+        long long pages = max(1LL, (total + query.pageSize - 1) / query.pageSize);
+        ostringstream page;
+        page << "\n";
+        printHeader(page);
+        for (const ListingRow<Record>& row : rows) printRow(page, row.record);
+        page << "Page " << query.page + 1 << " of " << pages << " (" << total << " match"
+             << (total == 1 ? "" : "es") << ")\n";
+        writePage(page);
+        cout << "[n]ext, [p]revious, [q]uit: ";
+        string command;
+        if (!readWord(command) || command == "q") break;
+        if (command == "n" && query.page + 1 < pages) query.page++;
+        else if (command == "p" && query.page > 0) query.page--;
+    }
+}
+
+void queryFlightListing() {
+    browseListing<Flight>("QUERY FLIGHTS", FLIGHT_FIELDS, FLIGHT_FIELD_COUNT,
+                          "where departs_in_hours >= 0 and departs_in_hours <= 24 sort load desc", queryFlights,
+                          printFlightListingHeader, printFlightListingRow);
+}
+
+void queryBookingListing() {
+    browseListing<Booking>("QUERY BOOKINGS", BOOKING_FIELDS, BOOKING_FIELD_COUNT,
+                           "where flight = 101 and status != cancelled sort fare desc, id", queryBookings,
+                           printBookingListingHeader, printBookingListingRow);
+}
+
+// ========== BOOKING FUNCTIONS ==========
+
+void bookFlight() {
+    if (currentPassengerId == -1) {
+        cout << "You must login first!\n";
+        return;
+    }
+    
+    RequestScope request;
+    cout << "\n=== BOOK A FLIGHT ===\n";
+    viewAvailableFlights();
+    
+    if (liveFlightCount == 0) {
+        cout << "No flights available to book.\n";
+        return;
+    }
+    
+    int flightChoice;
+    cout << "\nEnter Flight Number to book (0 to cancel): ";
+    readNumber(flightChoice);
+    
+    if (flightChoice == 0) return;
+    
+    int flightIndex = -1;
+    Flight* selectedFlight = findFlightByNumber(flightChoice, flightIndex);
+    
+    if (selectedFlight && !isOpenForBooking(*selectedFlight)) {
+        selectedFlight = nullptr;
+    }
+    
+    if (!selectedFlight) {
+        cout << "Invalid flight selection or flight not available!\n";
+        return;
+    }
+    
+    // Check available seats
+    if (selectedFlight->availableSeats <= 0) {
+        cout << "Sorry, this flight is fully booked!\n";
+        return;
+    }
+    
+    int seats;
+    int maxSeats = min(selectedFlight->availableSeats, MAX_SEATS_PER_BOOKING);
+    cout << "Number of seats to book (1-" << maxSeats << "): ";
+    readNumber(seats);
+    
+    while (seats < 1 || seats > maxSeats) {
+        if (inputEnded()) return;
+        cout << "Invalid! Enter between 1 and " << maxSeats << " seats: ";
+        readNumber(seats);
+    }
+    
+    cout << "\nSelect Class Type:\n";
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        ArenaStream multiplier;
+        multiplier << fixed << setprecision(1) << CABIN_CLASSES[c].fareMultiplier;
+        cout << c + 1 << ". " << CABIN_CLASSES[c].label << " (" << multiplier.str() << "x)\n";
+    }
+    
+    int classChoice;
+    cout << "Enter choice (1-" << CABIN_COUNT << "): ";
+    readNumber(classChoice);
+    
+    unsigned char cabin = classChoice - 1;
+    if (classChoice < 1 || classChoice > CABIN_COUNT) {
+        cout << "Invalid choice! Defaulting to " << CABIN_CLASSES[CABIN_ECONOMY].name << ".\n";
+        cabin = CABIN_ECONOMY;
+    }
+    int classSeatsAvailable = selectedFlight->classSeats[cabin];
+    
+    // Check if enough seats in selected class
+    if (seats > classSeatsAvailable) {
+        cout << "Sorry! Only " << classSeatsAvailable << " seats available in " << cabinName(cabin) << " class.\n";
+        return;
+    }
+    
+    Date travelDate;
+    cout << "\nEnter travel date (DD MM YYYY): ";
+    readNumber(travelDate.day) && readNumber(travelDate.month) && readNumber(travelDate.year);
+    
+    if (!isValidDate(travelDate)) {
+        cout << "Invalid date!\n";
+        return;
+    }
+    
+    if (!isFutureDate(travelDate)) {
+        cout << "Travel date must be in the future!\n";
+        return;
+    }
+    
+    float fare = calculateFare(*selectedFlight, seats, cabin);
+    float loyaltyFare = applyLoyaltyDiscount(fare, currentPassengerId);
+    
+    cout << "\n=== BOOKING SUMMARY ===\n";
+    cout << "Flight: " << cityName(selectedFlight->origin) << " to " << cityName(selectedFlight->destination) << "\n";
+    cout << "Date: " << travelDate.day << "/" << travelDate.month << "/" << travelDate.year << "\n";
+    cout << "Seats: " << seats << " (" << cabinName(cabin) << " class)\n";
+    
+    // Show fare breakdown
+    displayFareBreakdown(cout, *selectedFlight, seats, cabin);
+    
+    if (loyaltyFare < fare) {
+        Passenger* passenger = findPassengerById(currentPassengerId);
+        cout << "Loyalty discount (" << LOYALTY_TIER_NAMES[loyaltyTier(*passenger)] << "): -$"
+             << fixed << setprecision(2) << fare - loyaltyFare << "\n";
+        fare = loyaltyFare;
+    }
+    cout << "Total Fare: $" << fixed << setprecision(2) << fare << "\n";
+    
+    char confirm;
+    cout << "\nConfirm booking? (Y/N): ";
+    readChar(confirm);
+    
+    if (confirm != 'Y' && confirm != 'y') {
+        cout << "Booking cancelled.\n";
+        return;
+    }
+   
+    Booking newBooking;
+    newBooking.bookingId = generateBookingId();
+    newBooking.passengerId = currentPassengerId;
+    newBooking.flightNo = flightChoice;
+    
+    // Set booking date to current date
+    time_t now = time(0);
+    tm currentTime;
+    localtime_r(&now, &currentTime);
+    newBooking.bookingDate = packDate({currentTime.tm_mday, currentTime.tm_mon + 1, currentTime.tm_year + 1900});
+    
+    newBooking.travelDate = packDate(travelDate);
+    newBooking.seatsBooked = seats;
+    newBooking.cabin = cabin;
+    newBooking.fareCents = toCents(fare);
+    newBooking.status = BOOKING_CONFIRMED;
+    
+
+    string error;
+    if (commitBooking(newBooking, error) == -1) {
+        cout << "Error: " << error << "!\n";
+        return;
+    }
+    
+    // Show confirmation and generate receipt
+    cout << "\n Booking confirmed! Booking ID: " << newBooking.bookingId << "\n";
+    cout << " Generating receipt...\n\n";
+    
+    // The receipt does not show the passenger's totals, so there is no need to
+    // wait for the consumer: take its copy if it is ready, else render it here
+    string receipt;
+    if (takeRenderedReceipt(newBooking.bookingId, receipt)) cout << receipt;
+    else generateBookingReceipt(newBooking.bookingId);
+    
+    cout << "\n IMPORTANT: Save your Booking ID: " << newBooking.bookingId << "\n";
+    cout << "You can view this receipt anytime from 'View Booking Receipt' in menu.\n";
+}
+
+void viewFlightDetailsWithSeats() {
+    cout << "\n=== FLIGHT DETAILS WITH SEAT AVAILABILITY ===\n";
+    
+    if (liveFlightCount == 0) {
+        cout << "No flights available.\n";
+        return;
+    }
+    
+    int flightNo;
+    cout << "Enter Flight Number to view details (0 to cancel): ";
+    readNumber(flightNo);
+    
+    if (flightNo == 0) return;
+    
+    Flight flightCopy;
+    Flight* flight = snapshotFlight(flightNo, flightCopy) ? &flightCopy : nullptr;
+    
+    if (!flight) {
+        cout << "Flight not found!\n";
+        return;
+    }
+    
+    cout << "\n========================================\n";
+    cout << "     FLIGHT DETAILS: " << flight->flightNo << "\n";
+    cout << "========================================\n";
+    
+    cout << "\nRoute: " << cityName(flight->origin) << " to " << cityName(flight->destination) << "\n";
+    cout << "Distance: " << flight->distance << " km\n";
+    cout << "Base Fare: $" << flight->baseFare << " per 100 km\n";
+    
+    cout << "\n--- Departure ---\n";
+    cout << "Date: " << formatDate(flight->departureDate) << "\n";
+    cout << "Time: " << formatTime(flight->departureTime) << "\n";
+    
+    cout << "\n--- Arrival ---\n";
+    cout << "Date: " << formatDate(flight->arrivalDate) << "\n";
+    cout << "Time: " << formatTime(flight->arrivalTime) << "\n";
+    
+    cout << "\n--- SEAT AVAILABILITY ---\n";
+    cout << left << setw(15) << "CLASS" 
+         << setw(10) << "SEATS" 
+         << setw(15) << "AVAILABLE" 
+         << setw(15) << "FARE PER SEAT" << "\n";
+    cout << string(55, '-') << "\n";
+    
+    // Calculate fares per seat based on distance
+    float distanceFare = flight->distance * (flight->baseFare / 100);
+    
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        cout << left 
+             << setw(15) << CABIN_CLASSES[c].label
+             << setw(10) << flight->classSeats[c]
+             << setw(15) << flight->classSeats[c]
+             << setw(15) << "$" + to_string(distanceFare * CABIN_CLASSES[c].fareMultiplier) << "\n";
+    }
+    
+    cout << "\nTotal Seats: " << flight->totalSeats << "\n";
+    cout << "Status: " << FLIGHT_STATUS_NAMES[flight->status] << "\n";
+    cout << "========================================\n";
+}
+
+// Where the next page of a passenger's bookings starts: the slot of the next
+// row and the booking it held, plus the bookings already shown
+struct PassengerBookingsCursor {
+    int passengerId = -1;
+    int slot = -1;
+    int bookingId = 0;
+    set<int> shownIds;
+};
+
+// Writes a page of a passenger's bookings, walking their booking list from
+// the cursor on. Rows are copied out under storeMutex so none is read
+// half-written. Between pages the sweep may archive the next booking and
+// hand its slot to someone else's booking, so the cursor is only followed
+// while its slot still holds the same booking; otherwise the list is walked
+// again from the start, skipping the bookings already shown.
+bool renderPassengerBookingsPage(PassengerBookingsCursor& cursor, ostream& out) {
+    Booking rows[CONSOLE_PAGE_ROWS];
+    int shown = 0;
+    {
+        lock_guard<mutex> lock(storeMutex);
+        int slot = cursor.slot;
+        bool valid = slot != -1 && !bookings[slot].archived &&
+                     bookings[slot].bookingId == cursor.bookingId &&
+                     bookings[slot].passengerId == cursor.passengerId;
+        if (!valid) {
+            Passenger* passenger = findPassengerById(cursor.passengerId);
+            slot = passenger ? passenger->firstBooking : -1;
+        }
+        for (; slot != -1 && shown < CONSOLE_PAGE_ROWS; slot = bookingPassengerLinks[slot]) {
+            if (bookings[slot].archived || cursor.shownIds.count(bookings[slot].bookingId)) continue;
+            rows[shown++] = bookings[slot];
+            cursor.shownIds.insert(bookings[slot].bookingId);
+        }
+        while (slot != -1 && (bookings[slot].archived || cursor.shownIds.count(bookings[slot].bookingId))) {
+            slot = bookingPassengerLinks[slot];
+        }
+        cursor.slot = slot;
+        cursor.bookingId = slot == -1 ? 0 : bookings[slot].bookingId;
+    }
+    
+    out << left << setw(12) << "Booking ID"
+        << setw(10) << "Flight #"
+        << setw(15) << "Travel Date"
+        << setw(10) << "Seats"
+        << setw(12) << "Class"
+        << setw(12) << "Fare Paid($)"
+        << setw(12) << "Status" << "\n";
+    
+    for (int i = 0; i < shown; i++) {
+        out << left << setw(12) << rows[i].bookingId
+            << setw(10) << rows[i].flightNo
+            << setw(15) << formatDate(unpackDate(rows[i].travelDate))
+            << setw(10) << rows[i].seatsBooked
+            << setw(12) << cabinName(rows[i].cabin)
+            << setw(12) << fixed << setprecision(2) << fromCents(rows[i].fareCents)
+            << setw(12) << BOOKING_STATUS_NAMES[rows[i].status] << "\n";
+    }
+    
+    if (shown == 0) {
+        out << "No bookings found.\n";
+    }
+    return cursor.slot != -1;
+}
+
+void displayPassengerBookings() {
+    cout << "\n===== YOUR BOOKINGS =====\n";
+    
+    PassengerBookingsCursor cursor;
+    cursor.passengerId = currentPassengerId;
+    pageThrough([&](ostream& out) { return renderPassengerBookingsPage(cursor, out); });
+}
+
+void cancelBooking() {
+    if (currentPassengerId == -1) {
+        cout << "You must login first!\n";
+        return;
+    }
+    
+    cout << "\n=== CANCEL BOOKING ===\n";
+    displayPassengerBookings();
+    
+    bool hasBookings = false;
+    {
+        lock_guard<mutex> lock(storeMutex);
+        Passenger* passenger = findPassengerById(currentPassengerId);
+        for (int i = passenger ? passenger->firstBooking : -1; i != -1 && !hasBookings; i = bookingPassengerLinks[i]) {
+            hasBookings = !bookings[i].archived && bookings[i].status == BOOKING_CONFIRMED;
+        }
+    }
+    
+    if (!hasBookings) {
+        cout << "\nYou have no active bookings to cancel.\n";
+        return;
+    }
+    
+    int bookingId;
+    cout << "\nEnter Booking ID to cancel (0 to go back): ";
+    readNumber(bookingId);
+    
+    if (bookingId == 0) return;
+    
+    int bookingIndex = -1;
+    Booking cancelling;
+    Booking* bookingToCancel = findBookingById(bookingId, cancelling, bookingIndex) ? &cancelling : nullptr;
+    
+    if (!bookingToCancel) {
+        cout << "Invalid Booking ID or booking not found!\n";
+        return;
+    }
+    
+    if (bookingToCancel->status == BOOKING_CANCELLED) {
+        cout << "This booking is already cancelled.\n";
+        return;
+    }
+    
+    if (!BOOKING_TRANSITIONS[bookingToCancel->status][BOOKING_CANCELLED]) {
+        cout << "Cannot cancel a booking that is " << BOOKING_STATUS_NAMES[bookingToCancel->status] << ".\n";
+        return;
+    }
+    
+    float refundAmount = calculateRefundAmount(*bookingToCancel);
+    
+    cout << "\n=== CANCELLATION DETAILS ===\n";
+    cout << "Booking ID: " << bookingToCancel->bookingId << "\n";
+    cout << "Flight Number: " << bookingToCancel->flightNo << "\n";
+    cout << "Travel Date: " << formatDate(unpackDate(bookingToCancel->travelDate)) << "\n";
+    cout << "Seats: " << bookingToCancel->seatsBooked << "\n";
+    cout << "Class: " << cabinName(bookingToCancel->cabin) << "\n";
+    cout << "Original Fare: $" << fixed << setprecision(2) << fromCents(bookingToCancel->fareCents) << "\n";
+    cout << "Refund Amount: $" << fixed << setprecision(2) << refundAmount << "\n";
+    
+    if (refundAmount == 0) {
+        cout << "Note: No refund as cancellation is too close to travel date.\n";
+    }
+    
+    char confirm;
+    cout << "\nAre you sure you want to cancel this booking? (Y/N): ";
+    readChar(confirm);
+    
+    if (confirm != 'Y' && confirm != 'y') {
+        cout << "Cancellation cancelled.\n";
+        return;
+    }
+    
+    string error;
+    if (!commitCancellation(bookingIndex, bookingId, refundAmount, error)) {
+        cout << "Error: " << error << "!\n";
+        return;
+    }
+    
+    cout << "\n=== CANCELLATION SUCCESSFUL ===\n";
+    cout << "Booking ID " << bookingToCancel->bookingId << " has been cancelled.\n";
+    
+    if (refundAmount > 0) {
+        cout << "Refund of $" << fixed << setprecision(2) << refundAmount 
+             << " will be processed to your account.\n";
+    }
+}
+
+void groupBookFlight() {
+    if (currentPassengerId == -1) {
+        cout << "You must login first!\n";
+        return;
+    }
+    
+    cout << "\n=== GROUP BOOKING ===\n";
+    viewAvailableFlights();
+    
+    int travellerCount;
+    cout << "\nNumber of travellers (1-" << MAX_GROUP_TRAVELLERS << ", 0 to cancel): ";
+    readNumber(travellerCount);
+    if (travellerCount == 0) return;
+    if (travellerCount < 1 || travellerCount > MAX_GROUP_TRAVELLERS) {
+        cout << "Invalid number of travellers!\n";
+        return;
+    }
+    
+    vector<string> travellers(travellerCount);
+    for (int t = 0; t < travellerCount; t++) {
+        cout << "Traveller " << t + 1 << " full name: ";
+        readLine(travellers[t]);
+        if (travellers[t].empty()) {
+            cout << "Name cannot be empty!\n";
+            return;
+        }
+    }
+    
+    int legCount;
+    cout << "Number of flights in the journey (1-4): ";
+    readNumber(legCount);
+    if (legCount < 1 || legCount > 4) {
+        cout << "Invalid number of flights!\n";
+        return;
+    }
+    
+    vector<GroupLeg> legs(legCount);
+    float total = 0.0;
+    float loyaltyTotal = 0.0;
+    string classMenu;
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        classMenu += (c ? ", " : "") + to_string(c + 1) + " " + CABIN_CLASSES[c].name;
+    }
+    for (int l = 0; l < legCount; l++) {
+        int classChoice;
+        cout << "Flight " << l + 1 << " - Flight Number and class (" << classMenu << "): ";
+        readNumber(legs[l].flightNo) && readNumber(classChoice);
+        if (classChoice < 1 || classChoice > CABIN_COUNT) {
+            cout << "Invalid class!\n";
+            return;
+        }
+        legs[l].cabin = classChoice - 1;
+        
+        Flight flight;
+        if (!snapshotFlight(legs[l].flightNo, flight) || !isOpenForBooking(flight)) {
+            cout << "Flight #" << legs[l].flightNo << " is not available!\n";
+            return;
+        }
+        float legFare = calculateFare(flight, travellerCount, legs[l].cabin);
+        cout << "  " << cityName(flight.origin) << " to " << cityName(flight.destination) << " on " << formatDate(flight.departureDate)
+             << ", " << travellerCount << " x " << cabinName(legs[l].cabin) << ": $" << fixed << setprecision(2) << legFare << "\n";
+        total += legFare;
+        // Priced per seat as commitGroupBooking charges it
+        float seatFare = applyLoyaltyDiscount(calculateFare(flight, 1, legs[l].cabin), currentPassengerId);
+        loyaltyTotal += fromCents(toCents(seatFare)) * travellerCount;
+    }
+    
+    if (toCents(loyaltyTotal) < toCents(total)) {
+        Passenger* passenger = findPassengerById(currentPassengerId);
+        cout << "Loyalty discount (" << LOYALTY_TIER_NAMES[loyaltyTier(*passenger)] << "): -$"
+             << fixed << setprecision(2) << total - loyaltyTotal << "\n";
+    }
+    cout << "\nTotal Fare for the group: $" << fixed << setprecision(2) << loyaltyTotal << "\n";
+    char confirm;
+    cout << "Confirm group booking? (Y/N): ";
+    readChar(confirm);
+    if (confirm != 'Y' && confirm != 'y') {
+        cout << "Booking cancelled.\n";
+        return;
+    }
+    
+    string error;
+    int groupId = commitGroupBooking(currentPassengerId, legs, travellers, error);
+    if (groupId == -1) {
+        cout << "Error: " << error << "! No seats were reserved.\n";
+        return;
+    }
+    cout << "\n Group booking confirmed! Group ID: " << groupId << " ("
+         << travellerCount * legCount << " seat(s))\n";
+}
+
+void manageGroupBooking() {
+    if (currentPassengerId == -1) {
+        cout << "You must login first!\n";
+        return;
+    }
+    
+    int groupId;
+    cout << "\nEnter Group ID (0 to go back): ";
+    readNumber(groupId);
+    if (groupId == 0) return;
+    
+    GroupBooking group;
+    {
+        lock_guard<mutex> lock(storeMutex);
+        auto found = groupBookings.find(groupId);
+        if (found == groupBookings.end() || found->second.leadPassengerId != currentPassengerId) {
+            cout << "Group booking not found!\n";
+            return;
+        }
+        group = found->second;
+    }
+    
+    int legCount = group.legs.size();
+    cout << "\n=== GROUP BOOKING #" << groupId << " ===\n";
+    cout << left << setw(5) << "No." << setw(30) << "Traveller";
+    for (int l = 0; l < legCount; l++) {
+        cout << setw(18) << "Flight #" + to_string(group.legs[l].flightNo);
+    }
+    cout << "\n";
+    for (int t = 0; t < (int)group.travellers.size(); t++) {
+        cout << left << setw(5) << t + 1 << setw(30) << group.travellers[t];
+        for (int l = 0; l < legCount; l++) {
+            const Booking& booking = bookings[group.memberSlots[t * legCount + l]];
+            bool current = !booking.archived && booking.bookingId == group.memberBookingIds[t * legCount + l];
+            cout << setw(18) << (current ? BOOKING_STATUS_NAMES[booking.status] : "Archived");
+        }
+        cout << "\n";
+    }
+    
+    int cancelCount;
+    cout << "\nNumber of travellers to cancel (0 to go back): ";
+    readNumber(cancelCount);
+    if (cancelCount <= 0) return;
+    
+    vector<int> chosen(cancelCount);
+    cout << "Traveller numbers to cancel: ";
+    for (int c = 0; c < cancelCount; c++) {
+        readNumber(chosen[c]);
+        chosen[c]--;
+    }
+    
+    char confirm;
+    cout << "Cancel all flights of these " << cancelCount << " traveller(s)? (Y/N): ";
+    readChar(confirm);
+    if (confirm != 'Y' && confirm != 'y') {
+        cout << "Cancellation cancelled.\n";
+        return;
+    }
+    
+    float refund;
+    string error;
+    if (!commitGroupCancellation(groupId, currentPassengerId, chosen, refund, error)) {
+        cout << "Error: " << error << "! Nothing was cancelled.\n";
+        return;
+    }
+    cout << "\n=== CANCELLATION SUCCESSFUL ===\n";
+    cout << "Refund of $" << fixed << setprecision(2) << refund << " will be processed to your account.\n";
+}
+
+// ========== REPORT FUNCTIONS ==========
+
+const int REPORT_SLOTS_PER_PIECE = 16384;
+
+// Booking counts by status and the fares paid for one passenger's bookings
+struct BookingTotals {
+    int byStatus[BOOKING_STATUS_COUNT] = {};
+    long long fareCents = 0;
+};
+
+// One pass over the snapshot, in pieces on the task scheduler. Fares are
+// summed in cents so the total does not depend on how the pieces fell.
+BookingTotals tallyPassengerBookings(const StoreSnapshot& snapshot, int passengerId) {
+    return parallelReduce(0, snapshot.bookingSlots, REPORT_SLOTS_PER_PIECE, BookingTotals(),
+        [&](int begin, int end, BookingTotals& part) {
+            for (int i = begin; i < end; i++) {
+                Booking booking;
+                snapshot.readBooking(i, booking);
+                if (!booking.archived && booking.passengerId == passengerId) {
+                    part.byStatus[booking.status]++;
+                    part.fareCents += booking.fareCents;
+                }
+            }
+        },
+        [](BookingTotals& into, const BookingTotals& part) {
+            for (int s = 0; s < BOOKING_STATUS_COUNT; s++) into.byStatus[s] += part.byStatus[s];
+            into.fareCents += part.fareCents;
+        });
+}
+
+void displayPassengerInfo() {
+    waitForStoreEvents();
+    cout << "\n=== PASSENGER INFORMATION ===\n";
+    
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == currentPassengerId) {
+            cout << "Passenger ID: " << passengers[i].id << "\n";
+            cout << "Name: " << passengers[i].name << "\n";
+            cout << "Email: " << passengers[i].email << "\n";
+            cout << "Phone: " << passengers[i].phone << "\n";
+            cout << "Total Bookings: " << passengers[i].totalBookings << "\n";
+            cout << "Total Spent: $" << fixed << setprecision(2) << passengers[i].totalSpent << "\n";
+            int tier = loyaltyTier(passengers[i]);
+            cout << "Loyalty Tier: " << LOYALTY_TIER_NAMES[tier];
+            if (LOYALTY_DISCOUNT[tier] > 0) cout << " (" << (int)(LOYALTY_DISCOUNT[tier] * 100 + 0.5) << "% off fares)";
+            cout << "\n";
+            cout << "Lifetime Miles: " << passengers[i].lifetimeMiles << "\n";
+            break;
+        }
+    }
+    cout << "------------------------------\n";
+}
+
+void displayBookingSummary(const StoreSnapshot& snapshot) {
+    cout << "\n=== BOOKING SUMMARY ===\n";
+    
+    BookingTotals totals = tallyPassengerBookings(snapshot, currentPassengerId);
+    int confirmed = totals.byStatus[BOOKING_CONFIRMED];
+    int inFlight = totals.byStatus[BOOKING_IN_FLIGHT];
+    int completed = totals.byStatus[BOOKING_COMPLETED];
+    int cancelled = totals.byStatus[BOOKING_CANCELLED];
+    int totalBookings = confirmed + inFlight + completed + cancelled;
+    double totalSpent = totals.fareCents / 100.0;
+    
+    cout << "Total Bookings: " << totalBookings << "\n";
+    cout << "Active Bookings: " << confirmed + inFlight << "\n";
+    cout << "Completed Bookings: " << completed << "\n";
+    cout << "Cancelled Bookings: " << cancelled << "\n";
+    cout << "Total Amount Spent: $" << fixed << setprecision(2) << totalSpent << "\n";
+    cout << "------------------------------\n";
+}
+
+void displayBookingHistory(const StoreSnapshot& snapshot) {
+    cout << "\n=== BOOKING HISTORY ===\n";
+    
+    bool hasBookings = false;
+    for (int i = 0; i < snapshot.bookingSlots; i++) {
+        Booking booking;
+        snapshot.readBooking(i, booking);
+        if (!booking.archived && booking.passengerId == currentPassengerId) {
+            hasBookings = true;
+            break;
+        }
+    }
+    
+    if (!hasBookings) {
+        cout << "No booking history found.\n";
+        return;
+    }
+    
+    cout << left << setw(12) << "Booking ID" 
+         << setw(10) << "Flight #" 
+         << setw(12) << "Book Date" 
+         << setw(12) << "Travel Date" 
+         << setw(8) << "Seats" 
+         << setw(10) << "Class" 
+         << setw(10) << "Fare($)" 
+         << setw(12) << "Status" << "\n";
+    
+    for (int i = 0; i < snapshot.bookingSlots; i++) {
+        Booking booking;
+        snapshot.readBooking(i, booking);
+        if (!booking.archived && booking.passengerId == currentPassengerId) {
+            string bookDate = formatDate(unpackDate(booking.bookingDate));
+            string travelDate = formatDate(unpackDate(booking.travelDate));
+            
+            cout << left << setw(12) << booking.bookingId
+                 << setw(10) << booking.flightNo
+                 << setw(12) << bookDate
+                 << setw(12) << travelDate
+                 << setw(8) << booking.seatsBooked
+                 << setw(10) << cabinName(booking.cabin)
+                 << setw(10) << fixed << setprecision(2) << fromCents(booking.fareCents)
+                 << setw(12) << BOOKING_STATUS_NAMES[booking.status] << "\n";
+        }
+    }
+    cout << "------------------------------\n";
+}
+
+void displayRecentBookings(const StoreSnapshot& snapshot) {
+    cout << "\n=== RECENT BOOKINGS ===\n";
+    
+    int count = 0;
+    for (int i = snapshot.bookingSlots - 1; i >= 0 && count < 3; i--) {
+        Booking booking;
+        snapshot.readBooking(i, booking);
+        if (!booking.archived && booking.passengerId == currentPassengerId) {
+            count++;
+            string origin = "Unknown";
+            string destination = "Unknown";
+            
+            Flight flight;
+            if (snapshot.findFlight(booking.flightNo, flight)) {
+                origin = cityName(flight.origin);
+                destination = cityName(flight.destination);
+            }
+            
+            string travelDate = formatDate(unpackDate(booking.travelDate));
+            
+            cout << count << ". Booking #" << booking.bookingId << "\n";
+            cout << "   Flight: " << origin << " to " << destination << "\n";
+            cout << "   Travel Date: " << travelDate << "\n";
+            cout << "   Seats: " << booking.seatsBooked << " (" << cabinName(booking.cabin) << ")\n";
+            cout << "   Fare: $" << fixed << setprecision(2) << fromCents(booking.fareCents) << "\n";
+            cout << "   Status: " << BOOKING_STATUS_NAMES[booking.status] << "\n";
+            cout << "   ------------------------------\n";
+        }
+    }
+    
+    if (count == 0) {
+        cout << "No recent bookings found.\n";
+    }
+}
+
+void generatePersonalReport() {
+    if (currentPassengerId == -1) {
+        cout << "You must login first!\n";
+        return;
+    }
+    
+    cout << "\n========================================\n";
+    cout << "      PERSONAL BOOKING REPORT\n";
+    cout << "========================================\n";
+    
+    // Every section reads the same point-in-time view of the bookings
+    StoreSnapshot snapshot;
+    displayPassengerInfo();
+    displayBookingSummary(snapshot);
+    displayBookingHistory(snapshot);
+    displayRecentBookings(snapshot);
+    
+    time_t now = time(0);
+    tm currentTime;
+    localtime_r(&now, &currentTime);
+    cout << "\nReport Generated: " 
+         << formatDate({currentTime.tm_mday, currentTime.tm_mon + 1, currentTime.tm_year + 1900})
+         << " at " << formatTime({currentTime.tm_hour, currentTime.tm_min}) << "\n";
+    
+    cout << "========================================\n";
+    cout << "          END OF REPORT\n";
+    cout << "========================================\n";
+}
+
+// ========== PROFILE UPDATE FUNCTIONS ==========
+
+void displayCurrentProfile() {
+    waitForStoreEvents();
+    cout << "\n=== YOUR CURRENT PROFILE ===\n";
+    
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == currentPassengerId) {
+            cout << "1. Name: " << passengers[i].name << "\n";
+            cout << "2. Email: " << passengers[i].email << "\n";
+            cout << "3. Phone: " << passengers[i].phone << "\n";
+            cout << "4. Password: ********\n";
+            cout << "------------------------------\n";
+            cout << "Total Bookings: " << passengers[i].totalBookings << "\n";
+            cout << "Total Spent: $" << fixed << setprecision(2) << passengers[i].totalSpent << "\n";
+            break;
+        }
+    }
+}
+
+void updateName() {
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == currentPassengerId) {
+            char newName[50];
+            cout << "\nCurrent Name: " << passengers[i].name << "\n";
+            cout << "Enter new name: ";
+            readLine(newName, 50);
+            
+            if (strlen(newName) > 0) {
+                strcpy(passengers[i].name, newName);
+                publishPassengerEvent(EVENT_PROFILE_UPDATED, currentPassengerId, "name");
+                cout << "Name updated successfully!\n";
+            } else {
+                cout << "Name cannot be empty!\n";
+            }
+            return;
+        }
+    }
+}
+
+void updateEmail() {
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == currentPassengerId) {
+            char newEmail[50];
+            cout << "\nCurrent Email: " << passengers[i].email << "\n";
+            
+            while (true) {
+                cout << "Enter new email: ";
+                if (!readLine(newEmail, 50)) return;
+                
+                if (strlen(newEmail) == 0) {
+                    cout << "Email cannot be empty!\n";
+                    continue;
+                }
+                
+                if (isValidEmail(newEmail)) {
+                    bool emailExists = false;
+                    for (int j = 0; j < passengerCount; j++) {
+                        if (j != i && strcmp(passengers[j].email, newEmail) == 0) {
+                            emailExists = true;
+                            break;
+                        }
+                    }
+                    
+                    if (emailExists) {
+                        cout << "This email is already registered!\n";
+                    } else {
+                        strcpy(passengers[i].email, newEmail);
+                        publishPassengerEvent(EVENT_PROFILE_UPDATED, currentPassengerId, "email");
+                        cout << "Email updated successfully!\n";
+                        break;
+                    }
+                } else {
+                    cout << "Invalid email format! Use format: user@domain.com\n";
+                }
+            }
+            return;
+        }
+    }
+}
+
+void updatePhone() {
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == currentPassengerId) {
+            char newPhone[15];
+            cout << "\nCurrent Phone: " << passengers[i].phone << "\n";
+            cout << "Enter new phone number: ";
+            readLine(newPhone, 15);
+            
+            if (strlen(newPhone) > 0) {
+                strcpy(passengers[i].phone, newPhone);
+                publishPassengerEvent(EVENT_PROFILE_UPDATED, currentPassengerId, "phone");
+                cout << "Phone number updated successfully!\n";
+            } else {
+                cout << "Phone number cannot be empty!\n";
+            }
+            return;
+        }
+    }
+}
+
+void updatePassword() {
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == currentPassengerId) {
+            char currentPass[30];
+            char newPass[30];
+            char confirmPass[30];
+            
+            cout << "\n=== CHANGE PASSWORD ===\n";
+            cout << "Enter current password: ";
+            readLine(currentPass, 30);
+            
+            if (strcmp(passengers[i].password, currentPass) != 0) {
+                cout << "Current password is incorrect!\n";
+                return;
+            }
+            
+            while (true) {
+                cout << "Enter new password (min 6 characters): ";
+                if (!readLine(newPass, 30)) return;
+                
+                if (strlen(newPass) < 6) {
+                    cout << "Password must be at least 6 characters!\n";
+                    continue;
+                }
+                
+                cout << "Confirm new password: ";
+                readLine(confirmPass, 30);
+                
+                if (strcmp(newPass, confirmPass) != 0) {
+                    cout << "Passwords do not match!\n";
+                } else {
+                    strcpy(passengers[i].password, newPass);
+                    publishPassengerEvent(EVENT_PROFILE_UPDATED, currentPassengerId, "password");
+                    cout << "Password changed successfully!\n";
+                    break;
+                }
+            }
+            return;
+        }
+    }
+}
+
+void updateProfile() {
+    if (currentPassengerId == -1) {
+        cout << "You must login first!\n";
+        return;
+    }
+    
+    int choice;
+    bool updating = true;
+    
+    while (updating) {
+        cout << "\n========================================\n";
+        cout << "          UPDATE PROFILE\n";
+        cout << "========================================\n";
+        
+        displayCurrentProfile();
+        
+        cout << "\nWhat would you like to update?\n";
+        cout << "1. Update Name\n";
+        cout << "2. Update Email\n";
+        cout << "3. Update Phone Number\n";
+        cout << "4. Change Password\n";
+        cout << "5. Back to Main Menu\n";
+        cout << "----------------------------------------\n";
+        cout << "Enter your choice (1-5): ";
+        
+        if (!readNumber(choice) && inputEnded()) return;
+        
+        switch(choice) {
+            case 1: updateName(); break;
+            case 2: updateEmail(); break;
+            case 3: updatePhone(); break;
+            case 4: updatePassword(); break;
+            case 5: 
+                cout << "Returning to main menu...\n";
+                updating = false;
+                break;
+            default:
+                cout << "Invalid choice! Please enter 1-5.\n";
+        }
+        
+        if (choice >= 1 && choice <= 4) {
+            char more;
+            cout << "\nDo you want to update something else? (Y/N): ";
+            readChar(more);
+            
+            if (more != 'Y' && more != 'y') {
+                updating = false;
+                cout << "Profile update completed.\n";
+            }
+        }
+    }
+}
+
+// ========== ADMIN FUNCTIONS ==========
+
+void adminMenu() {
+    int choice;
+    bool loggedIn = true;
+    
+    while (loggedIn) {
+        cout << "\n===== ADMIN PANEL =====\n";
+        cout << "1. Add Flight\n";
+        cout << "2. View All Flights\n";
+        cout << "3. Update Flight\n";
+        cout << "4. Delete Flight\n";
+        cout << "5. View All Bookings\n";
+        cout << "6. View Passenger Details\n";
+        cout << "7. Bulk Schedule Update\n";
+        cout << "8. Update Flight Status\n";
+        cout << "9. Run Completion Sweep\n";
+        cout << "10. Configure Refund Policy\n";
+        cout << "11. View System Metrics\n";
+        cout << "12. Query Flights\n";
+        cout << "13. Query Bookings\n";
+        cout << "14. Departures Board\n";
+        cout << "15. Logout\n";
+        cout << "Enter choice: ";
+        if (!readNumber(choice) && inputEnded()) break;
+        
+        switch(choice) {
+            case 1:
+                addFlight();
+                break;
+            case 2:
+                viewFlights();
+                break;
+            case 3:
+                updateFlight();
+                break;
+            case 4:
+                deleteFlight();
+                break;
+            case 5:
+                viewAllBookings();
+                break;
+            case 6:
+                viewPassengerDetails();
+                break;
+            case 7:
+                bulkScheduleUpdate();
+                break;
+            case 8:
+                updateFlightStatus();
+                break;
+            case 9:
+                sweepBookingPartitions();
+                cout << "Sweep finished. " << liveBookingCount << " booking(s) in "
+                     << bookingPartitions.size() << " travel day partition(s) remain in memory.\n";
+                break;
+            case 10:
+                configureRefundPolicy();
+                break;
+            case 11:
+                viewMetrics();
+                break;
+            case 12:
+                queryFlightListing();
+                break;
+            case 13:
+                queryBookingListing();
+                break;
+            case 14:
+                viewDeparturesBoard();
+                break;
+            case 15:
+                cout << "Logging out...\n";
+                loggedIn = false;
+                break;
+            default:
+                cout << "Invalid choice!\n";
+        }
+    }
+}
+
+void adminLoginPanel() {
+    cout << "\n=== ADMIN LOGIN ===\n";
+    
+    string username, password;
+    cout << "Enter Admin Username: ";
+    readWord(username);
+    cout << "Enter Admin Password: ";
+    readWord(password);
+    
+    if (username == "admin" && password == "1234") 
+    {
+        cout << "\nLogin successful! Welcome Admin!\n";
+     
+        auditActor = AUDIT_ACTOR_ADMIN;
+        adminMenu();
+        auditActor = AUDIT_ACTOR_SYSTEM;
+    } else 
+    {
+        cout << "Access Denied! Invalid credentials.\n";
+    }
+}
+
+void addFlight() {
+    if (liveFlightCount >= MAX_FLIGHTS) {
+        cout << "Cannot add more flights. Maximum capacity reached.\n";
+        return;
+    }
+    
+    int flightNo;
+    int existingIndex = -1;
+    do {
+        cout << "Enter Flight Number (positive integer): ";
+        readNumber(flightNo);
+        if (flightNo <= 0) cout << "Invalid flight number!\n";
+        else if (findFlightByNumber(flightNo, existingIndex)) {
+            cout << "Flight number already exists!\n";
+            flightNo = 0;
+        }
+    } while (flightNo <= 0 && !inputEnded());
+    
+    Flight flight = Flight();
+    flight.flightNo = flightNo;
+    
+    char city[50];
+    cout << "Enter Origin: ";
+    readLine(city, 50);
+    flight.origin = internCity(city);
+    
+    cout << "Enter Destination: ";
+    readLine(city, 50);
+    flight.destination = internCity(city);
+    
+    int day, month, year;
+    do {
+        cout << "Enter Departure Date (dd mm yyyy): ";
+        readNumber(day) && readNumber(month) && readNumber(year);
+        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
+    } while (!isValidDate(day, month, year) && !inputEnded());
+    flight.departureDate = {day, month, year};
+    
+    int hour, minute;
+    do {
+        cout << "Enter Departure Time (hh mm, 0-23 & 0-59): ";
+        readNumber(hour) && readNumber(minute);
+        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
+    } while (!isValidTime(hour, minute) && !inputEnded());
+    flight.departureTime = {hour, minute};
+    
+    do {
+        cout << "Enter Arrival Date (dd mm yyyy): ";
+        readNumber(day) && readNumber(month) && readNumber(year);
+        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
+    } while (!isValidDate(day, month, year) && !inputEnded());
+    flight.arrivalDate = {day, month, year};
+    
+    do {
+        cout << "Enter Arrival Time (hh mm, 0-23 & 0-59): ";
+        readNumber(hour) && readNumber(minute);
+        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
+    } while (!isValidTime(hour, minute) && !inputEnded());
+    flight.arrivalTime = {hour, minute};
+    
+    flight.totalSeats = 0;
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        do
+        {
+            cout << "Enter " << CABIN_CLASSES[c].label << " Seats: ";
+            readNumber(flight.classSeats[c]);
+        } while (flight.classSeats[c] < 0 && !inputEnded());
+        flight.totalSeats += flight.classSeats[c];
+    }
+    
+    for (int c = 0; c < CABIN_COUNT; c++) {
+        do 
+        {
+            cout << "Enter " << CABIN_CLASSES[c].label << " Fare(per KM): ";
+            readNumber(flight.classFares[c]);
+        } while (flight.classFares[c] < 0 && !inputEnded());
+    }
+    
+    flight.availableSeats = flight.totalSeats;
+    
+    do 
+    {
+        cout << "Enter Distance (positive): ";
+        readNumber(flight.distance);
+        if (flight.distance < 0) cout << "Invalid distance!\n";
+    } while (flight.distance < 0 && !inputEnded());
+    
+    flight.baseFare = fareIn<CABIN_ECONOMY>(flight);
+    
+    if (inputEnded()) return;
+    if (addFlightRecord(flight) == -1) {
+        cout << "\nFlight could not be added: the number was taken or the schedule is full.\n";
+        return;
+    }
+    cout << "\nFlight added successfully!\n";
+}
+
+void updateFlight() {
+    if (liveFlightCount == 0) {
+        cout << "No flights available to update.\n";
+        return;
+    }
+    
+    int flightNo;
+    cout << "Enter Flight Number to update: ";
+    readNumber(flightNo);
+    
+    int index = -1;
+    if (!findFlightByNumber(flightNo, index)) {
+        cout << "Flight not found.\n";
+        return;
+    }
+    
+    Flight edited;
+    if (!snapshotFlight(flightNo, edited)) {
+        cout << "Flight not found.\n";
+        return;
+    }
+    
+    cout << "\nUpdating Flight #" << edited.flightNo << ":\n";
+    
+    FlightUpdate update = {};
+    cout << "Enter new Origin (current: " << cityName(edited.origin) << "): ";
+    readLine(update.origin, 50);
+    
+    cout << "Enter new Destination (current: " << cityName(edited.destination) << "): ";
+    readLine(update.destination, 50);
+    
+    int day, month, year;
+    do {
+        cout << "Enter new Departure Date (dd mm yyyy): ";
+        readNumber(day) && readNumber(month) && readNumber(year);
+        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
+    } while (!isValidDate(day, month, year) && !inputEnded());
+    edited.departureDate = {day, month, year};
+    
+    int hour, minute;
+    do {
+        cout << "Enter new Departure Time (hh mm): ";
+        readNumber(hour) && readNumber(minute);
+        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
+    } while (!isValidTime(hour, minute) && !inputEnded());
+    edited.departureTime = {hour, minute};
+    
+    do {
+        cout << "Enter new Arrival Date (dd mm yyyy): ";
+        readNumber(day) && readNumber(month) && readNumber(year);
+        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
+    } while (!isValidDate(day, month, year) && !inputEnded());
+    edited.arrivalDate = {day, month, year};
+    
+    do {
+        cout << "Enter new Arrival Time (hh mm): ";
+        readNumber(hour) && readNumber(minute);
+        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
+    } while (!isValidTime(hour, minute) && !inputEnded());
+    edited.arrivalTime = {hour, minute};
+    if (inputEnded()) return;
+    
+    // The edit goes through the same path as bulk updates, so a retimed
+    // flight's travellers move with it
+    update.flightNo = flightNo;
+    update.fields = UPDATE_DEPARTURE | UPDATE_ARRIVAL;
+    // A blank city keeps the current one; the route is only sent if one changed
+    if (update.origin[0] != '\0' || update.destination[0] != '\0') {
+        if (update.origin[0] == '\0') strncpy(update.origin, cityName(edited.origin), sizeof(update.origin) - 1);
+        if (update.destination[0] == '\0') strncpy(update.destination, cityName(edited.destination), sizeof(update.destination) - 1);
+        update.fields |= UPDATE_ROUTE;
+    }
+    update.departureDate = edited.departureDate;
+    update.departureTime = edited.departureTime;
+    update.arrivalDate = edited.arrivalDate;
+    update.arrivalTime = edited.arrivalTime;
+    update.status = edited.status;
+    
+    string error;
+    RemovalOutcome outcome;
+    if (!applyFlightUpdates(&update, 1, error, &outcome)) {
+        cout << "Update rejected: " << error << "\n";
+        return;
     }
     
-    // Check if enough seats in selected class
-    if (seats > classSeatsAvailable) {
-        cout << "Sorry! Only " << classSeatsAvailable << " seats available in " << classType << " class.\n";
+    printRemovalOutcome(outcome);
+    cout << "Flight updated successfully!\n";
+}
+
+void deleteFlight() {
+    if (liveFlightCount == 0) {
+        cout << "No flights available to delete.\n";
         return;
     }
     
-    Date travelDate;
-    cout << "\nEnter travel date (DD MM YYYY): ";
-    cin >> travelDate.day >> travelDate.month >> travelDate.year;
+    int flightNo;
+    cout << "Enter Flight Number to delete: ";
+    readNumber(flightNo);
     
-    if (!isValidDate(travelDate)) {
-        cout << "Invalid date!\n";
+    int index = -1;
+    if (!findFlightByNumber(flightNo, index)) {
+        cout << "Flight not found.\n";
         return;
     }
     
-    if (!isFutureDate(travelDate)) {
-        cout << "Travel date must be in the future!\n";
+    RemovalOutcome outcome;
+    deleteFlightRecord(flightNo, &outcome);
+    printRemovalOutcome(outcome);
+    cout << "Flight #" << flightNo << " deleted successfully!\n";
+}
+
+// Removes a flight and re-accommodates or refunds its bookings as one change,
+// adding what happened to them to outcome if given
+bool deleteFlightRecord(int flightNo, RemovalOutcome* outcome) {
+    StoreTransaction transaction;
+    int slot = lookupFlightSlot(flightNo);
+    if (slot == -1) return false;
+    
+    RemovalOutcome unreported;
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    publishFlightEvent(EVENT_FLIGHT_DELETED, flights[slot], 0, "");
+    cascadeFlightRemoval(flights[slot], outcome ? *outcome : unreported);
+    removeFlight(slot);
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    
+    if (tracing) traceRecord("D\t" + to_string(flightNo));
+    return true;
+}
+
+// Stores a complete flight record; returns its slot or -1 if the number is taken or the store is full
+int addFlightRecord(const Flight& record) {
+    StoreTransaction transaction;
+    if (liveFlightCount >= MAX_FLIGHTS || lookupFlightSlot(record.flightNo) != -1) return -1;
+    if (record.origin == CITY_NONE || record.destination == CITY_NONE) return -1;
+    
+    int slot = allocateFlightSlot();
+    versionFlight(slot);
+    flights[slot] = record;
+    flights[slot].status = FLIGHT_SCHEDULED;
+    flights[slot].timesBooked = 0;
+    flights[slot].totalRevenue = 0.0;
+    flights[slot].deleted = false;
+    flights[slot].firstBooking = -1;
+    for (int c = 0; c < CABIN_COUNT; c++) flightHeldSeats[slot][c] = 0;
+    indexFlight(record.flightNo, slot);
+    departureIndex.insert(make_pair(departureMinute(flights[slot]), slot));
+    liveFlightCount++;
+    markAvailabilityStale(slot);
+    publishFlightEvent(EVENT_FLIGHT_ADDED, flights[slot], 0, (string(cityName(record.origin)) + "-" + cityName(record.destination)).c_str());
+    
+    if (tracing) traceRecord(traceFlightFields(flights[slot]));
+    return slot;
+}
+
+// Registers a passenger under the next sequential ID; returns the ID or -1 when full
+int addPassengerRecord(const char* name, const char* password, const char* email, const char* phone) {
+    lock_guard<mutex> lock(storeMutex);
+    if (passengerCount >= MAX_PASSENGERS) return -1;
+    
+    Passenger& passenger = passengers[passengerCount];
+    passenger.id = 1000 + passengerCount + 1;
+    strncpy(passenger.name, name, sizeof(passenger.name) - 1);
+    strncpy(passenger.password, password, sizeof(passenger.password) - 1);
+    strncpy(passenger.email, email, sizeof(passenger.email) - 1);
+    strncpy(passenger.phone, phone, sizeof(passenger.phone) - 1);
+    passenger.totalBookings = 0;
+    passenger.totalSpent = 0.0;
+    passenger.lifetimeMiles = 0;
+    passenger.rollingMiles = 0;
+    memset(passenger.monthlyMiles, 0, sizeof(passenger.monthlyMiles));
+    passenger.loyaltyWindowMonth = 0;
+    passenger.firstBooking = -1;
+    passenger.lastBooking = -1;
+    passengerCount++;
+    publishPassengerEvent(EVENT_PASSENGER_REGISTERED, passenger.id, "");
+    
+    if (tracing) traceRecord(tracePassengerFields(passenger));
+    return passenger.id;
+}
+
+// ========== FLIGHT STATUS FUNCTIONS ==========
+
+bool parseFlightStatus(const string& name, FlightStatus& status) {
+    for (int i = 0; i < FLIGHT_STATUS_COUNT; i++) {
+        if (name == FLIGHT_STATUS_NAMES[i]) {
+            status = (FlightStatus)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Propagates a flight status change to the flight's bookings through its
+// booking list. The caller holds storeMutex.
+void fanOutFlightStatus(Flight& flight, FlightStatus previous, RemovalOutcome& outcome) {
+    if (flight.status == FLIGHT_CANCELLED) {
+        cascadeFlightRemoval(flight, outcome);
         return;
     }
     
-    float fare = calculateFare(*selectedFlight, seats, classType);
+    BookingStatus from, to;
+    if (flight.status == FLIGHT_DEPARTED) {
+        from = BOOKING_CONFIRMED;
+        to = BOOKING_IN_FLIGHT;
+    } else if (flight.status == FLIGHT_ARRIVED && previous == FLIGHT_DEPARTED) {
+        from = BOOKING_IN_FLIGHT;
+        to = BOOKING_COMPLETED;
+    } else {
+        return;
+    }
     
-    cout << "\n=== BOOKING SUMMARY ===\n";
-    cout << "Flight: " << selectedFlight->origin << " to " << selectedFlight->destination << "\n";
-    cout << "Date: " << travelDate.day << "/" << travelDate.month << "/" << travelDate.year << "\n";
-    cout << "Seats: " << seats << " (" << classType << " class)\n";
+    for (int i = flight.firstBooking; i != -1; i = bookings[i].nextOnFlight) {
+        if (bookings[i].status == from && BOOKING_TRANSITIONS[from][to]) {
+            versionBooking(i);
+            bookings[i].status = to;
+        }
+    }
+}
+
+bool setFlightStatus(int flightNo, FlightStatus next, string& error, RemovalOutcome* outcome) {
+    StoreTransaction transaction;
     
-    // Show fare breakdown
-    displayFareBreakdown(*selectedFlight, seats, classType);
+    int slot = lookupFlightSlot(flightNo);
+    if (slot == -1) {
+        error = "Flight not found";
+        return false;
+    }
     
-    cout << "Total Fare: $" << fixed << setprecision(2) << fare << "\n";
+    Flight& flight = flights[slot];
+    FlightStatus previous = flight.status;
+    if (!FLIGHT_TRANSITIONS[previous][next]) {
+        error = string("Cannot go from ") + FLIGHT_STATUS_NAMES[previous] + " to " + FLIGHT_STATUS_NAMES[next];
+        return false;
+    }
     
-    char confirm;
-    cout << "\nConfirm booking? (Y/N): ";
-    cin >> confirm;
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    versionFlight(slot);
+    flight.status = next;
+    RemovalOutcome unreported;
+    fanOutFlightStatus(flight, previous, outcome ? *outcome : unreported);
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    markAvailabilityStale(slot);
+    publishFlightEvent(EVENT_FLIGHT_STATUS, flight, 0, FLIGHT_STATUS_NAMES[next]);
     
-    if (confirm != 'Y' && confirm != 'y') {
-        cout << "Booking cancelled.\n";
+    if (tracing) traceRecord(string("T\t") + to_string(flightNo) + '\t' + FLIGHT_STATUS_NAMES[next]);
+    return true;
+}
+
+void updateFlightStatus() {
+    cout << "\n=== UPDATE FLIGHT STATUS ===\n";
+    
+    int flightNo;
+    cout << "Enter Flight Number: ";
+    readNumber(flightNo);
+    
+    Flight flight;
+    if (!snapshotFlight(flightNo, flight)) {
+        cout << "Flight not found.\n";
+        return;
+    }
+    
+    cout << "Current status: " << FLIGHT_STATUS_NAMES[flight.status] << "\n";
+    cout << "Allowed next status:\n";
+    bool any = false;
+    for (int i = 0; i < FLIGHT_STATUS_COUNT; i++) {
+        if (FLIGHT_TRANSITIONS[flight.status][i]) {
+            cout << i + 1 << ". " << FLIGHT_STATUS_NAMES[i] << "\n";
+            any = true;
+        }
+    }
+    if (!any) {
+        cout << "None, this flight is closed.\n";
+        return;
+    }
+    
+    int choice;
+    cout << "Enter choice: ";
+    readNumber(choice);
+    
+    string error;
+    RemovalOutcome outcome;
+    if (choice < 1 || choice > FLIGHT_STATUS_COUNT) {
+        cout << "Invalid choice!\n";
+    } else if (setFlightStatus(flightNo, (FlightStatus)(choice - 1), error, &outcome)) {
+        printRemovalOutcome(outcome);
+        cout << "Flight #" << flightNo << " is now " << FLIGHT_STATUS_NAMES[choice - 1] << ".\n";
+    } else {
+        cout << error << "\n";
+    }
+}
+
+// ========== BULK SCHEDULE UPDATE FUNCTIONS ==========
+
+// Applies a batch of flight updates as one transaction. The batch is staged on
+// copies of the touched flights and validated as a whole; if anything is wrong
+// nothing is applied. Only bookings of touched flights are recomputed.
+bool applyFlightUpdates(const FlightUpdate updates[], int count, string& error, RemovalOutcome* outcome) {
+    StoreTransaction transaction;
+    RemovalOutcome unreported;
+    
+    // Copy-on-write staging: each touched flight is copied once
+    vector<Flight> staged;
+    vector<int> stagedSlots;
+    map<int, int> stagedIndexOfSlot;   // by flight slot; a batch touches few of them
+    vector<int> capacity;   // new seat capacity per class, -1 if unchanged
+    bool seatsChanged = false;
+    
+    for (int u = 0; u < count; u++) {
+        const FlightUpdate& update = updates[u];
+        int slot = lookupFlightSlot(update.flightNo);
+        if (slot == -1) {
+            error = "Flight " + to_string(update.flightNo) + " not found";
+            return false;
+        }
+        auto found = stagedIndexOfSlot.try_emplace(slot, (int)staged.size());
+        if (found.second) {
+            staged.push_back(flights[slot]);
+            stagedSlots.push_back(slot);
+            capacity.insert(capacity.end(), CABIN_COUNT, -1);
+        }
+        int s = found.first->second;
+        Flight& flight = staged[s];
+        
+        if (update.fields & UPDATE_DEPARTURE) {
+            if (!isValidDate(update.departureDate.day, update.departureDate.month, update.departureDate.year) ||
+                !isValidTime(update.departureTime.hour, update.departureTime.minute)) {
+                error = "Invalid departure for flight " + to_string(update.flightNo);
+                return false;
+            }
+            flight.departureDate = update.departureDate;
+            flight.departureTime = update.departureTime;
+        }
+        if (update.fields & UPDATE_ARRIVAL) {
+            if (!isValidDate(update.arrivalDate.day, update.arrivalDate.month, update.arrivalDate.year) ||
+                !isValidTime(update.arrivalTime.hour, update.arrivalTime.minute)) {
+                error = "Invalid arrival for flight " + to_string(update.flightNo);
+                return false;
+            }
+            flight.arrivalDate = update.arrivalDate;
+            flight.arrivalTime = update.arrivalTime;
+        }
+        if (update.fields & UPDATE_SEATS) {
+            for (int c = 0; c < CABIN_COUNT; c++) {
+                if (update.classSeats[c] < 0) {
+                    error = "Invalid seat count for flight " + to_string(update.flightNo);
+                    return false;
+                }
+                capacity[s * CABIN_COUNT + c] = update.classSeats[c];
+            }
+            seatsChanged = true;
+        }
+        if (update.fields & UPDATE_FARES) {
+            for (int c = 0; c < CABIN_COUNT; c++) {
+                if (update.classFares[c] < 0) {
+                    error = "Invalid fare for flight " + to_string(update.flightNo);
+                    return false;
+                }
+                flight.classFares[c] = update.classFares[c];
+            }
+            flight.baseFare = fareIn<CABIN_ECONOMY>(flight);
+        }
+        if (update.fields & UPDATE_DISTANCE) {
+            if (update.distance < 0) {
+                error = "Invalid distance for flight " + to_string(update.flightNo);
+                return false;
+            }
+            flight.distance = update.distance;
+        }
+        if (update.fields & UPDATE_ROUTE) {
+            flight.origin = update.origin[0] == '\0' ? CITY_NONE : internCity(update.origin);
+            flight.destination = update.destination[0] == '\0' ? CITY_NONE : internCity(update.destination);
+            if (flight.origin == CITY_NONE || flight.destination == CITY_NONE) {
+                error = "Invalid route for flight " + to_string(update.flightNo);
+                return false;
+            }
+        }
+        if (update.fields & UPDATE_STATUS && update.status != flight.status) {
+            if (!FLIGHT_TRANSITIONS[flight.status][update.status]) {
+                error = "Flight " + to_string(update.flightNo) + " cannot go from " +
+                        FLIGHT_STATUS_NAMES[flight.status] + " to " + FLIGHT_STATUS_NAMES[update.status];
+                return false;
+            }
+            flight.status = update.status;
+        }
+    }
+    
+    // Seats already sold per class, counted only for flights whose capacity
+    // changes. Booking lists differ a lot in length, so flights are recounted
+    // on the task scheduler; the first flight in batch order that cannot take
+    // its new capacity is the one reported.
+    if (seatsChanged) {
+        vector<int> booked(staged.size() * CABIN_COUNT, 0);
+        vector<char> oversold(staged.size(), 0);
+        parallelFor(0, staged.size(), 0, [&](int begin, int end) {
+            for (int s = begin; s < end; s++) {
+                if (capacity[s * CABIN_COUNT] == -1) continue;
+                Flight& flight = staged[s];
+                for (int i = flight.firstBooking; i != -1; i = bookings[i].nextOnFlight) {
+                    if (!occupiesSeats(bookings[i])) continue;
+                    booked[s * CABIN_COUNT + bookings[i].cabin] += bookings[i].seatsBooked;
+                }
+                // Seats held by booking sessions stay off sale like sold ones
+                const int* held = flightHeldSeats[stagedSlots[s]];
+                int totalBooked = 0;
+                flight.totalSeats = 0;
+                for (int c = 0; c < CABIN_COUNT; c++) {
+                    int taken = booked[s * CABIN_COUNT + c] + held[c];
+                    if (capacity[s * CABIN_COUNT + c] < taken) {
+                        oversold[s] = 1;
+                        break;
+                    }
+                    flight.classSeats[c] = capacity[s * CABIN_COUNT + c] - taken;
+                    totalBooked += taken;
+                    flight.totalSeats += capacity[s * CABIN_COUNT + c];
+                }
+                flight.availableSeats = flight.totalSeats - totalBooked;
+            }
+        });
+        for (size_t s = 0; s < staged.size(); s++) {
+            if (oversold[s]) {
+                error = "Flight " + to_string(staged[s].flightNo) +
+                        " already has more seats sold than the new capacity";
+                return false;
+            }
+        }
+    }
+    
+    // Publish: readers retry while the epoch is odd
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    atomic_thread_fence(memory_order_release);
+    
+    for (size_t s = 0; s < staged.size(); s++) {
+        int slot = stagedSlots[s];
+        int shiftDays = daysFromCivil(staged[s].departureDate) - daysFromCivil(flights[slot].departureDate);
+        FlightStatus previous = flights[slot].status;
+        long long previousDeparture = departureMinute(flights[slot]);
+        versionFlight(slot);
+        flights[slot] = staged[s];
+        markAvailabilityStale(slot);
+        if (departureMinute(flights[slot]) != previousDeparture) {
+            departureIndex.erase(make_pair(previousDeparture, slot));
+            departureIndex.insert(make_pair(departureMinute(flights[slot]), slot));
+        }
+        
+        if (shiftDays != 0) {
+            // Retimed flight: its travellers move with it
+            for (int i = flights[slot].firstBooking; i != -1; i = bookings[i].nextOnFlight) {
+                if (bookings[i].status == BOOKING_CONFIRMED) {
+                    versionBooking(i);
+                    bookings[i].travelDate = (PackedDate)(bookings[i].travelDate + shiftDays);
+                }
+            }
+            bookingPartitionsNeedRefile = true;
+        }
+        if (flights[slot].status != previous) {
+            fanOutFlightStatus(flights[slot], previous, outcome ? *outcome : unreported);
+        }
+    }
+    
+    flightStoreEpoch.fetch_add(1, memory_order_release);
+    for (int u = 0; u < count; u++) {
+        publishFlightEvent(EVENT_FLIGHT_UPDATED, flights[lookupFlightSlot(updates[u].flightNo)], updates[u].fields, "");
+    }
+    
+    if (tracing) {
+        for (int u = 0; u < count; u++) traceRecord(traceUpdateFields(updates[u]));
+    }
+    return true;
+}
+
+// Reads a batch file with one change per line:
+//   <flightNo> departure DD MM YYYY HH MM
+//   <flightNo> arrival DD MM YYYY HH MM
+//   <flightNo> seats <one count per cabin, in CABIN_CLASSES order>
+//   <flightNo> fares <one fare per cabin, in CABIN_CLASSES order>
+//   <flightNo> distance <km>
+//   <flightNo> status Scheduled|Boarding|Departed|Arrived|Delayed|Cancelled
+void bulkScheduleUpdate() {
+    cout << "\n=== BULK SCHEDULE UPDATE ===\n";
+    
+    string path;
+    cout << "Enter batch file path: ";
+    readWord(path);
+    
+    ifstream file(path);
+    if (!file) {
+        cout << "Cannot open " << path << "\n";
+        return;
+    }
+    
+    vector<FlightUpdate> updates;
+    string line;
+    int lineNo = 0;
+    while (getline(file, line)) {
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+        
+        istringstream in(line);
+        FlightUpdate update = {};
+        string field;
+        in >> update.flightNo >> field;
+        
+        if (field == "departure") {
+            update.fields = UPDATE_DEPARTURE;
+            in >> update.departureDate.day >> update.departureDate.month >> update.departureDate.year
+               >> update.departureTime.hour >> update.departureTime.minute;
+        } else if (field == "arrival") {
+            update.fields = UPDATE_ARRIVAL;
+            in >> update.arrivalDate.day >> update.arrivalDate.month >> update.arrivalDate.year
+               >> update.arrivalTime.hour >> update.arrivalTime.minute;
+        } else if (field == "seats") {
+            update.fields = UPDATE_SEATS;
+            for (int c = 0; c < CABIN_COUNT; c++) in >> update.classSeats[c];
+        } else if (field == "fares") {
+            update.fields = UPDATE_FARES;
+            for (int c = 0; c < CABIN_COUNT; c++) in >> update.classFares[c];
+        } else if (field == "distance") {
+            update.fields = UPDATE_DISTANCE;
+            in >> update.distance;
+        } else if (field == "status") {
+            string status;
+            in >> status;
+            if (parseFlightStatus(status, update.status)) update.fields = UPDATE_STATUS;
+        }
+        
+        if (update.fields == 0 || in.fail()) {
+            cout << "Line " << lineNo << " is malformed, batch not applied.\n";
+            return;
+        }
+        updates.push_back(update);
+    }
+    
+    string error;
+    RemovalOutcome outcome;
+    if (applyFlightUpdates(updates.data(), updates.size(), error, &outcome)) {
+        printRemovalOutcome(outcome);
+        cout << updates.size() << " change(s) applied.\n";
+    } else {
+        cout << "Batch rejected: " << error << "\n";
+    }
+}
+
+
+//============================================================
+
+void showPassengerMenu() {
+    int choice;
+    bool loggedIn = true;
+    
+    while (loggedIn) {
+        cout << "\n=== PASSENGER MENU ===\n";
+        cout << "1. View Available Flights (Summary)\n";
+        cout << "2. View Flight Details with Seats\n";
+        cout << "3. Book a Flight\n";
+        cout << "4. View My Bookings\n";
+        cout << "5. Cancel Booking\n";
+        cout << "6. View Booking Receipt\n";
+        cout << "7. Generate Personal Report\n";
+        cout << "8. Update Profile\n";
+        cout << "9. Group Booking\n";
+        cout << "10. Manage Group Booking\n";
+        cout << "11. Logout\n";
+        cout << "\nEnter your choice (1-11): ";
+        
+        if (!readNumber(choice) && inputEnded()) {
+            currentPassengerId = -1;
+            break;
+        }
+        
+        switch(choice) {
+            case 1:
+             viewAvailableFlights();
+            break;
+            case 2: 
+            viewFlightDetailsWithSeats();
+             break;
+            case 3: 
+            bookFlight();
+             break;
+            case 4:
+             displayPassengerBookings();
+              break;
+            case 5:
+             cancelBooking(); 
+             break;
+            case 6: 
+                if (currentPassengerId == -1) {
+                    cout << "You must login first!\n";
+                } else {
+                    int receiptId;
+                    cout << "Enter Booking ID for receipt: ";
+                    readNumber(receiptId);
+                    generateBookingReceipt(receiptId);
+                }
+                break;
+            case 7: generatePersonalReport(); break;
+            case 8: updateProfile(); break;
+            case 9: groupBookFlight(); break;
+            case 10: manageGroupBooking(); break;
+            case 11: 
+                cout << "Logged out successfully!\n";
+                loggedIn = false;
+                currentPassengerId = -1;
+                break;
+            default:
+                cout << "Invalid choice! Please try again.\n";
+        }
+    }
+}
+
+void passengerLogin() {
+    cout << "\n=== PASSENGER LOGIN ===\n";
+    
+    int id;
+    char password[30];
+    
+    cout << "Enter Passenger ID: ";
+    readNumber(id);
+    
+    cout << "Enter Password: ";
+    readLine(password, 30);
+    
+    for (int i = 0; i < passengerCount; i++) {
+        if (passengers[i].id == id && strcmp(passengers[i].password, password) == 0) {
+            currentPassengerId = id;
+            auditActor = id;
+            cout << "\nLogin successful! Welcome " << passengers[i].name << "!\n";
+            showPassengerMenu();
+            auditActor = AUDIT_ACTOR_SYSTEM;
+            return;
+        }
+    }
+    
+    cout << "Invalid credentials! Please try again.\n";
+}
+
+void PassengerRegistration() {
+    if (passengerCount >= MAX_PASSENGERS) {
+        cout << "Maximum passenger limit reached!\n";
+        return;
+    }
+
+    Passenger newPassenger = {};
+    
+    cout << "\n=== PASSENGER REGISTRATION ===\n";
+    
+    newPassenger.id = 1000 + passengerCount + 1;
+    cout << "Your Passenger ID: " << newPassenger.id << " (Remember this for login)\n";
+    
+    cout << "Enter your name: ";
+    readLine(newPassenger.name, 50);
+    
+    cout << "Enter your Password: ";
+    readLine(newPassenger.password, 30);
+    
+    char email[50];
+    while (true) {
+        cout << "Enter E-mail: ";
+        if (!readLine(email, 50)) return;
+        if (isValidEmail(email)) {
+            strcpy(newPassenger.email, email);
+            break;
+        } else {
+            cout << "Invalid email format! Please enter a valid email (e.g., user@domain.com)\n";
+        }
+    }
+    
+    cout << "Enter Phone Number: ";
+    readLine(newPassenger.phone, 15);
+    
+    // The store assigns the ID under storeMutex; it only differs from the one
+    // shown above if someone else registered in the meantime
+    newPassenger.id = addPassengerRecord(newPassenger.name, newPassenger.password,
+                                         newPassenger.email, newPassenger.phone);
+    if (newPassenger.id == -1) {
+        cout << "Maximum passenger limit reached!\n";
         return;
     }
-   
-    Booking newBooking;
-    newBooking.bookingId = generateBookingId();
-    newBooking.passengerId = currentPassengerId;
-    newBooking.flightNo = flightChoice;
     
-    // Set booking date to current date
-    time_t now = time(0);
-    tm* currentTime = localtime(&now);
-    newBooking.bookingDate.day = currentTime->tm_mday;
-    newBooking.bookingDate.month = currentTime->tm_mon + 1;
-    newBooking.bookingDate.year = currentTime->tm_year + 1900;
+    cout << "\nRegistration successful!\n";
+    cout << "\n=== REGISTRATION DETAILS ===\n";
+    cout << "Passenger ID: " << newPassenger.id << "\n";
+    cout << "Name: " << newPassenger.name << "\n";
+    cout << "Email: " << newPassenger.email << "\n";
+    cout << "Phone: " << newPassenger.phone << "\n";
+    cout << "\nIMPORTANT: Save your Passenger ID for login: " << newPassenger.id << "\n";
+}
+
+// ========== METRICS REPORTING FUNCTIONS ==========
+
+atomic<bool> metricsServerRunning(false);
+int metricsServerSocket = -1;
+thread metricsServerThread;
+
+// Sums every thread's metrics into Prometheus-style plain text
+string renderMetrics() {
+    unsigned long long counters[COUNTER_COUNT] = {};
+    unsigned long long totalNs[TIMED_METRIC_COUNT] = {};
+    vector<unsigned long long> buckets(TIMED_METRIC_COUNT * HISTOGRAM_BUCKETS, 0);
+    {
+        lock_guard<mutex> lock(metricsRegistryMutex);
+        auto sum = [&](const ThreadMetrics& local) {
+            for (int c = 0; c < COUNTER_COUNT; c++) {
+                counters[c] += local.counters[c].load(memory_order_relaxed);
+            }
+            for (int m = 0; m < TIMED_METRIC_COUNT; m++) {
+                totalNs[m] += local.totalNs[m].load(memory_order_relaxed);
+                for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+                    buckets[m * HISTOGRAM_BUCKETS + b] += local.buckets[m][b].load(memory_order_relaxed);
+                }
+            }
+        };
+        sum(retiredMetrics);
+        for (auto& local : metricsRegistry) sum(*local);
+    }
+    
+    ostringstream out;
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    out << "# TYPE airline_operation_latency_ns summary\n";
+    for (int m = 0; m < TIMED_METRIC_COUNT; m++) {
+        unsigned long long count = 0;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) count += buckets[m * HISTOGRAM_BUCKETS + b];
+        for (double q : quantiles) {
+            unsigned long long rank = (unsigned long long)(q * count);
+            unsigned long long seen = 0;
+            unsigned long long value = 0;
+            for (int b = 0; b < HISTOGRAM_BUCKETS && count > 0; b++) {
+                seen += buckets[m * HISTOGRAM_BUCKETS + b];
+                if (seen > rank) {
+                    value = histogramBucketFloor(b);
+                    break;
+                }
+            }
+            out << "airline_operation_latency_ns{op=\"" << METRIC_NAMES[m] << "\",quantile=\""
+                << q << "\"} " << value << "\n";
+        }
+        out << "airline_operation_latency_ns_sum{op=\"" << METRIC_NAMES[m] << "\"} " << totalNs[m] << "\n";
+        out << "airline_operation_latency_ns_count{op=\"" << METRIC_NAMES[m] << "\"} " << count << "\n";
+    }
     
-    newBooking.travelDate = travelDate;
-    newBooking.seatsBooked = seats;
-    strcpy(newBooking.classType, classType.c_str());
-    newBooking.farePaid = fare;
-    strcpy(newBooking.status, "Confirmed");
+    out << "# TYPE airline_events_total counter\n";
+    for (int c = 0; c < COUNTER_COUNT; c++) {
+        out << "airline_events_total{event=\"" << COUNTER_NAMES[c] << "\"} " << counters[c] << "\n";
+    }
     
+    out << "# TYPE airline_store_size gauge\n";
+    out << "airline_store_size{table=\"flights\"} " << liveFlightCount << "\n";
+    out << "airline_store_size{table=\"flight_slots\"} " << flightCount << "\n";
+    out << "airline_store_size{table=\"bookings\"} " << liveBookingCount << "\n";
+    out << "airline_store_size{table=\"booking_slots\"} " << bookingCount << "\n";
+    out << "airline_store_size{table=\"passengers\"} " << passengerCount << "\n";
+    return out.str();
+}
 
-    if (bookingCount < MAX_BOOKINGS) {
-        bookings[bookingCount] = newBooking;
-        bookingCount++;
-    } else {
-        cout << "Error: Maximum bookings limit reached!\n";
-        return;
+void viewMetrics() {
+    cout << "\n=== SYSTEM METRICS ===\n";
+    cout << renderMetrics();
+}
+
+// Called after accept() fails. A failure of the one connection (aborted,
+// interrupted) retries at once; running out of descriptors or memory waits,
+// doubling from 10 ms up to a second, so the loop does not spin until it
+// clears. The caller resets delayMs to 0 after a successful accept.
+void backOffAfterAcceptError(int& delayMs) {
+    if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO) return;
+    delayMs = delayMs ? min(delayMs * 2, 1000) : 10;
+    this_thread::sleep_for(chrono::milliseconds(delayMs));
+}
+
+// Serves renderMetrics() over plain HTTP on 127.0.0.1 for scrapers
+bool startMetricsServer(int port) {
+    metricsServerSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (metricsServerSocket < 0) return false;
+    
+    int reuse = 1;
+    setsockopt(metricsServerSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(metricsServerSocket, (sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(metricsServerSocket, 16) < 0) {
+        close(metricsServerSocket);
+        metricsServerSocket = -1;
+        return false;
     }
     
- 
-    if (flightIndex >= 0 && flightIndex < flightCount) {
-        // Reduce seats 
-        if (classType == "Economy") {
-            flights[flightIndex].economySeats -= seats;
-        } else if (classType == "Business") {
-            flights[flightIndex].businessSeats -= seats;
-        } else if (classType == "First") {
-            flights[flightIndex].firstClassSeats -= seats;
+    metricsServerRunning = true;
+    metricsServerThread = thread([] {
+        int acceptDelayMs = 0;
+        while (metricsServerRunning) {
+            int client = accept(metricsServerSocket, nullptr, nullptr);
+            if (client < 0) {
+                if (metricsServerRunning) backOffAfterAcceptError(acceptDelayMs);
+                continue;
+            }
+            acceptDelayMs = 0;
+            char request[1024];
+            if (recv(client, request, sizeof(request), 0) > 0) {
+                string body = renderMetrics();
+                string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: " + to_string(body.size()) + "\r\n\r\n" + body;
+                send(client, response.data(), response.size(), MSG_NOSIGNAL);
+            }
+            close(client);
         }
+    });
+    return true;
+}
+
+void stopMetricsServer() {
+    if (!metricsServerRunning) return;
+    metricsServerRunning = false;
+    shutdown(metricsServerSocket, SHUT_RDWR);
+    close(metricsServerSocket);
+    if (metricsServerThread.joinable()) metricsServerThread.join();
+}
+
+// ========== MAIN MENU ==========
+
+void mainMenu() {
+    int choice;
+    
+    do {
+        cout << "\n=== AIRLINE RESERVATION SYSTEM ===\n";
+        cout << "1. Passenger Registration\n";
+        cout << "2. Passenger Login\n";
+        cout << "3. Admin Login\n";
+        cout << "4. Exit System\n";
+        cout << "\nEnter your choice (1-4): ";
         
-        // Update total available seats
-        flights[flightIndex].availableSeats -= seats;
-        
-        // Update revenue and booking count
-        flights[flightIndex].timesBooked++;
-        flights[flightIndex].totalRevenue += fare;
+        readNumber(choice);
         
-        // Update flight status if fully booked
-        if (flights[flightIndex].availableSeats == 0) {
-            strcpy(flights[flightIndex].status, "Full");
+        switch(choice) {
+            case 1: PassengerRegistration(); break;
+            case 2: passengerLogin(); break;
+            case 3: adminLoginPanel(); break;
+            case 4: cout << "Thank you for using the system!\n"; break;
+            default: cout << "Invalid choice! Please try again.\n";
         }
+    } while(choice != 4 && !inputEnded());
+}
+
+// ========== BENCHMARK FUNCTIONS ==========
+
+// Swallows console output so the views can be timed without a terminal
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+NullBuffer nullBuffer;
+
+// Prints one JSON line with throughput and latency percentiles for a set of timed operations
+void printLatencySummary(const char* kind, const char* name, long long scale,
+                         vector<long long>& latencies, double seconds) {
+    long long ops = latencies.size();
+    long long p50 = 0;
+    long long p99 = 0;
+    if (ops > 0) {
+        nth_element(latencies.begin(), latencies.begin() + ops / 2, latencies.end());
+        p50 = latencies[ops / 2];
+        nth_element(latencies.begin(), latencies.begin() + ops * 99 / 100, latencies.end());
+        p99 = latencies[ops * 99 / 100];
     }
+    long long worst = ops > 0 ? *max_element(latencies.begin(), latencies.end()) : 0;
     
-    // UPDATE PASSENGER INFORMATION
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            passengers[i].totalBookings++;
-            passengers[i].totalSpent += fare;
-            break;
-        }
+    cout << "{\"" << kind << "\":\"" << name << "\",\"scale\":" << scale << ",\"ops\":" << ops
+         << ",\"seconds\":" << fixed << setprecision(6) << seconds
+         << ",\"ops_per_sec\":" << setprecision(1) << (seconds > 0 ? ops / seconds : 0)
+         << ",\"p50_ns\":" << p50 << ",\"p99_ns\":" << p99 << ",\"max_ns\":" << worst << "}" << endl;
+}
+
+// Times every call of op and prints one JSON line with throughput and latency percentiles
+template <typename Operation>
+void runBenchmark(const char* name, int scale, long long ops, Operation op) {
+    vector<long long> latencies(ops);
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < ops; i++) {
+        auto begin = chrono::steady_clock::now();
+        op(i);
+        latencies[i] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
     }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
     
-    // Show confirmation and generate receipt
-    cout << "\n Booking confirmed! Booking ID: " << newBooking.bookingId << "\n";
-    cout << " Generating receipt...\n\n";
-    
+    cout.rdbuf(console);
+    printLatencySummary("bench", name, scale, latencies, seconds);
+}
+
+// Fills the stores with a synthetic schedule and passengers. The number of
+// flights and passengers follows the number of bookings to be generated.
+const char* SYNTHETIC_CITIES[] = {"Lahore", "Karachi", "Islamabad", "Dubai", "London", "Jeddah",
+                                  "Istanbul", "Doha", "Toronto", "Manchester", "Riyadh", "Peshawar"};
+const int SYNTHETIC_CITY_COUNT = sizeof(SYNTHETIC_CITIES) / sizeof(SYNTHETIC_CITIES[0]);
 
-    generateBookingReceipt(newBooking.bookingId);
+void generateSyntheticSchedule(int scale, mt19937& rng) {
+    const char** cities = SYNTHETIC_CITIES;
+    const int cityCount = SYNTHETIC_CITY_COUNT;
+    int flightTotal = min(max(scale / 100, 10), MAX_FLIGHTS);
+    int passengerTotal = min(max(scale / 10, 10), MAX_PASSENGERS);
+    int seatsPerFlight = max(scale * 2 / flightTotal, 10);
+    int today = todayDayNumber();
+    
+    for (int f = 0; f < flightTotal; f++) {
+        Flight flight = Flight();
+        flight.flightNo = 100 + f;
+        int from = rng() % cityCount;
+        int to = (from + 1 + rng() % (cityCount - 1)) % cityCount;
+        flight.origin = internCity(cities[from]);
+        flight.destination = internCity(cities[to]);
+        flight.departureDate = civilFromDays(today + 1 + rng() % 365);
+        flight.departureTime = {(int)(rng() % 24), (int)(rng() % 60)};
+        flight.arrivalDate = flight.departureDate;
+        flight.arrivalTime = {(flight.departureTime.hour + 2) % 24, flight.departureTime.minute};
+        // Economy takes 70% of the seats and the premium cabins share the rest
+        float economyFare = 10 + rng() % 20;
+        int premiumSeats = seatsPerFlight * 3 / 10;
+        for (int c = 0; c < CABIN_COUNT; c++) {
+            flight.classSeats[c] = c == CABIN_ECONOMY ? 0 : premiumSeats / (CABIN_COUNT - 1);
+            flight.classFares[c] = economyFare * CABIN_CLASSES[c].fareMultiplier;
+        }
+        seatsIn<CABIN_ECONOMY>(flight) = seatsPerFlight - cabinSeatTotal(flight);
+        flight.totalSeats = seatsPerFlight;
+        flight.availableSeats = seatsPerFlight;
+        flight.distance = 300 + rng() % 6000;
+        flight.baseFare = economyFare;
+        addFlightRecord(flight);
+    }
     
-    cout << "\n IMPORTANT: Save your Booking ID: " << newBooking.bookingId << "\n";
-    cout << "You can view this receipt anytime from 'View Booking Receipt' in menu.\n";
+    for (int p = 0; p < passengerTotal; p++) {
+        int id = 1000 + passengerCount + 1;
+        string name = "Passenger " + to_string(id);
+        string email = "p" + to_string(id) + "@example.com";
+        addPassengerRecord(name.c_str(), "password", email.c_str(), "03000000000");
+    }
 }
 
-void viewFlightDetailsWithSeats() {
-    cout << "\n=== FLIGHT DETAILS WITH SEAT AVAILABILITY ===\n";
-    
-    if (flightCount == 0) {
-        cout << "No flights available.\n";
-        return;
+// Counts hardware cache misses of the calling thread. Reads -1 when the
+// kernel does not allow it (no PMU in a VM, perf_event_paranoid).
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
     }
-    
-    int flightNo;
-    cout << "Enter Flight Number to view details (0 to cancel): ";
-    cin >> flightNo;
-    
-    if (flightNo == 0) return;
-    
-    Flight* flight = nullptr;
-    int flightIndex = -1;
-    
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].flightNo == flightNo) {
-            flight = &flights[i];
-            flightIndex = i;
-            break;
-        }
+    ~CacheMissCounter() {
+        if (fd != -1) close(fd);
     }
-    
-    if (!flight) {
-        cout << "Flight not found!\n";
-        return;
+    void start() {
+        if (fd == -1) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
     }
-    
-    cout << "\n========================================\n";
-    cout << "     FLIGHT DETAILS: " << flight->flightNo << "\n";
-    cout << "========================================\n";
-    
-    cout << "\nRoute: " << flight->origin << " to " << flight->destination << "\n";
-    cout << "Distance: " << flight->distance << " km\n";
-    cout << "Base Fare: $" << flight->baseFare << " per 100 km\n";
-    
-    cout << "\n--- Departure ---\n";
-    cout << "Date: " << formatDate(flight->departureDate) << "\n";
-    cout << "Time: " << formatTime(flight->departureTime) << "\n";
-    
-    cout << "\n--- Arrival ---\n";
-    cout << "Date: " << formatDate(flight->arrivalDate) << "\n";
-    cout << "Time: " << formatTime(flight->arrivalTime) << "\n";
-    
-    cout << "\n--- SEAT AVAILABILITY ---\n";
-    cout << left << setw(15) << "CLASS" 
-         << setw(10) << "SEATS" 
-         << setw(15) << "AVAILABLE" 
-         << setw(15) << "FARE PER SEAT" << "\n";
-    cout << string(55, '-') << "\n";
-    
-    // Calculate fares per seat based on distance
-    float distanceFare = flight->distance * (flight->baseFare / 100);
-    
-    cout << left 
-         << setw(15) << "Economy"
-         << setw(10) << flight->economySeats
-         << setw(15) << flight->economySeats
-         << setw(15) << "$" + to_string(distanceFare * 1.0) << "\n";
-    
-    cout << left 
-         << setw(15) << "Business"
-         << setw(10) << flight->businessSeats
-         << setw(15) << flight->businessSeats
-         << setw(15) << "$" + to_string(distanceFare * 2.0) << "\n";
-    
-    cout << left 
-         << setw(15) << "First Class"
-         << setw(10) << flight->firstClassSeats
-         << setw(15) << flight->firstClassSeats
-         << setw(15) << "$" + to_string(distanceFare * 3.5) << "\n";
-    
-    cout << "\nTotal Seats: " << flight->totalSeats << "\n";
-    cout << "Status: " << flight->status << "\n";
-    cout << "========================================\n";
+    long long stop() {
+        if (fd == -1) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count;
+        return read(fd, &count, sizeof(count)) == sizeof(count) ? count : -1;
+    }
+private:
+    int fd;
+};
+
+// The flight and booking records as they were before the compact layout:
+// route text inline with the seat counters, unpacked dates, float money and
+// every booking field in the record the scans walk.
+struct WideFlight {
+    int flightNo;
+    char destination[50];
+    char origin[50];
+    Date departureDate;
+    Time departureTime;
+    Date arrivalDate;
+    Time arrivalTime;
+    int classSeats[CABIN_COUNT];
+    float classFares[CABIN_COUNT];
+    int totalSeats;
+    int availableSeats;
+    float distance;
+    FlightStatus status;
+    int timesBooked;
+    float totalRevenue;
+    double baseFare;
+    bool deleted;
+    int firstBooking;
+};
+
+struct WideBooking {
+    int bookingId;
+    int passengerId;
+    int flightNo;
+    Date bookingDate;
+    Date travelDate;
+    int seatsBooked;
+    unsigned char cabin;
+    float farePaid;
+    BookingStatus status;
+    int nextOnFlight;
+    int nextInPartition;
+    bool archived;
+    int groupId;
+    int milesEarned;
+};
+
+// Dates of the generated bookings in both encodings, so the timed loop
+// measures the records rather than calendar arithmetic
+struct LayoutDates {
+    Date bookingDate;
+    Date travelDate;
+    PackedDate packedBookingDate;
+    PackedDate packedTravelDate;
+};
+
+void fillLayoutBooking(WideBooking& booking, int id, int passengerId, int flightNo, const LayoutDates& dates, float fare) {
+    booking = WideBooking();
+    booking.bookingId = id;
+    booking.passengerId = passengerId;
+    booking.flightNo = flightNo;
+    booking.bookingDate = dates.bookingDate;
+    booking.travelDate = dates.travelDate;
+    booking.seatsBooked = 1;
+    booking.farePaid = fare;
+    booking.nextOnFlight = -1;
 }
 
-void displayPassengerBookings() {
-    cout << "\n===== YOUR BOOKINGS =====\n";
-    
-    bool found = false;
-    
-    cout << left << setw(12) << "Booking ID"
-         << setw(10) << "Flight #"
-         << setw(15) << "Travel Date"
-         << setw(10) << "Seats"
-         << setw(12) << "Class"
-         << setw(12) << "Fare Paid($)"
-         << setw(12) << "Status" << "\n";
+void fillLayoutBooking(Booking& booking, int id, int passengerId, int flightNo, const LayoutDates& dates, float fare) {
+    booking = Booking();
+    booking.bookingId = id;
+    booking.passengerId = passengerId;
+    booking.flightNo = flightNo;
+    booking.bookingDate = dates.packedBookingDate;
+    booking.travelDate = dates.packedTravelDate;
+    booking.seatsBooked = 1;
+    booking.fareCents = toCents(fare);
+    booking.nextOnFlight = -1;
+}
+
+float layoutFarePaid(const WideBooking& booking) {
+    return booking.farePaid;
+}
+
+float layoutFarePaid(const Booking& booking) {
+    return fromCents(booking.fareCents);
+}
+
+// Runs the lookup, booking and listing-scan access patterns over one record
+// layout, away from the live stores, and prints one JSON line per pattern
+template <typename FlightRecord, typename BookingRecord>
+void runLayoutBenchmark(const char* layout, long long records, unsigned seed) {
+    mt19937 rng(seed);
+    long long flightTotal = max(records / 8, 1LL);
+    long long passengerTotal = max(records / 16, 1LL);
+    vector<FlightRecord> flightRecords(flightTotal);
+    vector<BookingRecord> bookingRecords(records);
+    LayoutDates dates;
+    dates.bookingDate = civilFromDays(todayDayNumber());
+    dates.travelDate = civilFromDays(todayDayNumber() + 30);
+    dates.packedBookingDate = packDate(dates.bookingDate);
+    dates.packedTravelDate = packDate(dates.travelDate);
+    for (long long f = 0; f < flightTotal; f++) {
+        FlightRecord& flight = flightRecords[f];
+        flight.flightNo = 100 + f;
+        flight.status = FLIGHT_SCHEDULED;
+        flight.deleted = false;
+        for (int c = 0; c < CABIN_COUNT; c++) {
+            flight.classSeats[c] = 1 << 20;
+            flight.classFares[c] = 10 * CABIN_CLASSES[c].fareMultiplier;
+        }
+        flight.availableSeats = CABIN_COUNT << 20;
+        flight.baseFare = 10;
+        flight.distance = 1000;
+        flight.firstBooking = -1;
+    }
     
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].passengerId == currentPassengerId) {
-            found = true;
-            string travelDateStr = to_string(bookings[i].travelDate.day) + "/" +
-                                  to_string(bookings[i].travelDate.month) + "/" +
-                                  to_string(bookings[i].travelDate.year);
-            
-            cout << left << setw(12) << bookings[i].bookingId
-                 << setw(10) << bookings[i].flightNo
-                 << setw(15) << travelDateStr
-                 << setw(10) << bookings[i].seatsBooked
-                 << setw(12) << bookings[i].classType
-                 << setw(12) << fixed << setprecision(2) << bookings[i].farePaid
-                 << setw(12) << bookings[i].status << "\n";
+    CacheMissCounter misses;
+    auto report = [&](const char* pattern, long long ops, double seconds, long long missCount) {
+        cout << "{\"layout\":\"" << layout << "\",\"pattern\":\"" << pattern << "\",\"records\":" << records
+             << ",\"flight_bytes\":" << sizeof(FlightRecord) << ",\"booking_bytes\":" << sizeof(BookingRecord)
+             << ",\"ops\":" << ops << ",\"ns_per_op\":" << fixed << setprecision(1) << seconds * 1e9 / ops
+             << ",\"cache_misses\":" << missCount << ",\"misses_per_op\":" << setprecision(3)
+             << (missCount < 0 ? -1.0 : (double)missCount / ops) << "}" << endl;
+    };
+    
+    // Booking: check the cabin and take a seat on a random flight, then
+    // store the booking in the next slot
+    misses.start();
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < records; i++) {
+        FlightRecord& flight = flightRecords[rng() % flightTotal];
+        int cabin = i % CABIN_COUNT;
+        if (flight.deleted || flight.classSeats[cabin] < 1) continue;
+        flight.classSeats[cabin]--;
+        flight.availableSeats--;
+        fillLayoutBooking(bookingRecords[i], 1001 + i, 1001 + rng() % passengerTotal, flight.flightNo, dates,
+                          flight.classFares[cabin] * flight.distance / 100);
+        bookingRecords[i].nextOnFlight = flight.firstBooking;
+        flight.firstBooking = i;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report("book", records, seconds, misses.stop());
+    
+    // Lookup: read the state and free seats of random flights
+    long long lookups = max(records, 1000000LL);
+    long long open = 0;
+    misses.start();
+    start = chrono::steady_clock::now();
+    for (long long i = 0; i < lookups; i++) {
+        const FlightRecord& flight = flightRecords[rng() % flightTotal];
+        if (!flight.deleted && flight.status == FLIGHT_SCHEDULED && flight.availableSeats > 0) open++;
+    }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report("lookup", lookups, seconds, misses.stop());
+    
+    // Listing scan: a passenger's bookings and what they paid, the way
+    // displayPassengerBookings walks the store
+    long long scans = 10;
+    double paid = 0;
+    misses.start();
+    start = chrono::steady_clock::now();
+    for (long long s = 0; s < scans; s++) {
+        int passengerId = 1001 + rng() % passengerTotal;
+        for (const BookingRecord& booking : bookingRecords) {
+            if (!booking.archived && booking.passengerId == passengerId) paid += layoutFarePaid(booking);
         }
     }
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report("listing_scan", scans, seconds, misses.stop());
     
-    if (!found) {
-        cout << "No bookings found.\n";
+    if (open < 0 || paid < 0) cout << open << paid;
+}
+
+// Serves one search-quote-book-receipt request the way a booking server would,
+// rendering the receipt into the arena ready to send. Returns the receipt's
+// length, or 0 if nothing on the route could be booked.
+size_t serveBookingRequest(const char* origin, const char* destination, int passengerId, int today) {
+    RequestScope request;
+    int results[8];
+    int found = findBookableFlights(origin, destination, results, 8);
+    for (int r = 0; r < found; r++) {
+        Flight flight;
+        if (!snapshotFlight(results[r], flight)) continue;
+        int cabin = 0;
+        while (cabin < CABIN_COUNT && flight.classSeats[cabin] == 0) cabin++;
+        if (cabin == CABIN_COUNT) continue;
+        
+        Booking booking = {};
+        booking.bookingId = generateBookingId();
+        booking.passengerId = passengerId;
+        booking.flightNo = flight.flightNo;
+        booking.bookingDate = packDate(civilFromDays(today));
+        booking.travelDate = packDate(flight.departureDate);
+        booking.seatsBooked = 1;
+        booking.cabin = cabin;
+        booking.fareCents = toCents(calculateFare(flight, 1, cabin));
+        booking.status = BOOKING_CONFIRMED;
+        string error;
+        if (commitBooking(booking, error) == -1) continue;
+        
+        Passenger* passenger = findPassengerById(passengerId);
+        ArenaStream receipt(RECEIPT_SIZE_HINT);
+        receipt << fixed << setprecision(2);
+        renderReceipt(receipt, booking, flight, *passenger);
+        return receipt.str().size();
     }
+    return 0;
 }
 
-void cancelBooking() {
-    if (currentPassengerId == -1) {
-        cout << "You must login first!\n";
+// Times booking requests on routes of the generated schedule and, in builds
+// with AIRLINE_COUNT_ALLOCATIONS, counts the heap allocations each makes on
+// the requesting thread. The first requests warm the arena and the event node
+// pool and are not counted. Store events are drained between requests so the
+// pool is back in use; the drain is the consumer's share of the previous
+// booking (totals, receipt, audit record) and is timed on its own.
+void runBookingRequestBenchmark(int scale, long long ops, mt19937& rng) {
+    long long freeSlots = freeBookingSlotCount + (MAX_BOOKINGS - bookingCount);
+    long long warmup = min(100LL, freeSlots / 2);
+    long long requests = min(ops, freeSlots - warmup);
+    if (requests <= 0 || liveFlightCount == 0) {
+        cout << "{\"bench\":\"booking_request\",\"scale\":" << scale
+             << ",\"skipped\":\"no free booking slots; raise AIRLINE_MAX_BOOKINGS above the scale\"}\n";
         return;
     }
     
-    cout << "\n=== CANCEL BOOKING ===\n";
-    displayPassengerBookings();
-    
-    bool hasBookings = false;
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].passengerId == currentPassengerId && 
-            strcmp(bookings[i].status, "Confirmed") == 0) {
-            hasBookings = true;
-            break;
-        }
+    int today = todayDayNumber();
+    vector<long long> latencies(requests);
+    vector<long long> drainLatencies(requests);
+#ifdef AIRLINE_COUNT_ALLOCATIONS
+    unsigned long long requestAllocations = 0;
+#endif
+    long long booked = 0;
+    double seconds = 0;
+    double drainSeconds = 0;
+    for (long long i = -warmup; i < requests; i++) {
+        Flight route;
+        snapshotFlight(100 + rng() % liveFlightCount, route);
+        int passengerId = 1001 + rng() % passengerCount;
+        
+        auto drainBegin = chrono::steady_clock::now();
+        waitForStoreEvents();
+        auto begin = chrono::steady_clock::now();
+#ifdef AIRLINE_COUNT_ALLOCATIONS
+        unsigned long long started = heapAllocations;
+#endif
+        size_t receiptLength = serveBookingRequest(cityName(route.origin), cityName(route.destination), passengerId, today);
+        auto end = chrono::steady_clock::now();
+        if (i < 0) continue;
+        
+#ifdef AIRLINE_COUNT_ALLOCATIONS
+        requestAllocations += heapAllocations - started;
+#endif
+        latencies[i] = chrono::duration_cast<chrono::nanoseconds>(end - begin).count();
+        seconds += chrono::duration<double>(end - begin).count();
+        drainLatencies[i] = chrono::duration_cast<chrono::nanoseconds>(begin - drainBegin).count();
+        drainSeconds += chrono::duration<double>(begin - drainBegin).count();
+        if (receiptLength > 0) booked++;
     }
     
-    if (!hasBookings) {
-        cout << "\nYou have no active bookings to cancel.\n";
+    printLatencySummary("bench", "booking_request", scale, latencies, seconds);
+    printLatencySummary("bench", "booking_request_drain", scale, drainLatencies, drainSeconds);
+    cout << "{\"bench\":\"booking_request_allocations\",\"scale\":" << scale << ",\"requests\":" << requests
+         << ",\"booked\":" << booked;
+#ifdef AIRLINE_COUNT_ALLOCATIONS
+    cout << ",\"heap_allocations\":" << requestAllocations << "}\n";
+#else
+    cout << ",\"skipped\":\"rebuild with -DAIRLINE_COUNT_ALLOCATIONS to count heap allocations\"}\n";
+#endif
+}
+
+// Times bookings until the event consumer has handled them, first with the
+// audit log off and then with it written to a scratch file, so the cost of
+// chaining and flushing audit records shows up next to the booking it
+// follows. Each run takes half the free booking slots and books economy
+// seats on a flight of its own, since the earlier runs sell the schedule out.
+void runAuditedBookingBenchmark(int scale, long long ops, mt19937& rng) {
+    long long freeSlots = freeBookingSlotCount + (MAX_BOOKINGS - bookingCount);
+    long long perRun = min(ops, freeSlots / 2);
+    if (perRun <= 0 || passengerCount == 0) {
+        cout << "{\"bench\":\"book_audited\",\"scale\":" << scale
+             << ",\"skipped\":\"no free booking slots; raise AIRLINE_MAX_BOOKINGS above the scale\"}\n";
         return;
     }
     
-    int bookingId;
-    cout << "\nEnter Booking ID to cancel (0 to go back): ";
-    cin >> bookingId;
-    
-    if (bookingId == 0) return;
-    
-    int bookingIndex = -1;
-    Booking* bookingToCancel = findBookingById(bookingId, bookingIndex);
-    
-    if (!bookingToCancel) {
-        cout << "Invalid Booking ID or booking not found!\n";
+    const char* scratchLog = "bench_audit.log";
+    int today = todayDayNumber();
+    long long booked = 0;
+    Flight flight = Flight();
+    flight.origin = internCity(SYNTHETIC_CITIES[0]);
+    flight.destination = internCity(SYNTHETIC_CITIES[1]);
+    flight.departureDate = civilFromDays(today + 30);
+    flight.departureTime = {12, 0};
+    flight.arrivalDate = flight.departureDate;
+    flight.arrivalTime = {14, 0};
+    for (int c = 0; c < CABIN_COUNT; c++) flight.classFares[c] = 10 * CABIN_CLASSES[c].fareMultiplier;
+    seatsIn<CABIN_ECONOMY>(flight) = perRun;
+    flight.totalSeats = perRun;
+    flight.availableSeats = perRun;
+    flight.distance = 1000;
+    flight.baseFare = fareIn<CABIN_ECONOMY>(flight);
+    flight.flightNo = 100 + flightCount;
+    // Adds a fresh copy of the flight under an unused number, or returns false
+    auto addBenchFlight = [&]() {
+        while (lookupFlightSlot(flight.flightNo) != -1) flight.flightNo++;
+        if (addFlightRecord(flight) != -1) return true;
+        cout << "{\"bench\":\"book_audited\",\"scale\":" << scale
+             << ",\"skipped\":\"cannot add a flight; raise AIRLINE_MAX_FLIGHTS above the schedule\"}\n";
+        return false;
+    };
+    auto bookAndDrain = [&](long long) {
+        Booking booking = {};
+        booking.bookingId = generateBookingId();
+        booking.passengerId = 1001 + rng() % passengerCount;
+        booking.flightNo = flight.flightNo;
+        booking.bookingDate = packDate(civilFromDays(today));
+        booking.travelDate = packDate(flight.departureDate);
+        booking.seatsBooked = 1;
+        booking.cabin = CABIN_ECONOMY;
+        booking.fareCents = (100 + rng() % 900) * 100;
+        booking.status = BOOKING_CONFIRMED;
+        string error;
+        if (commitBooking(booking, error) != -1) booked++;
+        waitForStoreEvents();
+    };
+    
+    // The consumer only reads the path while handling events, so it can be
+    // switched once everything published so far has been handled
+    string configuredLog = auditLogPath;
+    waitForStoreEvents();
+    auditLogPath.clear();
+    if (!addBenchFlight()) {
+        auditLogPath = configuredLog;
         return;
     }
+    runBenchmark("book_drained", scale, perRun, bookAndDrain);
     
-    if (strcmp(bookingToCancel->status, "Cancelled") == 0) {
-        cout << "This booking is already cancelled.\n";
+    if (!addBenchFlight()) {
+        auditLogPath = configuredLog;
         return;
     }
-    
-    if (strcmp(bookingToCancel->status, "Completed") == 0) {
-        cout << "Cannot cancel a completed booking.\n";
-        return;
+    waitForStoreEvents();
+    remove(scratchLog);
+    auditLogPath = scratchLog;
+    long long drainedBooked = booked;
+    runBenchmark("book_audited", scale, perRun, bookAndDrain);
+    waitForStoreEvents();
+    unsigned long long auditRecords = auditSequence;
+    auditLogPath = configuredLog;
+    auditLog.close();
+    remove(scratchLog);
+    cout << "{\"bench\":\"book_audited_records\",\"scale\":" << scale << ",\"requests\":" << perRun
+         << ",\"booked_drained\":" << drainedBooked << ",\"booked_audited\":" << booked - drainedBooked
+         << ",\"audit_records\":" << auditRecords << "}\n";
+}
+
+// Usage: --bench [--scale N] [--ops N] [--seed N] [--layout N]
+// scale is the number of bookings to generate; ops overrides the iteration
+// count of the per-request benchmarks. layout is the number of bookings the
+// record layout comparison uses (0 skips it); it runs on its own arrays, so
+// it is not bounded by the store capacities.
+int runBenchmarks(int argc, char* argv[]) {
+    long long scale = 1000;
+    long long ops = 0;
+    long long layoutRecords = 1 << 20;
+    unsigned seed = 42;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--scale") == 0) scale = atoll(argv[i + 1]);
+        else if (strcmp(argv[i], "--ops") == 0) ops = atoll(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--layout") == 0) layoutRecords = atoll(argv[i + 1]);
+    }
+    if (scale < 1 || scale > MAX_BOOKINGS) {
+        cerr << "Scale must be between 1 and " << MAX_BOOKINGS
+             << "; rebuild with -DAIRLINE_MAX_BOOKINGS (and matching flight and passenger limits) to go higher.\n";
+        return 1;
+    }
+    if (ops <= 0) ops = min(scale, 1000000LL);
+    long long viewOps = max(1LL, min(50LL, 10000000 / scale));
+    
+    mt19937 rng(seed);
+    generateSyntheticSchedule(scale, rng);
+    int today = todayDayNumber();
+    
+    runBenchmark("book", scale, scale, [&](long long) {
+        Booking booking = {};
+        booking.bookingId = generateBookingId();
+        booking.passengerId = 1001 + rng() % passengerCount;
+        booking.flightNo = 100 + rng() % liveFlightCount;
+        booking.bookingDate = packDate(civilFromDays(today));
+        booking.travelDate = packDate(civilFromDays(today + 1 + rng() % 365));
+        booking.seatsBooked = 1 + rng() % 2;
+        booking.cabin = rng() % CABIN_COUNT;
+        booking.fareCents = (100 + rng() % 900) * 100;
+        booking.status = BOOKING_CONFIRMED;
+        string error;
+        commitBooking(booking, error);
+    });
+    
+    runBenchmark("find_flight", scale, ops, [&](long long) {
+        int index;
+        findFlightByNumber(100 + rng() % liveFlightCount, index);
+    });
+    
+    float fareSink = 0;
+    runBenchmark("quote_fare", scale, ops, [&](long long) {
+        fareSink += calculateFare(flights[rng() % flightCount], 1 + rng() % 3, rng() % CABIN_COUNT);
+    });
+    
+    runBenchmark("cancel_with_refund", scale, min(ops, (long long)bookingCount / 10 + 1), [&](long long) {
+        int index = rng() % bookingCount;
+        float refund = calculateRefundAmount(bookings[index]);
+        string error;
+        commitCancellation(index, bookings[index].bookingId, refund, error);
+    });
+    
+    runBenchmark("personal_report", scale, viewOps, [&](long long) {
+        currentPassengerId = 1001 + rng() % passengerCount;
+        generatePersonalReport();
+    });
+    
+    // The views page their output; these time the first page of each
+    runBenchmark("passenger_bookings", scale, viewOps, [&](long long) {
+        PassengerBookingsCursor cursor;
+        cursor.passengerId = passengers[rng() % passengerCount].id;
+        renderPassengerBookingsPage(cursor, cout);
+    });
+    
+    runBenchmark("view_available_flights", scale, viewOps, [&](long long) {
+        AvailabilityCursor cursor;
+        renderAvailableFlightsPage(cursor, cout);
+    });
+    
+    runBenchmark("view_flights", scale, viewOps, [&](long long) {
+        int cursor = 0;
+        renderFlightsPage(cursor, cout);
+    });
+    
+    runBenchmark("view_all_bookings", scale, viewOps, [&](long long) {
+        int cursor = 0;
+        renderAllBookingsPage(cursor, cout);
+    });
+    
+    ListingContext listingContext = makeListingContext();
+    runBenchmark("query_bookings_page", scale, viewOps, [&](long long) {
+        ListingQuery query;
+        query.filters.push_back({BOOKING_FIELD_FLIGHT, LISTING_EQ, (double)(100 + rng() % liveFlightCount)});
+        query.order.push_back({BOOKING_FIELD_FARE, true});
+        query.page = 0;
+        query.pageSize = LISTING_PAGE_SIZE;
+        vector<ListingRow<Booking>> page;
+        queryBookings(query, listingContext, page);
+    });
+    
+    runBenchmark("query_flights_page", scale, viewOps, [&](long long) {
+        ListingQuery query;
+        query.filters.push_back({FLIGHT_FIELD_DEPARTS_IN_HOURS, LISTING_GE, 0});
+        query.order.push_back({FLIGHT_FIELD_LOAD, true});
+        query.order.push_back({FLIGHT_FIELD_NUMBER, false});
+        query.page = 0;
+        query.pageSize = LISTING_PAGE_SIZE;
+        vector<ListingRow<Flight>> page;
+        queryFlights(query, listingContext, page);
+    });
+    
+    // Synthetic flights depart over the next year; a week's window holds about 2% of them
+    vector<int> departing(liveFlightCount);
+    long long benchNow = (long long)todayDayNumber() * 1440;
+    runBenchmark("departures_window", scale, ops, [&](long long) {
+        long long from = benchNow + rng() % (365 * 1440);
+        findDepartingFlights(from, from + 7 * 1440, departing.data(), departing.size());
+    });
+    
+    currentPassengerId = -1;
+    if (fareSink < 0) cout << fareSink;
+    
+    runBookingRequestBenchmark(scale, ops, rng);
+    runAuditedBookingBenchmark(scale, ops, rng);
+    
+    if (layoutRecords > 0) {
+        runLayoutBenchmark<WideFlight, WideBooking>("wide", layoutRecords, seed);
+        runLayoutBenchmark<Flight, Booking>("compact", layoutRecords, seed);
+    }
+    return 0;
+}
+
+// ========== LOAD GENERATION FUNCTIONS ==========
+
+enum LoadOperation { LOAD_SEARCH, LOAD_BOOK, LOAD_CANCEL, LOAD_DELETE_FLIGHT, LOAD_REPORT, LOAD_OPERATION_COUNT };
+const char* LOAD_OPERATION_NAMES[LOAD_OPERATION_COUNT] = {"search", "book", "cancel", "delete_flight", "report"};
+
+// Relative weights of each operation in a traffic mix
+struct LoadProfile {
+    const char* name;
+    int weights[LOAD_OPERATION_COUNT];
+    int hotFlightPercent;   // share of bookings aimed at the hottest tenth of the schedule
+    int maxBurst;           // consecutive bookings a passenger group makes on one flight
+};
+
+const LoadProfile LOAD_PROFILES[] = {
+    {"search",       {90,  8,  2, 0, 0}, 50,  1},
+    {"booking",      {15, 80,  5, 0, 0}, 80, 16},
+    {"cancellation", {20, 10, 69, 1, 0}, 50,  1},
+    {"mixed",        {55, 30,  9, 1, 5}, 70,  4},
+};
+const int LOAD_PROFILE_COUNT = sizeof(LOAD_PROFILES) / sizeof(LOAD_PROFILES[0]);
+
+atomic<long long> tornSnapshotReads(0);
+
+// Per-thread generator state. Every worker owns its own seeded generator so
+// the operation sequence of each worker is the same on every run.
+struct LoadWorker {
+    mt19937 rng;
+    int burstFlight = 0;
+    int burstLeft = 0;
+    vector<long long> latencies[LOAD_OPERATION_COUNT];
+};
+
+int pickLoadOperation(const LoadProfile& profile, mt19937& rng) {
+    int total = 0;
+    for (int i = 0; i < LOAD_OPERATION_COUNT; i++) total += profile.weights[i];
+    int roll = rng() % total;
+    for (int i = 0; i < LOAD_OPERATION_COUNT; i++) {
+        if (roll < profile.weights[i]) return i;
+        roll -= profile.weights[i];
+    }
+    return LOAD_SEARCH;
+}
+
+void runLoadOperation(int operation, const LoadProfile& profile, LoadWorker& worker, int flightTotal) {
+    mt19937& rng = worker.rng;
+    switch (operation) {
+        case LOAD_SEARCH: {
+            int results[32];
+            int from = rng() % SYNTHETIC_CITY_COUNT;
+            int to = (from + 1 + rng() % (SYNTHETIC_CITY_COUNT - 1)) % SYNTHETIC_CITY_COUNT;
+            findBookableFlights(SYNTHETIC_CITIES[from], SYNTHETIC_CITIES[to], results, 32);
+            break;
+        }
+        case LOAD_BOOK: {
+            if (worker.burstLeft == 0) {
+                int hotFlights = max(1, flightTotal / 10);
+                bool hot = (int)(rng() % 100) < profile.hotFlightPercent;
+                worker.burstFlight = 100 + (hot ? rng() % hotFlights : rng() % flightTotal);
+                worker.burstLeft = 1 + rng() % profile.maxBurst;
+            }
+            worker.burstLeft--;
+            
+            Flight flight;
+            if (!snapshotFlight(worker.burstFlight, flight)) {
+                worker.burstLeft = 0;
+                break;
+            }
+            Booking booking = {};
+            booking.bookingId = generateBookingId();
+            booking.passengerId = 1001 + rng() % passengerCount;
+            booking.flightNo = flight.flightNo;
+            booking.bookingDate = packDate(civilFromDays(todayDayNumber()));
+            booking.travelDate = packDate(flight.departureDate);
+            booking.seatsBooked = 1 + rng() % 3;
+            booking.cabin = rng() % CABIN_COUNT;
+            booking.fareCents = toCents(calculateFare(flight, booking.seatsBooked, booking.cabin));
+            booking.status = BOOKING_CONFIRMED;
+            string error;
+            if (commitBooking(booking, error) == -1) worker.burstLeft = 0;
+            break;
+        }
+        case LOAD_CANCEL: {
+            // The slot is read under storeMutex so the sweep cannot reuse it
+            // halfway; commitCancellation checks the booking ID again
+            int index, bookingId;
+            float refund;
+            {
+                lock_guard<mutex> lock(storeMutex);
+                if (bookingCount == 0) break;
+                index = rng() % bookingCount;
+                if (bookings[index].archived) break;
+                bookingId = bookings[index].bookingId;
+                refund = calculateRefundAmount(bookings[index]);
+            }
+            string error;
+            commitCancellation(index, bookingId, refund, error);
+            break;
+        }
+        case LOAD_DELETE_FLIGHT:
+            deleteFlightRecord(100 + rng() % flightTotal);
+            break;
+        case LOAD_REPORT: {
+            // Every committed state keeps the class counters in step with
+            // availableSeats, so a snapshot that disagrees saw a torn write
+            StoreSnapshot snapshot;
+            for (int i = 0; i < snapshot.flightSlots; i++) {
+                Flight flight;
+                snapshot.readFlight(i, flight);
+                if (!flight.deleted &&
+                    flight.availableSeats != cabinSeatTotal(flight)) {
+                    tornSnapshotReads++;
+                }
+            }
+            break;
+        }
+    }
+}
+
+// Checks that no flight sold more seats than it has: the remaining seats of
+// every flight must match its capacity minus the seats of its active bookings.
+int countOversoldFlights() {
+    int violations = 0;
+    for (int i = 0; i < flightCount; i++) {
+        const Flight& flight = flights[i];
+        if (flight.deleted) continue;
+        int sold = 0;
+        for (int b = flight.firstBooking; b != -1; b = bookings[b].nextOnFlight) {
+            if (occupiesSeats(bookings[b])) {
+                sold += bookings[b].seatsBooked;
+            }
+        }
+        bool negative = false;
+        int held = 0;
+        for (int c = 0; c < CABIN_COUNT; c++) {
+            negative = negative || flight.classSeats[c] < 0 || flightHeldSeats[i][c] < 0;
+            held += flightHeldSeats[i][c];
+        }
+        if (negative || flight.availableSeats != cabinSeatTotal(flight) ||
+            flight.availableSeats != flight.totalSeats - sold - held) {
+            cerr << "Flight #" << flight.flightNo << " oversold: " << sold << " seats sold, "
+                 << flight.availableSeats << " of " << flight.totalSeats << " left\n";
+            violations++;
+        }
+    }
+    return violations;
+}
+
+// Usage: --loadgen [--profile search|booking|cancellation|mixed] [--ops N]
+//                  [--threads N] [--seed N] [--scale N] [--trace FILE]
+// Drives the booking API with a seeded traffic mix and prints one JSON line of
+// latency percentiles per operation. With one thread a run is fully
+// reproducible; with more, each thread's sequence is fixed but the
+// interleaving is not, which is what exposes oversell races.
+int runLoadGenerator(int argc, char* argv[]) {
+    const LoadProfile* profile = &LOAD_PROFILES[3];
+    long long ops = 100000;
+    int threads = 1;
+    unsigned seed = 42;
+    long long scale = min(1000, MAX_BOOKINGS / 2);
+    const char* tracePath = nullptr;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--profile") == 0) {
+            profile = nullptr;
+            for (int p = 0; p < LOAD_PROFILE_COUNT; p++) {
+                if (strcmp(argv[i + 1], LOAD_PROFILES[p].name) == 0) profile = &LOAD_PROFILES[p];
+            }
+            if (!profile) {
+                cerr << "Unknown profile: " << argv[i + 1] << "\n";
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--ops") == 0) ops = atoll(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) threads = max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--seed") == 0) seed = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--scale") == 0) scale = atoll(argv[i + 1]);
+        else if (strcmp(argv[i], "--trace") == 0) tracePath = argv[i + 1];
+    }
+    if (scale < 1 || scale > MAX_BOOKINGS) {
+        cerr << "Scale must be between 1 and " << MAX_BOOKINGS << "\n";
+        return 1;
+    }
+    if (tracePath && !startTrace(tracePath, false)) {
+        cerr << "Cannot write trace to " << tracePath << "\n";
+        return 1;
     }
     
-    float refundAmount = calculateRefundAmount(*bookingToCancel);
+    mt19937 rng(seed);
+    generateSyntheticSchedule(scale, rng);
+    int flightTotal = liveFlightCount;
     
-    cout << "\n=== CANCELLATION DETAILS ===\n";
-    cout << "Booking ID: " << bookingToCancel->bookingId << "\n";
-    cout << "Flight Number: " << bookingToCancel->flightNo << "\n";
-    cout << "Travel Date: " << bookingToCancel->travelDate.day << "/" 
-         << bookingToCancel->travelDate.month << "/" 
-         << bookingToCancel->travelDate.year << "\n";
-    cout << "Seats: " << bookingToCancel->seatsBooked << "\n";
-    cout << "Class: " << bookingToCancel->classType << "\n";
-    cout << "Original Fare: $" << fixed << setprecision(2) << bookingToCancel->farePaid << "\n";
-    cout << "Refund Amount: $" << fixed << setprecision(2) << refundAmount << "\n";
+    streambuf* console = cout.rdbuf(&nullBuffer);
     
-    if (refundAmount == 0) {
-        cout << "Note: No refund as cancellation is too close to travel date.\n";
+    // Start from a schedule that is half sold so cancellations have work to do
+    LoadWorker seeder;
+    seeder.rng.seed(seed);
+    for (long long i = 0; i < scale / 2; i++) {
+        runLoadOperation(LOAD_BOOK, LOAD_PROFILES[0], seeder, flightTotal);
     }
     
-    char confirm;
-    cout << "\nAre you sure you want to cancel this booking? (Y/N): ";
-    cin >> confirm;
-    
-    if (confirm != 'Y' && confirm != 'y') {
-        cout << "Cancellation cancelled.\n";
-        return;
+    vector<LoadWorker> workers(threads);
+    vector<thread> pool;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers[t].rng.seed(seed + 1 + t);
+        long long share = ops / threads + (t < ops % threads ? 1 : 0);
+        pool.emplace_back([&, t, share]() {
+            LoadWorker& worker = workers[t];
+            for (long long i = 0; i < share; i++) {
+                int operation = pickLoadOperation(*profile, worker.rng);
+                auto begin = chrono::steady_clock::now();
+                runLoadOperation(operation, *profile, worker, flightTotal);
+                worker.latencies[operation].push_back(
+                    chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count());
+            }
+        });
     }
-    
-    int flightIndex = -1;
-    Flight* flight = findFlightByNumber(bookingToCancel->flightNo, flightIndex);
-    
-    if (flight) {
-        flight->availableSeats += bookingToCancel->seatsBooked;
-        if (strcmp(flight->status, "Full") == 0) {
-            strcpy(flight->status, "Available");
+    for (thread& worker : pool) worker.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    cout.rdbuf(console);
+    for (int operation = 0; operation < LOAD_OPERATION_COUNT; operation++) {
+        vector<long long> latencies;
+        for (LoadWorker& worker : workers) {
+            latencies.insert(latencies.end(), worker.latencies[operation].begin(), worker.latencies[operation].end());
+        }
+        if (!latencies.empty()) {
+            printLatencySummary("loadgen", LOAD_OPERATION_NAMES[operation], scale, latencies, seconds);
         }
-        flight->totalRevenue -= refundAmount;
-        flight->timesBooked--;
     }
     
-    strcpy(bookingToCancel->status, "Cancelled");
-    
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            passengers[i].totalSpent -= refundAmount;
-            passengers[i].totalBookings--;
+    int oversold = countOversoldFlights();
+    cout << "{\"check\":\"oversell\",\"profile\":\"" << profile->name << "\",\"threads\":" << threads
+         << ",\"flights\":" << liveFlightCount << ",\"violations\":" << oversold
+         << ",\"torn_snapshot_reads\":" << tornSnapshotReads << "}" << endl;
+    if (tracePath) {
+        tracing = false;
+        traceFile.close();
+    }
+    return oversold == 0 && tornSnapshotReads == 0 ? 0 : 2;
+}
+
+// Splits one trace line into its tab-separated fields
+vector<string> splitTraceLine(const string& line) {
+    vector<string> fields;
+    string field;
+    istringstream in(line);
+    while (getline(in, field, '\t')) fields.push_back(field);
+    return fields;
+}
+
+// Parses a whole line or field as one number, allowing surrounding blanks
+template <typename Number>
+bool parseNumberField(const string& line, Number& value) {
+    const char* begin = line.data();
+    const char* end = begin + line.size();
+    while (begin < end && isspace((unsigned char)*begin)) begin++;
+    while (end > begin && isspace((unsigned char)end[-1])) end--;
+    from_chars_result parsed = from_chars(begin, end, value);
+    return begin < end && parsed.ec == errc() && parsed.ptr == end;
+}
+
+// Applies one trace or journal record to the local stores. A replay gets new
+// booking IDs and maps the recorded ones through replayedBookings; journal
+// recovery and replicas keep the recorded IDs (keepIds). Returns false when
+// the record could not be applied the way it was when recorded.
+bool applyTraceRecord(const vector<string>& f, bool keepIds, map<int, pair<int, int>>& replayedBookings, string& error) {
+    bool ok = true;
+    switch (f[1][0]) {
+        case 'F': {
+            if (f.size() < 16 + 2 * CABIN_COUNT) { ok = false; break; }
+            Flight flight = Flight();
+            flight.flightNo = stoi(f[2]);
+            flight.origin = internCity(f[3].c_str());
+            flight.destination = internCity(f[4].c_str());
+            flight.departureDate = {stoi(f[5]), stoi(f[6]), stoi(f[7])};
+            flight.departureTime = {stoi(f[8]), stoi(f[9])};
+            flight.arrivalDate = {stoi(f[10]), stoi(f[11]), stoi(f[12])};
+            flight.arrivalTime = {stoi(f[13]), stoi(f[14])};
+            size_t idx = 15;
+            for (int c = 0; c < CABIN_COUNT; c++) flight.classSeats[c] = stoi(f[idx++]);
+            for (int c = 0; c < CABIN_COUNT; c++) flight.classFares[c] = stof(f[idx++]);
+            flight.distance = stof(f[idx]);
+            flight.totalSeats = cabinSeatTotal(flight);
+            flight.availableSeats = flight.totalSeats;
+            flight.baseFare = fareIn<CABIN_ECONOMY>(flight);
+            ok = addFlightRecord(flight) != -1;
             break;
         }
+        case 'P':
+            if (f.size() < 6) { ok = false; break; }
+            {
+                int id = addPassengerRecord(f[3].c_str(), "password", f[4].c_str(), f[5].c_str());
+                ok = id != -1 && (!keepIds || id == stoi(f[2]));
+            }
+            break;
+        case 'B': {
+            if (f.size() < 11) { ok = false; break; }
+            Booking booking = {};
+            booking.bookingId = keepIds ? stoi(f[2]) : generateBookingId();
+            if (keepIds) reserveBookingId(booking.bookingId);
+            booking.passengerId = stoi(f[3]);
+            booking.flightNo = stoi(f[4]);
+            booking.seatsBooked = stoi(f[5]);
+            booking.cabin = cabinCode(f[6].c_str());
+            if (booking.cabin == CABIN_NONE) { ok = false; break; }
+            booking.bookingDate = packDate(f.size() >= 14 ? Date{stoi(f[11]), stoi(f[12]), stoi(f[13])}
+                                                          : civilFromDays(todayDayNumber()));
+            booking.travelDate = packDate({stoi(f[7]), stoi(f[8]), stoi(f[9])});
+            booking.fareCents = toCents(stof(f[10]));
+            booking.status = BOOKING_CONFIRMED;
+            int index = commitBooking(booking, error);
+            ok = index != -1;
+            if (ok) replayedBookings[stoi(f[2])] = make_pair(index, booking.bookingId);
+            break;
+        }
+        case 'C': {
+            if (f.size() < 4) { ok = false; break; }
+            auto mapped = replayedBookings.find(stoi(f[2]));
+            ok = mapped != replayedBookings.end() &&
+                 commitCancellation(mapped->second.first, mapped->second.second, stof(f[3]), error);
+            break;
+        }
+        case 'D':
+            ok = f.size() >= 3 && deleteFlightRecord(stoi(f[2]));
+            break;
+        case 'T': {
+            FlightStatus status;
+            ok = f.size() >= 4 && parseFlightStatus(f[3], status) && setFlightStatus(stoi(f[2]), status, error);
+            break;
+        }
+        case 'U': {
+            if (f.size() < 16 + 2 * CABIN_COUNT) { ok = false; break; }
+            FlightUpdate update = {};
+            update.flightNo = stoi(f[2]);
+            update.fields = stoi(f[3]);
+            update.departureDate = {stoi(f[4]), stoi(f[5]), stoi(f[6])};
+            update.departureTime = {stoi(f[7]), stoi(f[8])};
+            update.arrivalDate = {stoi(f[9]), stoi(f[10]), stoi(f[11])};
+            update.arrivalTime = {stoi(f[12]), stoi(f[13])};
+            size_t idx = 14;
+            for (int c = 0; c < CABIN_COUNT; c++) update.classSeats[c] = stoi(f[idx++]);
+            for (int c = 0; c < CABIN_COUNT; c++) update.classFares[c] = stof(f[idx++]);
+            update.distance = stof(f[idx++]);
+            ok = parseFlightStatus(f[idx++], update.status);
+            if (f.size() >= idx + 2) {
+                strncpy(update.origin, f[idx].c_str(), sizeof(update.origin) - 1);
+                strncpy(update.destination, f[idx + 1].c_str(), sizeof(update.destination) - 1);
+            }
+            ok = ok && applyFlightUpdates(&update, 1, error);
+            break;
+        }
+        case 'S':
+            if (f.size() >= 4 && f[2] != "*") {
+                int results[32];
+                findBookableFlights(f[2].c_str(), f[3].c_str(), results, 32);
+            }
+            else {
+                MetricTimer timer(METRIC_SEARCH);
+                AvailabilityCursor cursor;
+                renderAvailableFlightsPage(cursor, cout);
+            }
+            break;
+    }
+    return ok;
+}
+
+// Usage: --replay FILE [--speed N]
+// Re-issues a recorded session against an empty store, keeping the recorded
+// spacing between requests divided by N (0 replays as fast as possible).
+// Booking IDs are reassigned on replay, so cancellations are mapped from the
+// recorded IDs to the new ones.
+int runReplay(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: --replay FILE [--speed N]\n";
+        return 1;
+    }
+    double speed = 1.0;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--speed") == 0) speed = atof(argv[i + 1]);
+    }
+    ifstream trace(argv[2]);
+    if (!trace) {
+        cerr << "Cannot read trace " << argv[2] << "\n";
+        return 1;
     }
     
-    cout << "\n=== CANCELLATION SUCCESSFUL ===\n";
-    cout << "Booking ID " << bookingToCancel->bookingId << " has been cancelled.\n";
+    const char* kinds = "FPBCDTSU";
+    const char* kindNames[] = {"add_flight", "register", "book", "cancel", "delete_flight", "flight_status",
+                               "search", "flight_update"};
+    vector<long long> latencies[8];
+    map<int, pair<int, int>> replayedBookings;   // recorded ID -> slot and new ID
+    long long records = 0;
+    long long diverged = 0;
+    long long maxLagMicros = 0;
+    
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    auto start = chrono::steady_clock::now();
+    string line;
+    while (getline(trace, line)) {
+        vector<string> f = splitTraceLine(line);
+        if (f.size() < 2 || f[1].size() != 1 || !strchr(kinds, f[1][0])) continue;
+        int kind = strchr(kinds, f[1][0]) - kinds;
+        
+        if (speed > 0) {
+            auto due = start + chrono::microseconds((long long)(atoll(f[0].c_str()) / speed));
+            this_thread::sleep_until(due);
+            long long lag = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - due).count();
+            maxLagMicros = max(maxLagMicros, lag);
+        }
+        
+        string error;
+        auto begin = chrono::steady_clock::now();
+        bool ok = applyTraceRecord(f, false, replayedBookings, error);
+        latencies[kind].push_back(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count());
+        records++;
+        if (!ok) diverged++;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
     
-    if (refundAmount > 0) {
-        cout << "Refund of $" << fixed << setprecision(2) << refundAmount 
-             << " will be processed to your account.\n";
+    cout.rdbuf(console);
+    for (int kind = 0; kind < 8; kind++) {
+        if (!latencies[kind].empty()) {
+            printLatencySummary("replay", kindNames[kind], records, latencies[kind], seconds);
+        }
     }
+    cout << "{\"replay\":\"summary\",\"records\":" << records << ",\"diverged\":" << diverged
+         << ",\"max_lag_us\":" << maxLagMicros << ",\"oversold_flights\":" << countOversoldFlights() << "}" << endl;
+    return 0;
 }
 
-// ========== REPORT FUNCTIONS ==========
+// ========== SHARDED DEPLOYMENT ==========
 
-int countBookingsByStatus(const char* status) {
-    int count = 0;
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].passengerId == currentPassengerId && 
-            strcmp(bookings[i].status, status) == 0) {
-            count++;
-        }
-    }
-    return count;
+// Flights are partitioned across worker processes by a hash of the flight
+// number. Each worker owns its flights and their bookings and keeps its own
+// journal (shard-K.journal, in the trace record format) which it replays on
+// start, and archives past months to its own shard-K.archive. Passengers are
+// registered on every shard, but miles accrue only on the shard that owns the
+// flight, so before a booking the router sums the passenger's rolling miles
+// from every shard and passes the total along; the fare is priced on that
+// tier. Booking IDs are strided by the shard count, so the shard holding a
+// booking follows from its ID.
+//
+// Workers speak a tab-separated line protocol on a Unix socket
+// (shard-K.sock). Every response is a status line, "OK" or "ERR message",
+// then any data lines, then a line holding a single ".".
+//   add-flight  F record fields (flightNo origin destination ... distance)
+//   register    name email phone
+//   book        passengerId flightNo seats class [miles]
+//   miles       passengerId   (rolling miles earned on this shard)
+//   cancel      passengerId bookingId
+//   delete      flightNo
+//   flight      flightNo
+//   available
+//   history     passengerId
+//   quit
+
+int shardForFlight(int flightNo, int shards) {
+    return (int)((((unsigned)flightNo * 2654435761u) >> 16) % (unsigned)shards);
 }
 
-float getTotalSpentOnBookings() {
-    float total = 0.0;
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].passengerId == currentPassengerId) {
-            total += bookings[i].farePaid;
-        }
+int shardForBooking(int bookingId, int shards) {
+    return bookingId > 1000 ? (bookingId - 1001) % shards : -1;
+}
+
+string shardSocketPath(const string& dir, int shard) {
+    return dir + "/shard-" + to_string(shard) + ".sock";
+}
+
+bool sendLine(int fd, const string& line) {
+    string data = line + '\n';
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += n;
     }
-    return total;
+    return true;
 }
 
-void displayPassengerInfo() {
-    cout << "\n=== PASSENGER INFORMATION ===\n";
-    
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            cout << "Passenger ID: " << passengers[i].id << "\n";
-            cout << "Name: " << passengers[i].name << "\n";
-            cout << "Email: " << passengers[i].email << "\n";
-            cout << "Phone: " << passengers[i].phone << "\n";
-            cout << "Total Bookings: " << passengers[i].totalBookings << "\n";
-            cout << "Total Spent: $" << fixed << setprecision(2) << passengers[i].totalSpent << "\n";
-            break;
-        }
+// Reads one line from fd; pending holds bytes received past the last line
+bool receiveLine(int fd, string& pending, string& line) {
+    size_t end;
+    while ((end = pending.find('\n')) == string::npos) {
+        char chunk[4096];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        pending.append(chunk, n);
     }
-    cout << "------------------------------\n";
+    line = pending.substr(0, end);
+    pending.erase(0, end + 1);
+    return true;
 }
 
-void displayBookingSummary() {
-    cout << "\n=== BOOKING SUMMARY ===\n";
-    
-    int confirmed = countBookingsByStatus("Confirmed");
-    int cancelled = countBookingsByStatus("Cancelled");
-    int totalBookings = confirmed + cancelled;
-    float totalSpent = getTotalSpentOnBookings();
-    
-    cout << "Total Bookings: " << totalBookings << "\n";
-    cout << "Active Bookings: " << confirmed << "\n";
-    cout << "Cancelled Bookings: " << cancelled << "\n";
-    cout << "Total Amount Spent: $" << fixed << setprecision(2) << totalSpent << "\n";
-    cout << "------------------------------\n";
+string describeShardBooking(const Booking& booking) {
+    ostringstream out;
+    out << fixed << setprecision(2) << booking.bookingId << '\t' << booking.flightNo
+        << '\t' << formatDate(unpackDate(booking.travelDate))
+        << '\t' << booking.seatsBooked << '\t' << cabinName(booking.cabin) << '\t' << fromCents(booking.fareCents)
+        << '\t' << BOOKING_STATUS_NAMES[booking.status];
+    return out.str();
 }
 
-void displayBookingHistory() {
-    cout << "\n=== BOOKING HISTORY ===\n";
-    
-    bool hasBookings = false;
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].passengerId == currentPassengerId) {
-            hasBookings = true;
-            break;
+string describeShardFlight(const Flight& flight) {
+    ostringstream out;
+    out << fixed << setprecision(2) << flight.flightNo << '\t' << cityName(flight.origin) << '\t' << cityName(flight.destination)
+        << '\t' << flight.departureDate.day << '/' << flight.departureDate.month << '/' << flight.departureDate.year
+        << '\t' << setfill('0') << setw(2) << flight.departureTime.hour << ':' << setw(2) << flight.departureTime.minute
+        << setfill(' ') << '\t' << flight.availableSeats << '\t' << flight.classFares[CABIN_ECONOMY]
+        << '\t' << FLIGHT_STATUS_NAMES[flight.status];
+    return out.str();
+}
+
+// Runs one protocol command against the local store and fills in the response lines
+string handleShardCommand(const vector<string>& f, vector<string>& rows) {
+    string error;
+    const string& command = f[0];
+    if (command == "add-flight") {
+        // applyTraceRecord trusts its fields, so every number is checked first
+        if (f.size() < 15 + 2 * CABIN_COUNT) return "ERR Cannot add flight";
+        for (size_t i = 1; i < f.size(); i++) {
+            if (i == 2 || i == 3) continue;   // origin and destination
+            int whole;
+            float decimal;
+            bool parsed = i < 14 + CABIN_COUNT ? parseNumberField(f[i], whole) : parseNumberField(f[i], decimal);
+            if (!parsed) return "ERR Invalid number";
         }
+        vector<string> record(2, "");
+        record[1] = "F";
+        record.insert(record.end(), f.begin() + 1, f.end());
+        map<int, pair<int, int>> unused;
+        return applyTraceRecord(record, true, unused, error) ? "OK" : "ERR Cannot add flight";
     }
-    
-    if (!hasBookings) {
-        cout << "No booking history found.\n";
-        return;
+    if (command == "register" && f.size() >= 4) {
+        int id = addPassengerRecord(f[1].c_str(), "password", f[2].c_str(), f[3].c_str());
+        if (id == -1) return "ERR Maximum passenger limit reached";
+        rows.push_back(to_string(id));
+        return "OK";
     }
-    
-    cout << left << setw(12) << "Booking ID" 
-         << setw(10) << "Flight #" 
-         << setw(12) << "Book Date" 
-         << setw(12) << "Travel Date" 
-         << setw(8) << "Seats" 
-         << setw(10) << "Class" 
-         << setw(10) << "Fare($)" 
-         << setw(12) << "Status" << "\n";
-    
-    for (int i = 0; i < bookingCount; i++) {
-        if (bookings[i].passengerId == currentPassengerId) {
-            string bookDate = formatDate(bookings[i].bookingDate);
-            string travelDate = formatDate(bookings[i].travelDate);
-            
-            cout << left << setw(12) << bookings[i].bookingId
-                 << setw(10) << bookings[i].flightNo
-                 << setw(12) << bookDate
-                 << setw(12) << travelDate
-                 << setw(8) << bookings[i].seatsBooked
-                 << setw(10) << bookings[i].classType
-                 << setw(10) << fixed << setprecision(2) << bookings[i].farePaid
-                 << setw(12) << bookings[i].status << "\n";
+    if (command == "book" && f.size() >= 5) {
+        Booking booking = {};
+        int seats;
+        if (!parseNumberField(f[1], booking.passengerId) || !parseNumberField(f[2], booking.flightNo) ||
+            !parseNumberField(f[3], seats)) {
+            return "ERR Invalid number";
+        }
+        booking.seatsBooked = seats;
+        booking.cabin = cabinCode(f[4].c_str());
+        int miles = -1;   // without the router's total, only this shard's miles count
+        if (f.size() >= 6 && !parseNumberField(f[5], miles)) return "ERR Invalid number";
+        Flight flight;
+        Passenger* passenger = findPassengerById(booking.passengerId);
+        if (!passenger) return "ERR Passenger not found";
+        if (!snapshotFlight(booking.flightNo, flight)) return "ERR Flight not found";
+        if (seats < 1 || seats > MAX_SEATS_PER_BOOKING || booking.cabin == CABIN_NONE) {
+            return "ERR Invalid seats or class";
         }
+        booking.bookingId = generateBookingId();
+        booking.bookingDate = packDate(civilFromDays(todayDayNumber()));
+        booking.travelDate = packDate(flight.departureDate);
+        int tier = tierForMiles(miles >= 0 ? miles : currentRollingMiles(*passenger));
+        booking.fareCents = toCents(applyTierDiscount(calculateFare(flight, booking.seatsBooked, booking.cabin), tier));
+        booking.status = BOOKING_CONFIRMED;
+        if (commitBooking(booking, error) == -1) return "ERR " + error;
+        rows.push_back(describeShardBooking(booking));
+        return "OK";
     }
-    cout << "------------------------------\n";
-}
-
-void displayRecentBookings() {
-    cout << "\n=== RECENT BOOKINGS ===\n";
-    
-    int count = 0;
-    for (int i = bookingCount - 1; i >= 0 && count < 3; i--) {
-        if (bookings[i].passengerId == currentPassengerId) {
-            count++;
-            string origin = "Unknown";
-            string destination = "Unknown";
-            
-            for (int j = 0; j < flightCount; j++) {
-                if (flights[j].flightNo == bookings[i].flightNo) {
-                    origin = flights[j].origin;
-                    destination = flights[j].destination;
-                    break;
-                }
-            }
-            
-            string travelDate = formatDate(bookings[i].travelDate);
-            
-            cout << count << ". Booking #" << bookings[i].bookingId << "\n";
-            cout << "   Flight: " << origin << " to " << destination << "\n";
-            cout << "   Travel Date: " << travelDate << "\n";
-            cout << "   Seats: " << bookings[i].seatsBooked << " (" << bookings[i].classType << ")\n";
-            cout << "   Fare: $" << fixed << setprecision(2) << bookings[i].farePaid << "\n";
-            cout << "   Status: " << bookings[i].status << "\n";
-            cout << "   ------------------------------\n";
+    if (command == "miles" && f.size() >= 2) {
+        int passengerId;
+        if (!parseNumberField(f[1], passengerId)) return "ERR Invalid number";
+        Passenger* passenger = findPassengerById(passengerId);
+        if (!passenger) return "ERR Passenger not found";
+        rows.push_back(to_string(currentRollingMiles(*passenger)));
+        return "OK";
+    }
+    if (command == "cancel" && f.size() >= 3) {
+        int passengerId, bookingId;
+        if (!parseNumberField(f[1], passengerId) || !parseNumberField(f[2], bookingId)) return "ERR Invalid number";
+        int slot;
+        float refund = 0;
+        {
+            lock_guard<mutex> lock(storeMutex);
+            slot = findPassengerBookingSlot(passengerId, bookingId);
+            if (slot != -1) refund = calculateRefundAmount(bookings[slot]);
         }
+        if (slot == -1) return "ERR Booking not found";
+        if (!commitCancellation(slot, bookingId, refund, error)) return "ERR " + error;
+        ostringstream out;
+        out << fixed << setprecision(2) << bookingId << '\t' << refund;
+        rows.push_back(out.str());
+        return "OK";
     }
-    
-    if (count == 0) {
-        cout << "No recent bookings found.\n";
+    if (command == "delete" && f.size() >= 2) {
+        int flightNo;
+        if (!parseNumberField(f[1], flightNo)) return "ERR Invalid number";
+        return deleteFlightRecord(flightNo) ? "OK" : "ERR Flight not found";
+    }
+    if (command == "flight" && f.size() >= 2) {
+        int flightNo;
+        if (!parseNumberField(f[1], flightNo)) return "ERR Invalid number";
+        Flight flight;
+        if (!snapshotFlight(flightNo, flight)) return "ERR Flight not found";
+        rows.push_back(describeShardFlight(flight));
+        return "OK";
+    }
+    if (command == "available") {
+        shared_ptr<const AvailabilityView> view = currentAvailability();
+        view->forEachFrom("", [&](const AvailabilityBucket& bucket) {
+            for (int flightNo : bucket.flightNos) {
+                Flight flight;
+                if (snapshotFlight(flightNo, flight)) rows.push_back(describeShardFlight(flight));
+            }
+            return true;
+        });
+        return "OK";
+    }
+    if (command == "history" && f.size() >= 2) {
+        int passengerId;
+        if (!parseNumberField(f[1], passengerId)) return "ERR Invalid number";
+        StoreSnapshot snapshot;
+        for (int i = 0; i < snapshot.bookingSlots; i++) {
+            Booking booking;
+            snapshot.readBooking(i, booking);
+            if (!booking.archived && booking.passengerId == passengerId) {
+                rows.push_back(describeShardBooking(booking));
+            }
+        }
+        return "OK";
     }
+    return "ERR Unknown command " + command;
 }
 
-void generatePersonalReport() {
-    if (currentPassengerId == -1) {
-        cout << "You must login first!\n";
-        return;
+// Usage: --shard-worker K N DIR
+// Serves shard K of N from DIR/shard-K.journal on DIR/shard-K.sock until a
+// quit command arrives.
+int runShardWorker(int shard, int shards, const string& dir) {
+    auditLogPath = dir + "/shard-" + to_string(shard) + ".audit";
+    bookingArchivePath = dir + "/shard-" + to_string(shard) + ".archive";
+    startStoreEvents();
+    bookingIdStride = shards;
+    lastBookingId = 1001 + shard - shards;
+    string journalPath = dir + "/shard-" + to_string(shard) + ".journal";
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    
+    ifstream journal(journalPath);
+    map<int, pair<int, int>> recovered;
+    long long records = 0;
+    string line;
+    while (getline(journal, line)) {
+        vector<string> f = splitTraceLine(line);
+        if (f.size() < 2 || f[1].size() != 1) continue;
+        string error;
+        records++;
+        if (!applyTraceRecord(f, true, recovered, error)) {
+            cerr << "shard " << shard << ": journal record " << records << " not applied: " << line << "\n";
+        }
+    }
+    journal.close();
+    traceSearches = false;
+    traceFlushEachRecord = true;
+    if (!startTrace(journalPath.c_str(), true)) {
+        cerr << "shard " << shard << ": cannot open journal " << journalPath << "\n";
+        cout.rdbuf(console);
+        return 1;
     }
     
-    cout << "\n========================================\n";
-    cout << "      PERSONAL BOOKING REPORT\n";
-    cout << "========================================\n";
-    
-    displayPassengerInfo();
-    displayBookingSummary();
-    displayBookingHistory();
-    displayRecentBookings();
-    
-    time_t now = time(0);
-    tm* currentTime = localtime(&now);
-    cout << "\nReport Generated: " 
-         << formatDate({currentTime->tm_mday, currentTime->tm_mon + 1, currentTime->tm_year + 1900})
-         << " at " << formatTime({currentTime->tm_hour, currentTime->tm_min}) << "\n";
+    string socketPath = shardSocketPath(dir, shard);
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (server < 0 || bind(server, (sockaddr*)&address, sizeof(address)) < 0 || listen(server, 4) < 0) {
+        cerr << "shard " << shard << ": cannot listen on " << socketPath << "\n";
+        cout.rdbuf(console);
+        return 1;
+    }
     
-    cout << "========================================\n";
-    cout << "          END OF REPORT\n";
-    cout << "========================================\n";
+    startCompletionSweep();
+    bool running = true;
+    int acceptDelayMs = 0;
+    while (running) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            backOffAfterAcceptError(acceptDelayMs);
+            continue;
+        }
+        acceptDelayMs = 0;
+        string pending;
+        while (receiveLine(client, pending, line)) {
+            vector<string> f = splitTraceLine(line);
+            if (f.empty()) continue;
+            if (f[0] == "quit") {
+                sendLine(client, "OK");
+                sendLine(client, ".");
+                running = false;
+                break;
+            }
+            vector<string> rows;
+            string status = handleShardCommand(f, rows);
+            sendLine(client, status);
+            for (const string& row : rows) sendLine(client, row);
+            sendLine(client, ".");
+        }
+        close(client);
+    }
+    stopCompletionSweep();
+    stopStoreEvents();
+    close(server);
+    unlink(socketPath.c_str());
+    traceFile.close();
+    cout.rdbuf(console);
+    return 0;
 }
 
-// ========== PROFILE UPDATE FUNCTIONS ==========
+int connectShard(const string& dir, int shard) {
+    string socketPath = shardSocketPath(dir, shard);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) == 0) return fd;
+        if (fd >= 0) close(fd);
+        this_thread::sleep_for(chrono::milliseconds(50));
+    }
+    return -1;
+}
 
-void displayCurrentProfile() {
-    cout << "\n=== YOUR CURRENT PROFILE ===\n";
-    
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            cout << "1. Name: " << passengers[i].name << "\n";
-            cout << "2. Email: " << passengers[i].email << "\n";
-            cout << "3. Phone: " << passengers[i].phone << "\n";
-            cout << "4. Password: ********\n";
-            cout << "------------------------------\n";
-            cout << "Total Bookings: " << passengers[i].totalBookings << "\n";
-            cout << "Total Spent: $" << fixed << setprecision(2) << passengers[i].totalSpent << "\n";
-            break;
-        }
+// Sends one command to a shard and collects its response lines
+bool askShard(int fd, string& pending, const string& command, string& status, vector<string>& rows) {
+    if (!sendLine(fd, command) || !receiveLine(fd, pending, status)) return false;
+    string row;
+    while (receiveLine(fd, pending, row)) {
+        if (row == ".") return true;
+        rows.push_back(row);
     }
+    return false;
 }
 
-void updateName() {
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            char newName[50];
-            cout << "\nCurrent Name: " << passengers[i].name << "\n";
-            cout << "Enter new name: ";
-            cin.ignore();
-            cin.getline(newName, 50);
-            
-            if (strlen(newName) > 0) {
-                strcpy(passengers[i].name, newName);
-                cout << "Name updated successfully!\n";
-            } else {
-                cout << "Name cannot be empty!\n";
+// Usage: --shard-router N DIR [--attach]
+// Starts N shard workers (or attaches to running ones) and forwards protocol
+// commands read from stdin. Commands on a flight or booking go to the shard
+// that owns it; register goes to every shard; available and history are
+// gathered from every shard and merged.
+int runShardRouter(int argc, char* argv[]) {
+    if (argc < 4 || atoi(argv[2]) < 1) {
+        cerr << "Usage: --shard-router N DIR [--attach]\n";
+        return 1;
+    }
+    int shards = atoi(argv[2]);
+    string dir = argv[3];
+    bool attach = argc > 4 && strcmp(argv[4], "--attach") == 0;
+    
+    vector<pid_t> workers;
+    // Workers forked here never outlive the router, whichever way it exits
+    auto killWorkers = [&workers] {
+        for (pid_t pid : workers) kill(pid, SIGTERM);
+        for (pid_t pid : workers) waitpid(pid, nullptr, 0);
+    };
+    if (!attach) {
+        for (int shard = 0; shard < shards; shard++) {
+            pid_t pid = fork();
+            if (pid == 0) _exit(runShardWorker(shard, shards, dir));
+            if (pid < 0) {
+                cerr << "Cannot start shard " << shard << "\n";
+                killWorkers();
+                return 1;
             }
-            return;
+            workers.push_back(pid);
         }
     }
-}
-
-void updateEmail() {
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            char newEmail[50];
-            cout << "\nCurrent Email: " << passengers[i].email << "\n";
-            
-            while (true) {
-                cout << "Enter new email: ";
-                cin.ignore();
-                cin.getline(newEmail, 50);
-                
-                if (strlen(newEmail) == 0) {
-                    cout << "Email cannot be empty!\n";
-                    continue;
+    vector<int> sockets(shards);
+    vector<string> pending(shards);
+    for (int shard = 0; shard < shards; shard++) {
+        sockets[shard] = connectShard(dir, shard);
+        if (sockets[shard] < 0) {
+            cerr << "Cannot reach shard " << shard << " at " << shardSocketPath(dir, shard) << "\n";
+            killWorkers();
+            return 1;
+        }
+    }
+    
+    string line;
+    bool stopped = false;
+    while (!stopped && getline(cin, line)) {
+        vector<string> f = splitTraceLine(line);
+        if (f.empty() || f[0].empty()) continue;
+        const string& command = f[0];
+        vector<int> targets;
+        int key;
+        if (command == "quit" || command == "register" || command == "available" || command == "history") {
+            for (int shard = 0; shard < shards; shard++) targets.push_back(shard);
+        }
+        else if ((command == "add-flight" || command == "delete" || command == "flight") && f.size() >= 2) {
+            if (!parseNumberField(f[1], key)) {
+                cout << "ERR Invalid number\n.\n";
+                continue;
+            }
+            targets.push_back(shardForFlight(key, shards));
+        }
+        else if ((command == "book" && f.size() >= 5) || (command == "cancel" && f.size() >= 3)) {
+            if (!parseNumberField(f[2], key)) {
+                cout << "ERR Invalid number\n.\n";
+                continue;
+            }
+            int shard = command == "book" ? shardForFlight(key, shards) : shardForBooking(key, shards);
+            if (shard == -1) {
+                cout << "ERR Booking not found\n.\n";
+                continue;
+            }
+            targets.push_back(shard);
+        }
+        else {
+            cout << "ERR Unknown or incomplete command\n.\n";
+            continue;
+        }
+        
+        string status = "OK";
+        vector<string> rows;
+        string forwarded = line;
+        if (command == "book") {
+            // Miles accrue where each flight lives; the tier counts them all
+            long long miles = 0;
+            for (int shard = 0; shard < shards && status == "OK"; shard++) {
+                vector<string> shardRows;
+                if (!askShard(sockets[shard], pending[shard], "miles\t" + f[1], status, shardRows)) {
+                    status = "ERR Shard " + to_string(shard) + " is unreachable";
                 }
-                
-                if (isValidEmail(newEmail)) {
-                    bool emailExists = false;
-                    for (int j = 0; j < passengerCount; j++) {
-                        if (j != i && strcmp(passengers[j].email, newEmail) == 0) {
-                            emailExists = true;
-                            break;
-                        }
-                    }
-                    
-                    if (emailExists) {
-                        cout << "This email is already registered!\n";
-                    } else {
-                        strcpy(passengers[i].email, newEmail);
-                        cout << "Email updated successfully!\n";
-                        break;
-                    }
-                } else {
-                    cout << "Invalid email format! Use format: user@domain.com\n";
+                else if (status == "OK" && !shardRows.empty()) {
+                    miles += atoll(shardRows[0].c_str());
                 }
             }
-            return;
+            if (status != "OK") {
+                cout << status << "\n.\n";
+                continue;
+            }
+            forwarded = "book\t" + f[1] + '\t' + f[2] + '\t' + f[3] + '\t' + f[4] + '\t' +
+                        to_string(min(miles, (long long)INT_MAX));
+        }
+        for (int shard : targets) {
+            string shardStatus;
+            vector<string> shardRows;
+            if (!askShard(sockets[shard], pending[shard], forwarded, shardStatus, shardRows)) {
+                shardStatus = "ERR Shard " + to_string(shard) + " is unreachable";
+            }
+            if (shardStatus != "OK") status = shardStatus;
+            if (command == "register") {
+                // Every shard must hand out the same passenger ID
+                if (rows.empty()) rows = shardRows;
+                else if (shardRows != rows) status = "ERR Passenger registries diverged";
+            }
+            else {
+                rows.insert(rows.end(), shardRows.begin(), shardRows.end());
+            }
+        }
+        if (targets.size() > 1 && command != "register") {
+            sort(rows.begin(), rows.end(), [](const string& a, const string& b) { return atoi(a.c_str()) < atoi(b.c_str()); });
         }
+        cout << status << "\n";
+        for (const string& row : rows) cout << row << "\n";
+        cout << "." << endl;
+        stopped = command == "quit";
+    }
+    
+    // Workers started here stop with the router, even at end of input
+    for (int shard = 0; shard < shards; shard++) {
+        string status;
+        vector<string> rows;
+        if (!stopped && !attach) askShard(sockets[shard], pending[shard], "quit", status, rows);
+        close(sockets[shard]);
     }
+    for (pid_t pid : workers) waitpid(pid, nullptr, 0);
+    return 0;
 }
 
-void updatePhone() {
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            char newPhone[15];
-            cout << "\nCurrent Phone: " << passengers[i].phone << "\n";
-            cout << "Enter new phone number: ";
-            cin.ignore();
-            cin.getline(newPhone, 15);
-            
-            if (strlen(newPhone) > 0) {
-                strcpy(passengers[i].phone, newPhone);
-                cout << "Phone number updated successfully!\n";
-            } else {
-                cout << "Phone number cannot be empty!\n";
-            }
-            return;
-        }
-    }
+// ========== READ REPLICAS ==========
+
+// A replica tails a primary's journal (--journal FILE on the primary, or a
+// shard's shard-K.journal) and applies each mutation to its own stores,
+// keeping the recorded IDs. It answers read-only queries on a Unix socket in
+// the shard protocol: available, flight, history, plus
+//   receipt  bookingId
+//   report
+//   lag
+// A replica that has not reached the end of the journal within --max-lag-ms
+// refuses queries with "ERR Replica is stale" rather than answer from old data.
+atomic<long long> replicaCaughtUpMicros(0);   // steady clock time the journal end was last reached
+atomic<long long> replicaRecords(0);
+atomic<bool> replicaRunning(false);
+
+long long steadyMicros() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-void updatePassword() {
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == currentPassengerId) {
-            char currentPass[30];
-            char newPass[30];
-            char confirmPass[30];
-            
-            cout << "\n=== CHANGE PASSWORD ===\n";
-            cout << "Enter current password: ";
-            cin.ignore();
-            cin.getline(currentPass, 30);
-            
-            if (strcmp(passengers[i].password, currentPass) != 0) {
-                cout << "Current password is incorrect!\n";
-                return;
+// Applies journal records as they are appended. A line is applied only once
+// its newline has been written, so a record being written is never torn.
+void tailJournal(const string& path) {
+    map<int, pair<int, int>> appliedBookings;
+    ifstream journal;
+    string partial;
+    while (replicaRunning) {
+        if (!journal.is_open()) {
+            journal.open(path);
+            if (!journal.is_open()) {
+                this_thread::sleep_for(chrono::milliseconds(10));
+                continue;
             }
-            
-            while (true) {
-                cout << "Enter new password (min 6 characters): ";
-                cin.getline(newPass, 30);
-                
-                if (strlen(newPass) < 6) {
-                    cout << "Password must be at least 6 characters!\n";
-                    continue;
-                }
-                
-                cout << "Confirm new password: ";
-                cin.getline(confirmPass, 30);
-                
-                if (strcmp(newPass, confirmPass) != 0) {
-                    cout << "Passwords do not match!\n";
-                } else {
-                    strcpy(passengers[i].password, newPass);
-                    cout << "Password changed successfully!\n";
-                    break;
-                }
+        }
+        char chunk[4096];
+        journal.read(chunk, sizeof(chunk));
+        streamsize got = journal.gcount();
+        if (got == 0) {
+            replicaCaughtUpMicros = steadyMicros();
+            journal.clear();
+            this_thread::sleep_for(chrono::milliseconds(5));
+            continue;
+        }
+        partial.append(chunk, got);
+        size_t end;
+        while ((end = partial.find('\n')) != string::npos) {
+            vector<string> f = splitTraceLine(partial.substr(0, end));
+            partial.erase(0, end + 1);
+            if (f.size() < 2 || f[1] == "S") continue;
+            string error;
+            if (!applyTraceRecord(f, true, appliedBookings, error)) {
+                cerr << "replica: journal record " << replicaRecords + 1 << " not applied\n";
             }
-            return;
+            replicaRecords++;
         }
     }
 }
 
-void updateProfile() {
-    if (currentPassengerId == -1) {
-        cout << "You must login first!\n";
-        return;
+string handleReplicaQuery(const vector<string>& f, vector<string>& rows, long long maxLagMicros) {
+    const string& command = f[0];
+    long long lag = steadyMicros() - replicaCaughtUpMicros;
+    if (command == "lag") {
+        rows.push_back(to_string(lag / 1000) + "\t" + to_string(replicaRecords.load()));
+        return "OK";
     }
+    if (lag > maxLagMicros) return "ERR Replica is stale (" + to_string(lag / 1000) + " ms behind)";
     
-    int choice;
-    bool updating = true;
-    
-    while (updating) {
-        cout << "\n========================================\n";
-        cout << "          UPDATE PROFILE\n";
-        cout << "========================================\n";
-        
-        displayCurrentProfile();
-        
-        cout << "\nWhat would you like to update?\n";
-        cout << "1. Update Name\n";
-        cout << "2. Update Email\n";
-        cout << "3. Update Phone Number\n";
-        cout << "4. Change Password\n";
-        cout << "5. Back to Main Menu\n";
-        cout << "----------------------------------------\n";
-        cout << "Enter your choice (1-5): ";
-        
-        cin >> choice;
-        
-        switch(choice) {
-            case 1: updateName(); break;
-            case 2: updateEmail(); break;
-            case 3: updatePhone(); break;
-            case 4: updatePassword(); break;
-            case 5: 
-                cout << "Returning to main menu...\n";
-                updating = false;
-                break;
-            default:
-                cout << "Invalid choice! Please enter 1-5.\n";
+    if (command == "available" || command == "flight" || command == "history") {
+        return handleShardCommand(f, rows);
+    }
+    if (command == "receipt" && f.size() >= 2) {
+        int bookingId;
+        if (!parseNumberField(f[1], bookingId)) return "ERR Invalid number";
+        StoreSnapshot snapshot;
+        for (int i = 0; i < snapshot.bookingSlots; i++) {
+            Booking booking;
+            snapshot.readBooking(i, booking);
+            if (booking.archived || booking.bookingId != bookingId) continue;
+            Passenger* passenger = findPassengerById(booking.passengerId);
+            Flight flight = Flight();
+            if (!snapshot.findFlight(booking.flightNo, flight)) flight = Flight();
+            rows.push_back(describeShardBooking(booking) + '\t' + (passenger ? passenger->name : "") +
+                           '\t' + cityName(flight.origin) + '\t' + cityName(flight.destination));
+            return "OK";
         }
-        
-        if (choice >= 1 && choice <= 4) {
-            char more;
-            cout << "\nDo you want to update something else? (Y/N): ";
-            cin >> more;
-            
-            if (more != 'Y' && more != 'y') {
-                updating = false;
-                cout << "Profile update completed.\n";
-            }
+        return "ERR Booking not found";
+    }
+    if (command == "report") {
+        StoreSnapshot snapshot;
+        int flightsListed = 0;
+        for (int i = 0; i < snapshot.flightSlots; i++) {
+            Flight flight;
+            snapshot.readFlight(i, flight);
+            if (!flight.deleted) flightsListed++;
+        }
+        int byStatus[BOOKING_STATUS_COUNT] = {};
+        double revenue = 0;
+        for (int i = 0; i < snapshot.bookingSlots; i++) {
+            Booking booking;
+            snapshot.readBooking(i, booking);
+            if (booking.archived) continue;
+            byStatus[booking.status]++;
+            if (booking.status != BOOKING_CANCELLED) revenue += fromCents(booking.fareCents);
         }
+        rows.push_back("flights\t" + to_string(flightsListed));
+        for (int s = 0; s < BOOKING_STATUS_COUNT; s++) {
+            rows.push_back(string("bookings_") + BOOKING_STATUS_NAMES[s] + '\t' + to_string(byStatus[s]));
+        }
+        ostringstream total;
+        total << fixed << setprecision(2) << "revenue\t" << revenue;
+        rows.push_back(total.str());
+        return "OK";
     }
+    return "ERR Replicas answer only available, flight, history, receipt, report and lag";
 }
 
-// ========== ADMIN FUNCTIONS ==========
-
-void adminMenu() {
-    int choice;
-    bool loggedIn = true;
+// Usage: --replica JOURNAL SOCKET [--max-lag-ms N]
+int runReplica(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "Usage: --replica JOURNAL SOCKET [--max-lag-ms N]\n";
+        return 1;
+    }
+    long long maxLagMicros = 1000000;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--max-lag-ms") == 0) maxLagMicros = atoll(argv[i + 1]) * 1000;
+    }
+    string socketPath = argv[3];
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (server < 0 || bind(server, (sockaddr*)&address, sizeof(address)) < 0 || listen(server, 16) < 0) {
+        cerr << "Cannot listen on " << socketPath << "\n";
+        return 1;
+    }
     
-    while (loggedIn) {
-        cout << "\n===== ADMIN PANEL =====\n";
-        cout << "1. Add Flight\n";
-        cout << "2. View All Flights\n";
-        cout << "3. Update Flight\n";
-        cout << "4. Delete Flight\n";
-        cout << "5. View All Bookings\n";
-        cout << "6. View Passenger Details\n";
-        cout << "7. Logout\n";
-        cout << "Enter choice: ";
-        cin >> choice;
-        
-        switch(choice) {
-            case 1:
-                addFlight(flights, flightCount);
-                break;
-            case 2:
-                viewFlights(flights, flightCount);
-                break;
-            case 3:
-                updateFlight(flights, flightCount);
-                break;
-            case 4:
-                deleteFlight(flights, flightCount);
-                break;
-            case 5:
-                viewAllBookings();
-                break;
-            case 6:
-                cout << "\n=== PASSENGER DETAILS ===\n";
-                for (int i = 0; i < passengerCount; i++) {
-                    cout << "ID: " << passengers[i].id 
-                         << " | Name: " << passengers[i].name
-                         << " | Email: " << passengers[i].email
-                         << " | Bookings: " << passengers[i].totalBookings
-                         << " | Spent: $" << passengers[i].totalSpent << endl;
-                }
-                break;
-            case 7:
-                cout << "Logging out...\n";
-                loggedIn = false;
+    streambuf* console = cout.rdbuf(&nullBuffer);
+    replicaRunning = true;
+    thread tail(tailJournal, string(argv[2]));
+    bookingArchivePath.clear();   // the primary archives; a replica keeps what it has copied
+    startCompletionSweep();
+    
+    bool running = true;
+    int acceptDelayMs = 0;
+    while (running) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            backOffAfterAcceptError(acceptDelayMs);
+            continue;
+        }
+        acceptDelayMs = 0;
+        string pending;
+        string line;
+        while (receiveLine(client, pending, line)) {
+            vector<string> f = splitTraceLine(line);
+            if (f.empty()) continue;
+            if (f[0] == "quit") {
+                sendLine(client, "OK");
+                sendLine(client, ".");
+                running = false;
                 break;
-            default:
-                cout << "Invalid choice!\n";
+            }
+            vector<string> rows;
+            string status = handleReplicaQuery(f, rows, maxLagMicros);
+            sendLine(client, status);
+            for (const string& row : rows) sendLine(client, row);
+            sendLine(client, ".");
         }
+        close(client);
     }
+    
+    replicaRunning = false;
+    tail.join();
+    stopCompletionSweep();
+    close(server);
+    unlink(socketPath.c_str());
+    cout.rdbuf(console);
+    return 0;
 }
 
-void adminLoginPanel() {
-    cout << "\n=== ADMIN LOGIN ===\n";
-    
-    string username, password;
-    cout << "Enter Admin Username: ";
-    cin >> username;
-    cout << "Enter Admin Password: ";
-    cin >> password;
-    
-    if (username == "admin" && password == "1234") 
-    {
-        cout << "\nLogin successful! Welcome Admin!\n";
-     
-        adminMenu();
-    } else 
-    {
-        cout << "Access Denied! Invalid credentials.\n";
+// Usage: --ask SOCKET
+// Sends protocol commands read from stdin to a shard worker or replica and
+// prints each response, for scripts and manual checks.
+int runSocketClient(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: --ask SOCKET\n";
+        return 1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, argv[2], sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        cerr << "Cannot connect to " << argv[2] << "\n";
+        return 1;
+    }
+    string pending;
+    string line;
+    while (getline(cin, line)) {
+        if (line.empty()) continue;
+        string status;
+        vector<string> rows;
+        if (!askShard(fd, pending, line, status, rows)) {
+            cerr << "Connection to " << argv[2] << " closed\n";
+            close(fd);
+            return 1;
+        }
+        cout << status << "\n";
+        for (const string& row : rows) cout << row << "\n";
+        cout << "." << endl;
     }
+    close(fd);
+    return 0;
 }
 
-void addFlight(Flight flights[], int &flightCount) {
-    if (flightCount >= MAX_FLIGHTS) {
-        cout << "Cannot add more flights. Maximum capacity reached.\n";
-        return;
+// The menu-driven session, with optional metrics endpoint and recording
+void runInteractive(int argc, char* argv[]) {
+    // Menus read stdin through their own buffer and only this thread writes
+    // to cout, so the standard streams need not stay in step with stdio
+    ios::sync_with_stdio(false);
+    
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--metrics-port") == 0) {
+            int port = atoi(argv[i + 1]);
+            if (!startMetricsServer(port)) {
+                cerr << "Cannot serve metrics on 127.0.0.1:" << port << "\n";
+            }
+        }
+        else if (strcmp(argv[i], "--record") == 0) {
+            if (!startTrace(argv[i + 1], false)) {
+                cerr << "Cannot record session to " << argv[i + 1] << "\n";
+            }
+        }
+        else if (strcmp(argv[i], "--journal") == 0) {
+            // Mutations only, written through as they happen, for replicas to tail
+            traceSearches = false;
+            traceFlushEachRecord = true;
+            if (!startTrace(argv[i + 1], true)) {
+                cerr << "Cannot write journal " << argv[i + 1] << "\n";
+            }
+        }
     }
     
-    int flightNo;
-    do {
-        cout << "Enter Flight Number (positive integer): ";
-        cin >> flightNo;
-        if (flightNo <= 0) cout << "Invalid flight number!\n";
-    } while (flightNo <= 0);
-    
-    flights[flightCount].flightNo = flightNo;
-    cin.ignore();
-    
-    cout << "Enter Origin: ";
-    cin.getline(flights[flightCount].origin, 50);
-    
-    cout << "Enter Destination: ";
-    cin.getline(flights[flightCount].destination, 50);
-    
-    int day, month, year;
-    do {
-        cout << "Enter Departure Date (dd mm yyyy): ";
-        cin >> day >> month >> year;
-        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
-    } while (!isValidDate(day, month, year));
-    flights[flightCount].departureDate = {day, month, year};
-    
-    int hour, minute;
-    do {
-        cout << "Enter Departure Time (hh mm, 0-23 & 0-59): ";
-        cin >> hour >> minute;
-        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
-    } while (!isValidTime(hour, minute));
-    flights[flightCount].departureTime = {hour, minute};
-    
-    do {
-        cout << "Enter Arrival Date (dd mm yyyy): ";
-        cin >> day >> month >> year;
-        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
-    } while (!isValidDate(day, month, year));
-    flights[flightCount].arrivalDate = {day, month, year};
-    
-    do {
-        cout << "Enter Arrival Time (hh mm, 0-23 & 0-59): ";
-        cin >> hour >> minute;
-        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
-    } while (!isValidTime(hour, minute));
-    flights[flightCount].arrivalTime = {hour, minute};
-    
-    do
-     {
-        cout << "Enter Economy Seats: ";
-        cin >> flights[flightCount].economySeats;
-    } while (flights[flightCount].economySeats < 0);
-    
-    do
-    {
-        cout << "Enter Business Seats: ";
-        cin >> flights[flightCount].businessSeats;
-    } while (flights[flightCount].businessSeats < 0);
-    
-    do 
-    {
-        cout << "Enter First Class Seats: ";
-        cin >> flights[flightCount].firstClassSeats;
-    } while (flights[flightCount].firstClassSeats < 0);
-    
-    do 
-    {
-        cout << "Enter Economy Fare(per KM): ";
-        cin >> flights[flightCount].economyFare;
-    } while (flights[flightCount].economyFare < 0);
+    startCompletionSweep();
+    mainMenu();
+    stopCompletionSweep();
+    stopMetricsServer();
+}
+
+// ========== BOOKING SESSIONS ==========
+
+// A booking session is the bookFlight dialogue written as a C++20 coroutine.
+// At each prompt it suspends until the client's next line arrives or its
+// timer runs out, so an open session costs one coroutine frame instead of a
+// blocked thread, and a few session workers can drive tens of thousands of
+// them. Once the class is chosen the seats are held, and the client has until
+// the hold runs out to give a travel date and confirm; seats that are not
+// booked go back on sale when the session ends, however it ends.
+
+const int SESSION_IDLE_SECONDS = 300;   // an unanswered prompt ends the session after this long
+int seatHoldMillis = 120000;            // how long held seats wait for a confirmation
+
+enum SessionOutcome {
+    SESSION_BOOKED,
+    SESSION_CANCELLED,
+    SESSION_HOLD_EXPIRED,
+    SESSION_TIMED_OUT,
+    SESSION_CLOSED,
+    SESSION_FAILED,
+    SESSION_OUTCOME_COUNT
+};
+const char* SESSION_OUTCOME_NAMES[SESSION_OUTCOME_COUNT] = {
+    "booked", "cancelled", "hold_expired", "timed_out", "closed", "failed"
+};
+atomic<long long> sessionOutcomes[SESSION_OUTCOME_COUNT];
+
+// Receives everything a session says, as one chunk per prompt. Set before
+// the first session opens; null drops the output.
+void (*sessionOutput)(int sessionId, const string& text) = nullptr;
+
+// Sessions start running as soon as they are opened and free their own frame
+// when they finish, so nobody holds on to the coroutine handle
+struct SessionTask {
+    struct promise_type {
+        SessionTask get_return_object() { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+// A prompt's deadline; stale once the session has moved on to another wait
+struct SessionTimer {
+    chrono::steady_clock::time_point deadline;
+    int sessionId;
+    unsigned waitNumber;
+    bool operator>(const SessionTimer& other) const { return deadline > other.deadline; }
+};
+
+struct BookingSession;
+
+mutex sessionMutex;                 // guards everything below and every session's inbox
+condition_variable sessionWork;     // a session became ready, a timer was set, or the pool is stopping
+condition_variable sessionsIdle;    // no session is ready or running, or none is open
+map<int, BookingSession*> sessions;
+deque<coroutine_handle<>> readySessions;
+priority_queue<SessionTimer, vector<SessionTimer>, greater<SessionTimer>> sessionTimers;
+int sessionsRunning = 0;
+int nextSessionId = 1;
+size_t peakOpenSessions = 0;
+bool stoppingSessions = false;
+vector<thread> sessionWorkers;
+
+// Lives in the session's coroutine frame and registers it for input while it is open
+struct BookingSession {
+    int id;
+    int passengerId;
+    deque<string> inbox;
+    coroutine_handle<> handle;
+    bool waiting = false;       // suspended at a prompt and not yet queued to resume
+    bool closed = false;
+    unsigned waitNumber = 0;
+    SessionOutcome outcome = SESSION_CLOSED;
+    
+    BookingSession(int passengerId) : passengerId(passengerId) {
+        lock_guard<mutex> lock(sessionMutex);
+        id = nextSessionId++;
+        sessions[id] = this;
+        peakOpenSessions = max(peakOpenSessions, sessions.size());
+    }
     
-    do 
-    {
-        cout << "Enter Business Fare(per KM): ";
-        cin >> flights[flightCount].businessFare;
-    } while (flights[flightCount].businessFare < 0);
+    ~BookingSession() {
+        sessionOutcomes[outcome]++;
+        lock_guard<mutex> lock(sessionMutex);
+        sessions.erase(id);
+        if (sessions.empty()) sessionsIdle.notify_all();
+    }
     
-    do 
-    {
-        cout << "Enter First Class Fare(per KM): ";
-        cin >> flights[flightCount].firstClassFare;
-    } while (flights[flightCount].firstClassFare < 0);
+    void say(const string& text) {
+        if (sessionOutput) sessionOutput(id, text);
+    }
     
-    flights[flightCount].totalSeats = flights[flightCount].economySeats +
-                                      flights[flightCount].businessSeats +
-                                      flights[flightCount].firstClassSeats;
-    flights[flightCount].availableSeats = flights[flightCount].totalSeats;
+    // Records why a wait for input came back empty
+    void endWait(SessionOutcome expired) {
+        outcome = closed ? SESSION_CLOSED : expired;
+    }
+};
+
+// Queues a suspended session to be resumed. The caller holds sessionMutex.
+void wakeSession(BookingSession& session) {
+    if (!session.waiting) return;
+    session.waiting = false;
+    readySessions.push_back(session.handle);
+    sessionWork.notify_one();
+}
+
+// co_await SessionInput{session, deadline, line} suspends until the next line
+// of input, which it stores in line. Resumes with false if the deadline
+// passed first or the session was closed.
+struct SessionInput {
+    BookingSession& session;
+    chrono::steady_clock::time_point deadline;
+    string& line;
+    
+    bool await_ready() { return false; }
+    
+    bool await_suspend(coroutine_handle<> handle) {
+        lock_guard<mutex> lock(sessionMutex);
+        if (!session.inbox.empty() || session.closed) return false;
+        session.handle = handle;
+        session.waiting = true;
+        bool earliest = sessionTimers.empty() || deadline < sessionTimers.top().deadline;
+        sessionTimers.push({deadline, session.id, ++session.waitNumber});
+        if (earliest) sessionWork.notify_one();
+        return true;
+    }
     
-    do 
-    {
-        cout << "Enter Distance (positive): ";
-        cin >> flights[flightCount].distance;
-        if (flights[flightCount].distance < 0) cout << "Invalid distance!\n";
-    } while (flights[flightCount].distance < 0);
+    bool await_resume() {
+        lock_guard<mutex> lock(sessionMutex);
+        if (session.closed || session.inbox.empty()) return false;
+        line = move(session.inbox.front());
+        session.inbox.pop_front();
+        return true;
+    }
+};
+
+chrono::steady_clock::time_point idleDeadline() {
+    return chrono::steady_clock::now() + chrono::seconds(SESSION_IDLE_SECONDS);
+}
+
+// Seats held for a session, put back on sale unless they were booked
+struct SeatHold {
+    int flightNo;
+    unsigned char cabin;
+    int seats;
+    bool held = false;
     
-    flights[flightCount].baseFare = flights[flightCount].economyFare;
-    strcpy(flights[flightCount].status, "Available");
-    flights[flightCount].timesBooked = 0;
-    flights[flightCount].totalRevenue = 0.0;
+    bool place(string& error) {
+        held = holdSeats(flightNo, cabin, seats, error);
+        return held;
+    }
     
-    flightCount++;
-    cout << "\nFlight added successfully!\n";
-}
+    ~SeatHold() {
+        if (held) releaseSeatHold(flightNo, cabin, seats);
+    }
+};
 
-void updateFlight(Flight flights[], int flightCount) {
-    if (flightCount == 0) {
-        cout << "No flights available to update.\n";
-        return;
+// The bookFlight dialogue for one passenger. openedId is written before the
+// first prompt so the caller learns the session's id.
+SessionTask runBookingSession(int passengerId, int* openedId) {
+    BookingSession session(passengerId);
+    *openedId = session.id;
+    string line;
+    
+    if (!findPassengerById(passengerId)) {
+        session.say("Unknown passenger!\n");
+        session.outcome = SESSION_FAILED;
+        co_return;
+    }
+    {
+        ostringstream out;
+        out << "\n=== BOOK A FLIGHT ===\n";
+        AvailabilityCursor cursor;
+        renderAvailableFlightsPage(cursor, out);
+        out << "\nEnter Flight Number to book (0 to cancel): ";
+        session.say(out.str());
     }
     
     int flightNo;
-    cout << "Enter Flight Number to update: ";
-    cin >> flightNo;
+    if (!co_await SessionInput{session, idleDeadline(), line}) {
+        session.endWait(SESSION_TIMED_OUT);
+        co_return;
+    }
+    if (parseNumberField(line, flightNo) && flightNo == 0) {
+        session.outcome = SESSION_CANCELLED;
+        co_return;
+    }
+    Flight flight;
+    if (!parseNumberField(line, flightNo) || !snapshotFlight(flightNo, flight) || !isOpenForBooking(flight)) {
+        session.say("Invalid flight selection or flight not available!\n");
+        session.outcome = SESSION_FAILED;
+        co_return;
+    }
+    if (flight.availableSeats <= 0) {
+        session.say("Sorry, this flight is fully booked!\n");
+        session.outcome = SESSION_FAILED;
+        co_return;
+    }
     
-    int index = -1;
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].flightNo == flightNo) {
-            index = i;
-            break;
+    int seats = 0;
+    int maxSeats = min(flight.availableSeats, MAX_SEATS_PER_BOOKING);
+    session.say("Number of seats to book (1-" + to_string(maxSeats) + "): ");
+    while (true) {
+        if (!co_await SessionInput{session, idleDeadline(), line}) {
+            session.endWait(SESSION_TIMED_OUT);
+            co_return;
         }
+        if (parseNumberField(line, seats) && seats >= 1 && seats <= maxSeats) break;
+        session.say("Invalid! Enter between 1 and " + to_string(maxSeats) + " seats: ");
     }
     
-    if (index == -1) {
-        cout << "Flight not found.\n";
-        return;
+    {
+        ostringstream out;
+        out << "\nSelect Class Type:\n";
+        for (int c = 0; c < CABIN_COUNT; c++) {
+            out << c + 1 << ". " << CABIN_CLASSES[c].label << " (" << fixed << setprecision(1)
+                << CABIN_CLASSES[c].fareMultiplier << "x)\n";
+        }
+        out << "Enter choice (1-" << CABIN_COUNT << "): ";
+        session.say(out.str());
     }
-    
-    cout << "\nUpdating Flight #" << flights[index].flightNo << ":\n";
-    cin.ignore();
-    
-    cout << "Enter new Origin (current: " << flights[index].origin << "): ";
-    cin.getline(flights[index].origin, 50);
-    
-    cout << "Enter new Destination (current: " << flights[index].destination << "): ";
-    cin.getline(flights[index].destination, 50);
-    
-    int day, month, year;
-    do {
-        cout << "Enter new Departure Date (dd mm yyyy): ";
-        cin >> day >> month >> year;
-        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
-    } while (!isValidDate(day, month, year));
-    flights[index].departureDate = {day, month, year};
-    
-    int hour, minute;
-    do {
-        cout << "Enter new Departure Time (hh mm): ";
-        cin >> hour >> minute;
-        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
-    } while (!isValidTime(hour, minute));
-    flights[index].departureTime = {hour, minute};
-    
-    do {
-        cout << "Enter new Arrival Date (dd mm yyyy): ";
-        cin >> day >> month >> year;
-        if (!isValidDate(day, month, year)) cout << "Invalid date! Try again.\n";
-    } while (!isValidDate(day, month, year));
-    flights[index].arrivalDate = {day, month, year};
-    
-    do {
-        cout << "Enter new Arrival Time (hh mm): ";
-        cin >> hour >> minute;
-        if (!isValidTime(hour, minute)) cout << "Invalid time! Try again.\n";
-    } while (!isValidTime(hour, minute));
-    flights[index].arrivalTime = {hour, minute};
-    
-    cout << "Flight updated successfully!\n";
-}
-
-void deleteFlight(Flight flights[], int &flightCount) {
-    if (flightCount == 0) {
-        cout << "No flights available to delete.\n";
-        return;
+    if (!co_await SessionInput{session, idleDeadline(), line}) {
+        session.endWait(SESSION_TIMED_OUT);
+        co_return;
+    }
+    int classChoice;
+    unsigned char cabin = CABIN_ECONOMY;
+    if (parseNumberField(line, classChoice) && classChoice >= 1 && classChoice <= CABIN_COUNT) {
+        cabin = classChoice - 1;
+    } else {
+        session.say(string("Invalid choice! Defaulting to ") + CABIN_CLASSES[CABIN_ECONOMY].name + ".\n");
     }
     
-    int flightNo;
-    cout << "Enter Flight Number to delete: ";
-    cin >> flightNo;
+    // From here on the seats are off sale and the client answers against the hold
+    SeatHold hold{flightNo, cabin, seats};
+    string error;
+    if (!hold.place(error)) {
+        session.say("Sorry! " + error + ".\n");
+        session.outcome = SESSION_FAILED;
+        co_return;
+    }
+    auto holdDeadline = chrono::steady_clock::now() + chrono::milliseconds(seatHoldMillis);
+    session.say("Seats held for " + to_string((seatHoldMillis + 999) / 1000) + " seconds.\n"
+                "\nEnter travel date (DD MM YYYY): ");
     
-    int index = -1;
-    for (int i = 0; i < flightCount; i++) {
-        if (flights[i].flightNo == flightNo) {
-            index = i;
+    Date travelDate;
+    while (true) {
+        if (!co_await SessionInput{session, holdDeadline, line}) {
+            session.say("Seat hold expired.\n");
+            session.endWait(SESSION_HOLD_EXPIRED);
+            co_return;
+        }
+        istringstream in(line);
+        if (!(in >> travelDate.day >> travelDate.month >> travelDate.year) || !isValidDate(travelDate)) {
+            session.say("Invalid date! Enter travel date (DD MM YYYY): ");
+        } else if (!isFutureDate(travelDate)) {
+            session.say("Travel date must be in the future! Enter travel date (DD MM YYYY): ");
+        } else {
             break;
         }
     }
     
-    if (index == -1) {
-        cout << "Flight not found.\n";
-        return;
+    float fare = calculateFare(flight, seats, cabin);
+    float loyaltyFare = applyLoyaltyDiscount(fare, passengerId);
+    {
+        ostringstream out;
+        out << "\n=== BOOKING SUMMARY ===\n";
+        out << "Flight: " << cityName(flight.origin) << " to " << cityName(flight.destination) << "\n";
+        out << "Date: " << travelDate.day << "/" << travelDate.month << "/" << travelDate.year << "\n";
+        out << "Seats: " << seats << " (" << cabinName(cabin) << " class)\n";
+        displayFareBreakdown(out, flight, seats, cabin);
+        if (loyaltyFare < fare) {
+            Passenger* passenger = findPassengerById(passengerId);
+            out << "Loyalty discount (" << LOYALTY_TIER_NAMES[loyaltyTier(*passenger)] << "): -$"
+                << fixed << setprecision(2) << fare - loyaltyFare << "\n";
+            fare = loyaltyFare;
+        }
+        out << "Total Fare: $" << fixed << setprecision(2) << fare << "\n";
+        out << "\nConfirm booking? (Y/N): ";
+        session.say(out.str());
     }
     
-    for (int i = index; i < flightCount - 1; i++) {
-        flights[i] = flights[i + 1];
+    if (!co_await SessionInput{session, holdDeadline, line}) {
+        session.say("Seat hold expired.\n");
+        session.endWait(SESSION_HOLD_EXPIRED);
+        co_return;
+    }
+    size_t answer = line.find_first_not_of(" \t");
+    if (answer == string::npos || (line[answer] != 'Y' && line[answer] != 'y')) {
+        session.say("Booking cancelled.\n");
+        session.outcome = SESSION_CANCELLED;
+        co_return;
     }
     
-    flightCount--;
-    cout << "Flight #" << flightNo << " deleted successfully!\n";
+    Booking newBooking = {};
+    newBooking.bookingId = generateBookingId();
+    newBooking.passengerId = passengerId;
+    newBooking.flightNo = flightNo;
+    time_t now = time(0);
+    tm currentTime;
+    localtime_r(&now, &currentTime);
+    newBooking.bookingDate = packDate({currentTime.tm_mday, currentTime.tm_mon + 1, currentTime.tm_year + 1900});
+    newBooking.travelDate = packDate(travelDate);
+    newBooking.seatsBooked = seats;
+    newBooking.cabin = cabin;
+    newBooking.fareCents = toCents(fare);
+    newBooking.status = BOOKING_CONFIRMED;
+    
+    if (commitBooking(newBooking, error, true) == -1) {
+        session.say("Error: " + error + "!\n");
+        session.outcome = SESSION_FAILED;
+        co_return;
+    }
+    hold.held = false;
+    session.say("\n Booking confirmed! Booking ID: " + to_string(newBooking.bookingId) + "\n"
+                "You can view the receipt anytime from 'View Booking Receipt' in menu.\n");
+    session.outcome = SESSION_BOOKED;
 }
 
-
-//============================================================
-
-void showPassengerMenu() {
-    int choice;
-    bool loggedIn = true;
-    
-    while (loggedIn) {
-        cout << "\n=== PASSENGER MENU ===\n";
-        cout << "1. View Available Flights (Summary)\n";
-        cout << "2. View Flight Details with Seats\n";
-        cout << "3. Book a Flight\n";
-        cout << "4. View My Bookings\n";
-        cout << "5. Cancel Booking\n";
-        cout << "6. View Booking Receipt\n";
-        cout << "7. Generate Personal Report\n";
-        cout << "8. Update Profile\n";
-        cout << "9. Logout\n";
-        cout << "\nEnter your choice (1-9): ";
-        
-        cin >> choice;
-        
-        switch(choice) {
-            case 1:
-             viewAvailableFlights();
-            break;
-            case 2: 
-            viewFlightDetailsWithSeats();
-             break;
-            case 3: 
-            bookFlight();
-             break;
-            case 4:
-             displayPassengerBookings();
-              break;
-            case 5:
-             cancelBooking(); 
-             break;
-            case 6: 
-                if (currentPassengerId == -1) {
-                    cout << "You must login first!\n";
-                } else {
-                    int receiptId;
-                    cout << "Enter Booking ID for receipt: ";
-                    cin >> receiptId;
-                    generateBookingReceipt(receiptId);
-                }
-                break;
-            case 7: generatePersonalReport(); break;
-            case 8: updateProfile(); break;
-            case 9: 
-                cout << "Logged out successfully!\n";
-                loggedIn = false;
-                currentPassengerId = -1;
-                break;
-            default:
-                cout << "Invalid choice! Please try again.\n";
+// Resumes sessions that have input or whose timer ran out, one at a time per
+// worker, until stopSessionWorkers
+void runSessionWorker() {
+    unique_lock<mutex> lock(sessionMutex);
+    while (true) {
+        auto now = chrono::steady_clock::now();
+        while (!sessionTimers.empty() && sessionTimers.top().deadline <= now) {
+            SessionTimer timer = sessionTimers.top();
+            sessionTimers.pop();
+            auto found = sessions.find(timer.sessionId);
+            if (found != sessions.end() && found->second->waitNumber == timer.waitNumber) {
+                wakeSession(*found->second);
+            }
         }
+        if (!readySessions.empty()) {
+            coroutine_handle<> handle = readySessions.front();
+            readySessions.pop_front();
+            sessionsRunning++;
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+            sessionsRunning--;
+            if (sessionsRunning == 0 && readySessions.empty()) sessionsIdle.notify_all();
+            continue;
+        }
+        if (stoppingSessions) return;
+        if (sessionTimers.empty()) sessionWork.wait(lock);
+        else sessionWork.wait_until(lock, sessionTimers.top().deadline);
     }
 }
 
-void passengerLogin() {
-    cout << "\n=== PASSENGER LOGIN ===\n";
-    
-    int id;
-    char password[30];
-    
-    cout << "Enter Passenger ID: ";
-    cin >> id;
-    cin.ignore();
-    
-    cout << "Enter Password: ";
-    cin.getline(password, 30);
-    
-    for (int i = 0; i < passengerCount; i++) {
-        if (passengers[i].id == id && strcmp(passengers[i].password, password) == 0) {
-            currentPassengerId = id;
-            cout << "\nLogin successful! Welcome " << passengers[i].name << "!\n";
-            showPassengerMenu();
-            return;
+void startSessionWorkers(int threads) {
+    stoppingSessions = false;
+    for (int t = 0; t < threads; t++) sessionWorkers.emplace_back(runSessionWorker);
+}
+
+// Opens a booking session for a passenger and runs it up to its first prompt
+// on the calling thread. Returns the session's id.
+int openBookingSession(int passengerId) {
+    int sessionId = 0;
+    runBookingSession(passengerId, &sessionId);
+    return sessionId;
+}
+
+// Hands a line of input to a session. Returns false if no such session is open.
+bool deliverSessionInput(int sessionId, const string& line) {
+    lock_guard<mutex> lock(sessionMutex);
+    auto found = sessions.find(sessionId);
+    if (found == sessions.end()) return false;
+    found->second->inbox.push_back(line);
+    wakeSession(*found->second);
+    return true;
+}
+
+// Ends a session at its next prompt, releasing any seats it holds
+bool closeSession(int sessionId) {
+    lock_guard<mutex> lock(sessionMutex);
+    auto found = sessions.find(sessionId);
+    if (found == sessions.end()) return false;
+    found->second->closed = true;
+    wakeSession(*found->second);
+    return true;
+}
+
+// Waits until every session with input has run up to its next prompt
+void waitForIdleSessions() {
+    unique_lock<mutex> lock(sessionMutex);
+    sessionsIdle.wait(lock, [] { return readySessions.empty() && sessionsRunning == 0; });
+}
+
+// Waits until every session has ended, on its own or by its timers
+void waitForSessionsToEnd() {
+    unique_lock<mutex> lock(sessionMutex);
+    sessionsIdle.wait(lock, [] { return sessions.empty(); });
+}
+
+// Closes whatever sessions are still open, lets them release their seats and
+// stops the workers
+void stopSessionWorkers() {
+    {
+        lock_guard<mutex> lock(sessionMutex);
+        for (auto& open : sessions) {
+            open.second->closed = true;
+            wakeSession(*open.second);
         }
     }
-    
-    cout << "Invalid credentials! Please try again.\n";
+    waitForSessionsToEnd();
+    {
+        lock_guard<mutex> lock(sessionMutex);
+        stoppingSessions = true;
+    }
+    sessionWork.notify_all();
+    for (thread& worker : sessionWorkers) worker.join();
+    sessionWorkers.clear();
 }
 
-void PassengerRegistration() {
-    if (passengerCount >= MAX_PASSENGERS) {
-        cout << "Maximum passenger limit reached!\n";
-        return;
+mutex sessionConsoleMutex;
+
+// Writes session output to stdout, each line tagged with the session's id
+void printSessionOutput(int sessionId, const string& text) {
+    string tagged;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == string::npos) end = text.size();
+        tagged += to_string(sessionId) + '\t' + text.substr(start, end - start) + '\n';
+        start = end + 1;
     }
+    lock_guard<mutex> lock(sessionConsoleMutex);
+    cout << tagged << flush;
+}
 
-    Passenger newPassenger;
-    
-    cout << "\n=== PASSENGER REGISTRATION ===\n";
-    
-    newPassenger.id = 1000 + passengerCount + 1;
-    cout << "Your Passenger ID: " << newPassenger.id << " (Remember this for login)\n";
-    
-    cout << "Enter your name: ";
-    cin.ignore();
-    cin.getline(newPassenger.name, 50);
-    
-    cout << "Enter your Password: ";
-    cin.getline(newPassenger.password, 30);
+// Usage: --sessions [--threads N] [--hold-seconds S] [--journal FILE]
+// Serves booking sessions over stdin and stdout. Input lines are
+// "open<TAB>PASSENGER_ID", "close<TAB>SESSION" or "SESSION<TAB>ANSWER";
+// output lines are "SESSION<TAB>TEXT". The store is recovered from the
+// journal, which then records the bookings made.
+int runSessionServer(int argc, char* argv[]) {
+    int threads = 2;
+    const char* journalPath = nullptr;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--threads") == 0) threads = max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--hold-seconds") == 0) seatHoldMillis = max(1, atoi(argv[i + 1])) * 1000;
+        else if (strcmp(argv[i], "--journal") == 0) journalPath = argv[i + 1];
+    }
     
-    char email[50];
-    while (true) {
-        cout << "Enter E-mail: ";
-        cin.getline(email, 50);
-        if (isValidEmail(email)) {
-            strcpy(newPassenger.email, email);
-            break;
-        } else {
-            cout << "Invalid email format! Please enter a valid email (e.g., user@domain.com)\n";
+    if (journalPath) {
+        streambuf* console = cout.rdbuf(&nullBuffer);
+        ifstream journal(journalPath);
+        map<int, pair<int, int>> recovered;
+        string line;
+        while (getline(journal, line)) {
+            vector<string> f = splitTraceLine(line);
+            if (f.size() < 2 || f[1].size() != 1) continue;
+            string error;
+            if (!applyTraceRecord(f, true, recovered, error)) {
+                cerr << "Journal record not applied: " << line << "\n";
+            }
+        }
+        journal.close();
+        cout.rdbuf(console);
+        traceSearches = false;
+        traceFlushEachRecord = true;
+        if (!startTrace(journalPath, true)) {
+            cerr << "Cannot write journal " << journalPath << "\n";
+            return 1;
         }
     }
     
-    cout << "Enter Phone Number: ";
-    cin.getline(newPassenger.phone, 15);
-    
-    newPassenger.totalBookings = 0;
-    newPassenger.totalSpent = 0.0;
-    
-    passengers[passengerCount] = newPassenger;
-    passengerCount++;
-    
-    cout << "\nRegistration successful!\n";
-    cout << "\n=== REGISTRATION DETAILS ===\n";
-    cout << "Passenger ID: " << newPassenger.id << "\n";
-    cout << "Name: " << newPassenger.name << "\n";
-    cout << "Email: " << newPassenger.email << "\n";
-    cout << "Phone: " << newPassenger.phone << "\n";
-    cout << "\nIMPORTANT: Save your Passenger ID for login: " << newPassenger.id << "\n";
+    sessionOutput = printSessionOutput;
+    startSessionWorkers(threads);
+    startCompletionSweep();
+    string line;
+    while (readLine(line)) {
+        size_t tab = line.find('\t');
+        if (tab == string::npos) continue;
+        string command = line.substr(0, tab);
+        int value;
+        if (command == "open" && parseNumberField(line.substr(tab + 1), value)) {
+            openBookingSession(value);
+        }
+        else if (command == "close" && parseNumberField(line.substr(tab + 1), value)) {
+            if (!closeSession(value)) printSessionOutput(value, "No such session!\n");
+        }
+        else if (parseNumberField(command, value)) {
+            if (!deliverSessionInput(value, line.substr(tab + 1))) printSessionOutput(value, "No such session!\n");
+        }
+    }
+    // Let the last answers be handled before the sessions still open are closed
+    waitForIdleSessions();
+    stopSessionWorkers();
+    stopCompletionSweep();
+    if (journalPath) {
+        tracing = false;
+        traceFile.close();
+    }
+    return 0;
 }
 
-// ========== MAIN MENU ==========
+// Shrinks every flight with seats on hold to the seats already sold or held,
+// the edit a scheduler makes when an aircraft is swapped mid-sale. Returns the
+// number of flights changed, or -1 if the batch was rejected.
+int shrinkFlightsOnHold() {
+    vector<FlightUpdate> updates;
+    {
+        lock_guard<mutex> lock(storeMutex);
+        for (int i = 0; i < flightCount; i++) {
+            const Flight& flight = flights[i];
+            int held = 0;
+            for (int c = 0; c < CABIN_COUNT; c++) held += flightHeldSeats[i][c];
+            if (flight.deleted || held == 0) continue;
+            FlightUpdate update = {};
+            update.flightNo = flight.flightNo;
+            update.fields = UPDATE_SEATS;
+            for (int c = 0; c < CABIN_COUNT; c++) update.classSeats[c] = flightHeldSeats[i][c];
+            for (int b = flight.firstBooking; b != -1; b = bookings[b].nextOnFlight) {
+                if (occupiesSeats(bookings[b])) {
+                    update.classSeats[bookings[b].cabin] += bookings[b].seatsBooked;
+                }
+            }
+            updates.push_back(update);
+        }
+    }
+    string error;
+    if (!applyFlightUpdates(updates.data(), updates.size(), error)) {
+        cerr << error << "\n";
+        return -1;
+    }
+    return updates.size();
+}
 
-void mainMenu() {
-    int choice;
+// Usage: --session-load [--sessions N] [--threads N] [--hold-ms N] [--seed N]
+// Opens N booking sessions at once on a synthetic schedule and answers them
+// round by round: most confirm, some decline and some walk away once their
+// seats are held, so their holds have to run out. While the holds are open
+// every held flight is cut down to its sold and held seats. Prints one JSON
+// line; a run passes when no flight is oversold and no seats are left on hold.
+int runSessionLoad(int argc, char* argv[]) {
+    long long sessionTotal = 10000;
+    int threads = 2;
+    unsigned seed = 42;
+    seatHoldMillis = 5000;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--sessions") == 0) sessionTotal = atoll(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) threads = max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--hold-ms") == 0) seatHoldMillis = max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--seed") == 0) seed = atoi(argv[i + 1]);
+    }
+    if (sessionTotal < 1 || sessionTotal > MAX_BOOKINGS) {
+        cerr << "Sessions must be between 1 and " << MAX_BOOKINGS << "\n";
+        return 1;
+    }
     
-    do {
-        cout << "\n=== AIRLINE RESERVATION SYSTEM ===\n";
-        cout << "1. Passenger Registration\n";
-        cout << "2. Passenger Login\n";
-        cout << "3. Admin Login\n";
-        cout << "4. Exit System\n";
-        cout << "\nEnter your choice (1-4): ";
-        
-        cin >> choice;
-        
-        switch(choice) {
-            case 1: PassengerRegistration(); break;
-            case 2: passengerLogin(); break;
-            case 3: adminLoginPanel(); break;
-            case 4: cout << "Thank you for using the system!\n"; break;
-            default: cout << "Invalid choice! Please try again.\n";
+    mt19937 rng(seed);
+    generateSyntheticSchedule(sessionTotal * 2, rng);
+    vector<int> flightNos;
+    for (int i = 0; i < flightCount; i++) {
+        if (isOpenForBooking(flights[i])) flightNos.push_back(flights[i].flightNo);
+    }
+    Date travel = civilFromDays(todayDayNumber() + 30);
+    string travelDate = to_string(travel.day) + " " + to_string(travel.month) + " " + to_string(travel.year);
+    
+    startSessionWorkers(threads);
+    auto start = chrono::steady_clock::now();
+    vector<int> ids(sessionTotal);
+    for (long long s = 0; s < sessionTotal; s++) {
+        ids[s] = openBookingSession(1001 + rng() % passengerCount);
+    }
+    size_t openAtOnce = peakOpenSessions;
+    
+    // Every session gets its next answer before any gets the one after
+    vector<vector<string>> answers(sessionTotal);
+    for (long long s = 0; s < sessionTotal; s++) {
+        int roll = rng() % 100;
+        answers[s] = {to_string(flightNos[rng() % flightNos.size()]), to_string(1 + rng() % 2),
+                      to_string(rng() % 10 < 7 ? CABIN_ECONOMY + 1 : 1 + rng() % CABIN_COUNT)};
+        if (roll < 95) answers[s].push_back(travelDate);
+        if (roll < 90) answers[s].push_back("Y");
+        else if (roll < 95) answers[s].push_back("N");
+    }
+    int shrunk = 0;
+    for (size_t round = 0; round < 5; round++) {
+        for (long long s = 0; s < sessionTotal; s++) {
+            if (round < answers[s].size()) deliverSessionInput(ids[s], answers[s][round]);
+        }
+        waitForIdleSessions();
+        if (round == 2) shrunk = shrinkFlightsOnHold();   // seats are held after the class answer
+    }
+    waitForSessionsToEnd();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    stopSessionWorkers();
+    
+    int oversold = countOversoldFlights();
+    long long held;
+    {
+        lock_guard<mutex> lock(storeMutex);
+        held = seatsOnHold;
+        for (int i = 0; i < flightCount; i++) {
+            for (int c = 0; c < CABIN_COUNT; c++) held += flightHeldSeats[i][c];
         }
-    } while(choice != 4);
+    }
+    cout << "{\"check\":\"sessions\",\"sessions\":" << sessionTotal << ",\"threads\":" << threads
+         << ",\"open_at_once\":" << openAtOnce << ",\"flights_shrunk\":" << shrunk
+         << ",\"seconds\":" << fixed << setprecision(3) << seconds;
+    for (int o = 0; o < SESSION_OUTCOME_COUNT; o++) {
+        cout << ",\"" << SESSION_OUTCOME_NAMES[o] << "\":" << sessionOutcomes[o];
+    }
+    cout << ",\"oversold_flights\":" << oversold << ",\"seats_on_hold\":" << held << "}" << endl;
+    return oversold == 0 && held == 0 && shrunk >= 0 ? 0 : 2;
 }
 
 // ========== MAIN FUNCTION ==========
 
-int main() 
+int main(int argc, char* argv[]) 
 {
+    initRefundPolicies();
+    // The router holds no store; each worker it forks starts its own event consumer
+    if (argc > 1 && strcmp(argv[1], "--shard-router") == 0) {
+        return runShardRouter(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--ask") == 0) {
+        return runSocketClient(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--audit-verify") == 0) {
+        return runAuditVerify(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--audit-query") == 0) {
+        return runAuditQuery(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--archive-dump") == 0) {
+        return runArchiveDump(argc, argv);
+    }
     
-    mainMenu();
-    return 0;
-}
\ No newline at end of file
+    const char* mode = argc > 1 ? argv[1] : "";
+    if (strcmp(mode, "--bench") == 0 || strcmp(mode, "--loadgen") == 0 ||
+        strcmp(mode, "--replay") == 0 || strcmp(mode, "--replica") == 0 ||
+        strcmp(mode, "--session-load") == 0) {
+        auditLogPath.clear();   // synthetic or copied traffic is audited where it originated
+    }
+    startStoreEvents();
+    int status = 0;
+    if (strcmp(mode, "--bench") == 0) {
+        status = runBenchmarks(argc, argv);
+    }
+    else if (strcmp(mode, "--loadgen") == 0) {
+        status = runLoadGenerator(argc, argv);
+    }
+    else if (strcmp(mode, "--replay") == 0) {
+        status = runReplay(argc, argv);
+    }
+    else if (argc > 4 && strcmp(mode, "--shard-worker") == 0) {
+        status = runShardWorker(atoi(argv[2]), atoi(argv[3]), argv[4]);
+    }
+    else if (strcmp(mode, "--replica") == 0) {
+        status = runReplica(argc, argv);
+    }
+    else if (strcmp(mode, "--sessions") == 0) {
+        status = runSessionServer(argc, argv);
+    }
+    else if (strcmp(mode, "--session-load") == 0) {
+        status = runSessionLoad(argc, argv);
+    }
+    else {
+        runInteractive(argc, argv);
+    }
+    stopStoreEvents();
+    stopTaskScheduler();
+    return status;
+}